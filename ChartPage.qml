@@ -4,6 +4,14 @@ import QtQuick.Layouts
 import QtGraphs
 
 Item {
+    property bool viewport: false
+
+    //whole database counters or the aggregates of the last map viewport
+    function stat(key, whole)
+    {
+        return viewport ? (locationModel.viewportStats[key] ?? 0) : whole
+    }
+
     anchors.fill: parent
     RowLayout
     {
@@ -25,9 +33,9 @@ Item {
                 PieSlice
                 {
                     id: wifiSlice
-                    value: locationModel.wifiStats
+                    value: stat("wifi", locationModel.wifiStats)
                     label: "<h3>WIFI</h3>"
-                    labelVisible: (locationModel.wifiStats > 0)
+                    labelVisible: (stat("wifi", locationModel.wifiStats) > 0)
 
                     property HoverHandler hoverHandler: HoverHandler
                     {
@@ -43,51 +51,51 @@ Item {
                 PieSlice
                 {
                     id: btSlice
-                    value: locationModel.bluetoothStats
+                    value: stat("bluetooth", locationModel.bluetoothStats)
                     label: "<h3>Bluetooth</h3>"
-                    labelVisible: (locationModel.bluetoothStats > 0)
+                    labelVisible: (stat("bluetooth", locationModel.bluetoothStats) > 0)
                 }
                 PieSlice
                 {
                     id: btLESlice
-                    value: locationModel.bluetoothLEStats
+                    value: stat("bluetoothLE", locationModel.bluetoothLEStats)
                     label: "<h3>BluetoothLE</h3>"
-                    labelVisible: (locationModel.bluetoothLEStats > 0)
+                    labelVisible: (stat("bluetoothLE", locationModel.bluetoothLEStats) > 0)
                 }
                 PieSlice
                 {
                     id: gsmSlice
-                    value: locationModel.gsmStats
+                    value: stat("gsm", locationModel.gsmStats)
                     label: "<h3>GSM</h3>"
-                    labelVisible: (locationModel.gsmStats > 0)
+                    labelVisible: (stat("gsm", locationModel.gsmStats) > 0)
                 }
                 PieSlice
                 {
                     id: cdmaSlice
-                    value: locationModel.cdmaStats
+                    value: stat("cdma", locationModel.cdmaStats)
                     label: "<h3>CDMA</h3>"
-                    labelVisible: (locationModel.cdmaStats > 0)
+                    labelVisible: (stat("cdma", locationModel.cdmaStats) > 0)
                 }
                 PieSlice
                 {
                     id: wcdmaSlice
-                    value: locationModel.wcdmaStats
+                    value: stat("wcdma", locationModel.wcdmaStats)
                     label: "<h3>WCDMA</h3>"
-                    labelVisible: (locationModel.wcdmaStats > 0)
+                    labelVisible: (stat("wcdma", locationModel.wcdmaStats) > 0)
                 }
                 PieSlice
                 {
                     id: nrSlice
-                    value: locationModel.nrStats
+                    value: stat("nr", locationModel.nrStats)
                     label: "<h3>5G</h3>"
-                    labelVisible: (locationModel.nrStats > 0)
+                    labelVisible: (stat("nr", locationModel.nrStats) > 0)
                 }
                 PieSlice
                 {
                     id: lteSlice
-                    value: locationModel.lteStats
+                    value: stat("lte", locationModel.lteStats)
                     label: "<h3>4G LTE</h3>"
-                    labelVisible: (locationModel.lteStats > 0)
+                    labelVisible: (stat("lte", locationModel.lteStats) > 0)
                 }
             }
         }
@@ -114,14 +122,21 @@ Item {
                     horizontalAlignment: Text.AlignHCenter
                     color: "#ffffff"
                 }
+                Switch
+                {
+                    Layout.alignment: Qt.AlignTop | Qt.AlignHCenter
+                    text: "Current viewport"
+                    checked: viewport
+                    onToggled: viewport = checked
+                }
                 Text
                 {
                     Layout.topMargin: 12
                     Layout.alignment: Qt.AlignTop
                     Layout.leftMargin: 12
                     Layout.fillWidth: true
-                    text:"<h3>WiFi Locations: </h3>" + locationModel.wifiStats
-                    visible: (locationModel.wifiStats > 0)
+                    text:"<h3>WiFi Locations: </h3>" + stat("wifi", locationModel.wifiStats)
+                    visible: (stat("wifi", locationModel.wifiStats) > 0)
                     color: "#ffffff"
                 }
                 Text
@@ -130,8 +145,8 @@ Item {
                     Layout.alignment: Qt.AlignTop
                     Layout.leftMargin: 12
                     Layout.fillWidth: true
-                    text:"<h3>Bluetooth Locations: </h3>" + locationModel.bluetoothStats
-                    visible: (locationModel.bluetoothStats > 0)
+                    text:"<h3>Bluetooth Locations: </h3>" + stat("bluetooth", locationModel.bluetoothStats)
+                    visible: (stat("bluetooth", locationModel.bluetoothStats) > 0)
                     color: "#ffffff"
                 }
                 Text
@@ -140,8 +155,8 @@ Item {
                     Layout.alignment: Qt.AlignTop
                     Layout.leftMargin: 12
                     Layout.fillWidth: true
-                    text:"<h3>BluetoothLE Locations: </h3>" + locationModel.bluetoothLEStats
-                    visible: (locationModel.bluetoothLEStats > 0)
+                    text:"<h3>BluetoothLE Locations: </h3>" + stat("bluetoothLE", locationModel.bluetoothLEStats)
+                    visible: (stat("bluetoothLE", locationModel.bluetoothLEStats) > 0)
                     color: "#ffffff"
                 }
                 Text
@@ -150,8 +165,8 @@ Item {
                     Layout.alignment: Qt.AlignTop
                     Layout.leftMargin: 12
                     Layout.fillWidth: true
-                    text:"<h3>GSM Locations: </h3>" + locationModel.gsmStats
-                    visible: (locationModel.gsmStats > 0)
+                    text:"<h3>GSM Locations: </h3>" + stat("gsm", locationModel.gsmStats)
+                    visible: (stat("gsm", locationModel.gsmStats) > 0)
                     color: "#ffffff"
                 }
                 Text
@@ -160,8 +175,8 @@ Item {
                     Layout.alignment: Qt.AlignTop
                     Layout.leftMargin: 12
                     Layout.fillWidth: true
-                    text:"<h3>CDMA Locations: </h3>" + locationModel.cdmaStats
-                    visible: (locationModel.cdmaStats > 0)
+                    text:"<h3>CDMA Locations: </h3>" + stat("cdma", locationModel.cdmaStats)
+                    visible: (stat("cdma", locationModel.cdmaStats) > 0)
                     color: "#ffffff"
                 }
                 Text
@@ -170,8 +185,8 @@ Item {
                     Layout.alignment: Qt.AlignTop
                     Layout.leftMargin: 12
                     Layout.fillWidth: true
-                    text:"<h3>WCDMA Locations: </h3>" + locationModel.wcdmaStats
-                    visible: (locationModel.wcdmaStats > 0)
+                    text:"<h3>WCDMA Locations: </h3>" + stat("wcdma", locationModel.wcdmaStats)
+                    visible: (stat("wcdma", locationModel.wcdmaStats) > 0)
                     color: "#ffffff"
                 }
                 Text
@@ -180,8 +195,8 @@ Item {
                     Layout.alignment: Qt.AlignTop
                     Layout.leftMargin: 12
                     Layout.fillWidth: true
-                    text:"<h3>4G LTE Locations: </h3>" + locationModel.lteStats
-                    visible: (locationModel.lteStats > 0)
+                    text:"<h3>4G LTE Locations: </h3>" + stat("lte", locationModel.lteStats)
+                    visible: (stat("lte", locationModel.lteStats) > 0)
                     color: "#ffffff"
                 }
                 Text
@@ -190,8 +205,8 @@ Item {
                     Layout.alignment: Qt.AlignTop
                     Layout.leftMargin: 12
                     Layout.fillWidth: true
-                    text:"<h3>5G Locations: </h3>" + locationModel.nrStats
-                    visible: (locationModel.nrStats > 0)
+                    text:"<h3>5G Locations: </h3>" + stat("nr", locationModel.nrStats)
+                    visible: (stat("nr", locationModel.nrStats) > 0)
                     color: "#ffffff"
                 }
                 Text
@@ -163,7 +163,7 @@ Item {
 
                         ToolTip.visible: hovered
                         ToolTip.delay: 100
-                        ToolTip.text: "Import File"
+                        ToolTip.text: "Import Files (hold for a folder)"
 
                         onClicked:
                         {
@@ -172,6 +172,14 @@ Item {
 
                             menuBox.state = "";
                         }
+
+                        onPressAndHold:
+                        {
+                            if(!folderDialog.visible)
+                                folderDialog.open();
+
+                            menuBox.state = "";
+                        }
                         opacity: 0
 
                         transitions: Transition {
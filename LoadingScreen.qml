@@ -5,7 +5,13 @@ import QtQuick.Effects
 
 Item
 {
-    anchors.fill: parent
+    //a strip along the bottom instead of the whole page, for operations that leave the map usable
+    property bool compact: false
+
+    anchors.left: parent.left
+    anchors.right: parent.right
+    anchors.bottom: parent.bottom
+    height: compact ? Math.min(parent.height, 240) : parent.height
 
     Rectangle
     {
@@ -67,6 +73,63 @@ Item
                 }
             }
         }
+
+        Text
+        {
+            id: metricsText
+            anchors.top: loadingProgress.bottom
+            anchors.topMargin: 12
+            anchors.horizontalCenter: parent.horizontalCenter
+
+            property var metrics: locationModel.metrics
+
+            visible: metrics.active
+            color: "black"
+            horizontalAlignment: Text.AlignHCenter
+
+            function duration(seconds)
+            {
+                if(seconds < 0)
+                    return "--"
+
+                var minutes = Math.floor(seconds / 60)
+                var remainder = Math.round(seconds % 60)
+
+                return minutes + ":" + (remainder < 10 ? "0" : "") + remainder
+            }
+
+            text: Math.round(metrics.rowsPerSecond).toLocaleString(Qt.locale(), 'f', 0) + " rows/s  ·  "
+                  + (metrics.bytesPerSecond / 1048576).toFixed(1) + " MB/s  ·  "
+                  + (metrics.duplicateRate * 100).toFixed(1) + "% duplicates  ·  "
+                  + "queue " + metrics.writerQueue + "  ·  "
+                  + (metrics.residentBytes / 1048576).toFixed(0) + " MB resident  ·  "
+                  + "ETA " + duration(metrics.eta)
+        }
+
+        //per file progress of multi file imports
+        Column
+        {
+            id: importFiles
+            anchors.top: metricsText.bottom
+            anchors.topMargin: 12
+            anchors.horizontalCenter: parent.horizontalCenter
+
+            visible: metricsText.visible && locationModel.importProgress.length > 1
+            spacing: 2
+
+            Repeater
+            {
+                model: locationModel.importProgress
+
+                Text
+                {
+                    color: modelData.state === "failed" ? "darkred" : "black"
+                    text: modelData.fileName + "  ·  "
+                          + (modelData.state === "failed" ? modelData.error : Math.round(modelData.progress * 100) + "%")
+                          + "  ·  " + modelData.rows.toLocaleString(Qt.locale(), 'f', 0) + " rows"
+                }
+            }
+        }
     }
 
     states:
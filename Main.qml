@@ -6,6 +6,7 @@ import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
 import QtQuick.Dialogs
+import QtPositioning
 
 Item {
     property bool changing: false;
@@ -57,11 +58,38 @@ Item {
             {
                 id: fileDialog
                 currentFolder: StandardPaths.standardLocations(StandardPaths.HomeLocation)[0]
-                nameFilters: ["WiGLE KML files (*.kml)", "WiGLE CSV files (*.csv)"]
+                fileMode: FileDialog.OpenFiles
+                nameFilters: ["WiGLE files (*.kml *.csv)", "WiGLE KML files (*.kml)", "WiGLE CSV files (*.csv)"]
 
                 onAccepted:
                 {
-                    locationModel.openFile(selectedFile)
+                    locationModel.openFiles(selectedFiles)
+                }
+
+                onRejected:
+                {
+                    places.state = ""
+                    loading.visible = false
+                }
+
+                onVisibleChanged:
+                {
+                    if(visible)
+                    {
+                        places.state = "blocked"
+                    }
+                }
+            }
+
+            //every CSV and KML file below the folder is imported in one pass
+            FolderDialog
+            {
+                id: folderDialog
+                currentFolder: StandardPaths.standardLocations(StandardPaths.HomeLocation)[0]
+
+                onAccepted:
+                {
+                    locationModel.openDirectory(selectedFolder)
                 }
 
                 onRejected:
@@ -89,7 +117,9 @@ Item {
                 target: locationModel
 
                 function onLoadingStarted() {
-                    places.state = "blocked"
+                    //imports fill the map in as they run, so it stays usable
+                    places.state = locationModel.importing ? "" : "blocked"
+                    loading.compact = locationModel.importing
                     loading.visible = true
                 }
 
@@ -126,10 +156,18 @@ Item {
         id: settings
         property string iconTheme: "win11"
         property string database: "default";
+        property double latitude: 59.93
+        property double longitude: 10.76
+        property int tileCacheBudget: 32
+        property int memoryBudget: 0
     }
 
     Component.onCompleted: {
-        locationModel.load(settings.database)
+        locationModel.tileCacheBudget = settings.tileCacheBudget
+        locationModel.memoryBudget = settings.memoryBudget
+
+        //the area around the last viewport is loaded first, the rest streams in behind the map
+        locationModel.load(settings.database, QtPositioning.coordinate(settings.latitude, settings.longitude))
     }
 
     Connections
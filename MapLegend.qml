@@ -16,7 +16,7 @@ Item {
         id: legendPanel
 
         width: 320
-        height: 100
+        height: 140
         anchors.right: parent.right
         anchors.bottom: parent.bottom
         anchors.rightMargin: 12
@@ -159,7 +159,7 @@ Item {
                         Text
                         {
                             anchors.right: parent.right
-                            text: locationModel.totalPointsOfInterest
+                            text: locationModel.totalPointsOfInterest + " (" + (locationModel.viewportStats.total ?? 0) + " in view)"
                             color: "white"
                             height: 24
                             verticalAlignment: Text.AlignVCenter
@@ -424,6 +424,46 @@ Item {
                     }
                 }
             }
+            RowLayout
+            {
+                Layout.fillHeight: false;
+                Layout.fillWidth: true;
+                Layout.preferredHeight: 30
+                Layout.maximumHeight: 30
+                Layout.rightMargin: 12
+                Layout.leftMargin: 12
+                Layout.bottomMargin: 12
+                spacing: 6
+
+                //filters apply to the clustered map
+                CheckBox
+                {
+                    text: "WiFi"
+                    checked: locationModel.showWifi
+                    onToggled: locationModel.showWifi = checked
+                }
+
+                CheckBox
+                {
+                    text: "BT"
+                    checked: locationModel.showBluetooth
+                    onToggled: locationModel.showBluetooth = checked
+                }
+
+                CheckBox
+                {
+                    text: "Cell"
+                    checked: locationModel.showCellular
+                    onToggled: locationModel.showCellular = checked
+                }
+
+                CheckBox
+                {
+                    text: "Open only"
+                    checked: locationModel.openOnly
+                    onToggled: locationModel.openOnly = checked
+                }
+            }
         }
     }
 }
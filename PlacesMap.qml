@@ -10,6 +10,7 @@ import QtQuick.Effects
 import QtCore
 import QtPositioning
 import QtLocation
+import wdrvr
 //! [Imports]
 
 Item
@@ -94,11 +95,15 @@ Item
             {
                 settings.zoomLevel = view.map.zoomLevel
                 locationModel.getPointsInRect(view.map.visibleRegion, view.map.zoomLevel / view.map.maximumZoomLevel);
+                locationModel.updateViewportStats(view.map.visibleRegion)
             }
 
             map.onActiveMapTypeChanged: settings.mapType = map.supportedMapTypes.indexOf(map.activeMapType)
 
             map.onCenterChanged: {
+                //the aggregates are cheap enough for every frame of a pan
+                locationModel.updateViewportStats(view.map.visibleRegion)
+
                 var distance = lastPosition.distanceTo(view.map.center)
                 if (distance > (500 *(1 - (map.zoomLevel / map.maximumZoomLevel)))) {
                     lastPosition = view.map.center
@@ -108,103 +113,199 @@ Item
                 }
             }
 
-            MapItemView
+            HeatmapLayer
             {
+                parent: view.map
+                anchors.fill: parent
+                map: view.map
                 model: locationModel
+                visible: settings.heatmap
+                weighted: settings.heatmapWeighted
+            }
+
+            PointLayer
+            {
+                id: pointLayer
                 parent: view.map
+                anchors.fill: parent
+                map: view.map
+                model: locationModel
 
-                // MouseArea
-                // {
-                //     anchors.fill: parent
-                //     property variant startCoordinate
-                //     property bool panning: false
-
-                //     onPositionChanged:
-                //     {
-                //         var distance = positionSource.lastSearchPosition.distanceTo(view.map.center)
-                //         if (distance > 100) {
-                //             // 500m from last performed food search
-                //             positionSource.lastSearchPosition = view.map.center
-                //             locationModel.getPointsInRect(view.map.visibleRegion, view.map.zoomLevel / view.map.maximumZoomLevel);
-                //             settings.latitude = view.map.center.latitude
-                //             settings.longitude = view.map.center.longitude
-                //         }
-                //     }
-                // }
-                delegate: MapQuickItem
+                ToolTip
                 {
-                    coordinate: QtPositioning.coordinate(location.latitude, location.longitude)
+                    x: pointLayer.hoveredPosition.x + 12
+                    y: pointLayer.hoveredPosition.y + 12
+                    visible: pointLayer.hoveredRow >= 0
+                    delay: 100
+                    text: pointLayer.hoveredText
+                }
+            }
+        }
 
-                    anchorPoint.x: marker.width * 0.5
-                    anchorPoint.y: marker.height
+        //! [Places MapItemView]
 
-                    sourceItem: Rectangle
+        //! [Search]
+        Rectangle
+        {
+            id: searchBox
+            z: 11
+            width: 320
+            height: searchField.height + (searchResults.count > 0 ? searchResults.height + 12 : 0) + 12
+            anchors.top: parent.top
+            anchors.right: parent.right
+            anchors.topMargin: 12
+            anchors.rightMargin: 12
+            radius: 12
+            color: "#88000000"
+
+            TextField
+            {
+                id: searchField
+                anchors.top: parent.top
+                anchors.left: parent.left
+                anchors.right: parent.right
+                anchors.margins: 6
+                placeholderText: "Search SSID or device"
+
+                //wait for a pause in typing, the search itself runs in the background
+                onTextEdited: searchTimer.restart()
+            }
+
+            Timer
+            {
+                id: searchTimer
+                interval: 250
+                onTriggered: locationModel.search(searchField.text, 20)
+            }
+
+            Connections
+            {
+                target: locationModel
+
+                function onSearchFinished(query, results)
+                {
+                    if(query === searchField.text)
+                        searchResults.model = results
+                }
+            }
+
+            ListView
+            {
+                id: searchResults
+                anchors.top: searchField.bottom
+                anchors.left: parent.left
+                anchors.right: parent.right
+                anchors.margins: 6
+                height: Math.min(contentHeight, 240)
+                clip: true
+
+                delegate: ItemDelegate
+                {
+                    width: searchResults.width
+                    text: (modelData.name.length > 0 ? modelData.name : "<hidden>") + "  " + modelData.id
+
+                    //jump to the match
+                    onClicked:
                     {
-                        Rectangle
-                        {
-                            id: marker
-                            radius: (10 * (map.zoomLevel / 2)) / 2
-                            width: 10 * (map.zoomLevel / 2)
-                            height: 10 * (map.zoomLevel / 2)
-                            color: "transparent"
-                        }
+                        view.map.center = modelData.coordinate
+                        view.map.zoomLevel = Math.max(view.map.zoomLevel, 16)
+                        searchResults.model = []
+                    }
+                }
+            }
+        }
+        //! [Search]
 
-                        Image
-                        {
-                            id: image
-                            anchors.horizontalCenter: marker.horizontalCenter
-                            anchors.verticalCenter: marker.verticalCenter
-                            source: "icons/win11/scalable/place-marker.svg"
-
-                            ToolTip.visible: mouseArea.containsMouse
-                            ToolTip.delay: 100
-                            ToolTip.text: description
-
-                            MouseArea
-                            {
-                               id: mouseArea
-                               anchors.fill: parent
-                               hoverEnabled: true
-                            }
-
-                            // states:
-                            // [
-                            //     State
-                            //     {
-                            //         when: style === '#highConfidence'
-                            //         PropertyChanges {
-                            //             //marker.source: ""
-                            //         }
-                            //     },
-                            //     State
-                            //     {
-                            //         when: type === 'wifi'
-                            //         PropertyChanges {
-                            //             marker.source: 'icons/wifi.png'
-                            //         }
-                            //     }
-
-                            // ]
-                        }
+        //! [Timeline]
+        Rectangle
+        {
+            id: timelineBox
+            z: 11
+            width: 480
+            height: 96
+            anchors.left: parent.left
+            anchors.bottom: parent.bottom
+            anchors.leftMargin: 12
+            anchors.bottomMargin: 12
+            radius: 12
+            color: "#88000000"
+            visible: locationModel.timelineEnd > locationModel.timelineStart
+
+            ColumnLayout
+            {
+                anchors.fill: parent
+                anchors.margins: 6
 
-                        Text
+                RangeSlider
+                {
+                    id: timelineSlider
+                    Layout.fillWidth: true
+                    from: locationModel.timelineStart
+                    to: locationModel.timelineEnd
+                    first.value: locationModel.timelineStart
+                    second.value: locationModel.timelineEnd
+                    enabled: !locationModel.replaying
+
+                    first.onMoved: timelineDelay.restart()
+                    second.onMoved: timelineDelay.restart()
+                }
+
+                RowLayout
+                {
+                    Layout.fillWidth: true
+
+                    Button
+                    {
+                        text: locationModel.replaying ? "Stop" : "Replay"
+                        onClicked:
                         {
-                            text: name
-                            font.bold: true
-                            anchors.leftMargin: name.width * 0.5
-                            anchors.horizontalCenter: marker.horizontalCenter
-                            anchors.top: marker.bottom
+                            if(locationModel.replaying)
+                                locationModel.stopReplay()
+                            else
+                                locationModel.startReplay(timelineSlider.first.value, timelineSlider.second.value)
                         }
                     }
+
+                    Text
+                    {
+                        Layout.fillWidth: true
+                        color: "white"
+                        elide: Text.ElideRight
+                        text: locationModel.replaying ? new Date(locationModel.replayPosition).toLocaleString() :
+                                                        new Date(timelineSlider.first.value).toLocaleString() + " - " + new Date(timelineSlider.second.value).toLocaleString()
+                    }
                 }
             }
-        }
 
-        //! [Places MapItemView]
+            //scrubbing shouldn't query on every pixel
+            Timer
+            {
+                id: timelineDelay
+                interval: 150
+
+                onTriggered:
+                {
+                    var from = timelineSlider.first.value <= locationModel.timelineStart ? 0 : timelineSlider.first.value
+                    var to = timelineSlider.second.value >= locationModel.timelineEnd ? 0 : timelineSlider.second.value
+                    locationModel.setTimeWindow(from, to)
+                }
+            }
+        }
+        //! [Timeline]
     }
 
     Connections {
         target: locationModel
+        function onSectorsUpdated() {
+            locationModel.getPointsInRect(view.map.visibleRegion, view.map.zoomLevel / view.map.maximumZoomLevel);
+        }
+        function onFilterChanged() {
+            locationModel.getPointsInRect(view.map.visibleRegion, view.map.zoomLevel / view.map.maximumZoomLevel);
+        }
+        function onReplayingChanged() {
+            if(!locationModel.replaying)
+                locationModel.getPointsInRect(view.map.visibleRegion, view.map.zoomLevel / view.map.maximumZoomLevel);
+        }
         function onDataChanged() {
             console.log("Updated")
             update();
@@ -248,6 +349,8 @@ Item
         property string osmApiKey;
         property string iconTheme;
         property bool highDPIMapTiles;
+        property bool heatmap;
+        property bool heatmapWeighted;
         property int mapType;
         property string database: "default";
         property double latitude: 59.93
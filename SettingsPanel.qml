@@ -1,7 +1,9 @@
 import QtQuick
 import QtQuick.Layouts
 import QtQuick.Controls
+import QtQuick.Dialogs
 import QtCore
+import QtPositioning
 
 Item
 {
@@ -13,8 +15,14 @@ Item
         property string osmApiKey;
         property string iconTheme;
         property bool highDPIMapTiles;
+        property bool heatmap;
+        property bool heatmapWeighted;
         property int mapType;
         property string database: "default";
+        property double latitude: 59.93
+        property double longitude: 10.76
+        property int tileCacheBudget: 32
+        property int memoryBudget: 0
     }
 
     Rectangle
@@ -78,7 +86,63 @@ Item
 
                         settings.database = locationModel.availableDatabases[databaseSelector.currentIndex]
                         locationModel.database = settings.database
-                        locationModel.load(settings.database)
+                        locationModel.load(settings.database, QtPositioning.coordinate(settings.latitude, settings.longitude))
+                    }
+                }
+
+                //shown on the map together with the loaded database
+                Button
+                {
+                    Layout.preferredHeight: 35
+                    icon.name: "check"
+                    icon.width: 24
+                    icon.height: 24
+                    Layout.rightMargin: 6
+
+                    ToolTip.visible: hovered
+                    ToolTip.delay: 100
+                    ToolTip.text: "Attach"
+
+                    enabled: locationModel.availableDatabases[databaseSelector.currentIndex] !== locationModel.loadedDatabase
+
+                    onClicked: {
+                        locationModel.attach(locationModel.availableDatabases[databaseSelector.currentIndex])
+                    }
+                }
+            }
+
+            Repeater
+            {
+                model: locationModel.attachedDatabases
+
+                RowLayout
+                {
+                    Layout.alignment: Qt.AlignTop
+                    Layout.fillWidth: true
+                    Layout.fillHeight: false
+
+                    Text {
+                        Layout.fillWidth: true
+                        Layout.leftMargin: 24
+                        text: qsTr("Attached: %1").arg(modelData)
+                        color: "white"
+                    }
+
+                    Button
+                    {
+                        Layout.preferredHeight: 30
+                        icon.name: "cancel"
+                        icon.width: 20
+                        icon.height: 20
+                        Layout.rightMargin: 6
+
+                        ToolTip.visible: hovered
+                        ToolTip.delay: 100
+                        ToolTip.text: "Detach"
+
+                        onClicked: {
+                            locationModel.detach(modelData)
+                        }
                     }
                 }
             }
@@ -166,6 +230,212 @@ Item
                 }
             }
 
+            RowLayout
+            {
+                Layout.alignment: Qt.AlignTop
+                Layout.fillWidth: true
+                Layout.fillHeight: false
+
+                Text {
+                    Layout.fillWidth: true
+                    Layout.leftMargin: 12
+                    Layout.topMargin: 12
+                    text: qsTr("<h3>Density Heatmap</h3>")
+                    color: "white"
+                }
+
+                Switch
+                {
+                    Layout.alignment: Qt.AlignRight
+                    height: 50
+                    width: 50
+                    checked: settings.heatmap
+                    onCheckedChanged: settings.heatmap = checked
+                }
+            }
+
+            RowLayout
+            {
+                Layout.alignment: Qt.AlignTop
+                Layout.fillWidth: true
+                Layout.fillHeight: false
+
+                Text {
+                    Layout.fillWidth: true
+                    Layout.leftMargin: 12
+                    Layout.topMargin: 12
+                    text: qsTr("<h3>Weight Heatmap By Signal</h3>")
+                    color: "white"
+                }
+
+                Switch
+                {
+                    Layout.alignment: Qt.AlignRight
+                    height: 50
+                    width: 50
+                    enabled: settings.heatmap
+                    checked: settings.heatmapWeighted
+                    onCheckedChanged: settings.heatmapWeighted = checked
+                }
+            }
+
+            RowLayout
+            {
+                Layout.alignment: Qt.AlignTop
+                Layout.fillWidth: true
+                Layout.fillHeight: false
+
+                Text {
+                    Layout.fillWidth: true
+                    Layout.leftMargin: 12
+                    Layout.topMargin: 12
+                    text: qsTr("<h3>Tile Cache (MB)</h3>")
+                    color: "white"
+                }
+
+                SpinBox
+                {
+                    Layout.alignment: Qt.AlignRight
+                    Layout.rightMargin: 6
+                    from: 0
+                    to: 1024
+                    stepSize: 8
+                    editable: true
+                    value: settings.tileCacheBudget
+
+                    onValueModified:
+                    {
+                        settings.tileCacheBudget = value
+                        locationModel.tileCacheBudget = value
+                    }
+                }
+            }
+
+            RowLayout
+            {
+                Layout.alignment: Qt.AlignTop
+                Layout.fillWidth: true
+                Layout.fillHeight: false
+
+                ColumnLayout
+                {
+                    Layout.fillWidth: true
+                    Layout.leftMargin: 12
+                    Layout.topMargin: 12
+
+                    Text {
+                        Layout.fillWidth: true
+                        text: qsTr("<h3>Memory Budget (MB)</h3>")
+                        color: "white"
+                    }
+
+                    //what the sectors hold right now, idle ones are evicted once it goes over the budget
+                    Text {
+                        Layout.fillWidth: true
+                        text: locationModel.memoryBudget > 0 ?
+                                  qsTr("%1 MB of %2 MB in use").arg((locationModel.memoryUsage / 1048576).toFixed(1)).arg(locationModel.memoryBudget) :
+                                  qsTr("%1 MB in use, no limit").arg((locationModel.memoryUsage / 1048576).toFixed(1))
+                        color: "white"
+                        opacity: 0.7
+                    }
+                }
+
+                SpinBox
+                {
+                    Layout.alignment: Qt.AlignRight
+                    Layout.rightMargin: 6
+                    from: 0
+                    to: 262144
+                    stepSize: 256
+                    editable: true
+                    value: settings.memoryBudget
+
+                    onValueModified:
+                    {
+                        settings.memoryBudget = value
+                        locationModel.memoryBudget = value
+                    }
+                }
+            }
+
+            RowLayout
+            {
+                Layout.alignment: Qt.AlignTop
+                Layout.fillWidth: true
+                Layout.fillHeight: false
+
+                Text {
+                    Layout.fillWidth: true
+                    Layout.leftMargin: 12
+                    Layout.topMargin: 12
+                    text: qsTr("<h3>Record Trace</h3>")
+                    color: "white"
+                }
+
+                Button
+                {
+                    Layout.preferredHeight: 35
+                    Layout.rightMargin: 6
+                    text: "Save"
+                    enabled: locationModel.tracing
+
+                    onClicked: traceSavedText.text = locationModel.dumpTrace()
+                }
+
+                Switch
+                {
+                    Layout.alignment: Qt.AlignRight
+                    height: 50
+                    width: 50
+                    checked: locationModel.tracing
+                    onCheckedChanged: locationModel.tracing = checked
+                }
+            }
+
+            Text {
+                id: traceSavedText
+                Layout.fillWidth: true
+                Layout.leftMargin: 12
+                visible: text.length > 0
+                elide: Text.ElideMiddle
+                color: "white"
+            }
+
+            RowLayout
+            {
+                Layout.alignment: Qt.AlignTop
+                Layout.fillWidth: true
+                Layout.fillHeight: false
+
+                Text {
+                    Layout.fillWidth: true
+                    Layout.leftMargin: 12
+                    Layout.topMargin: 12
+                    text: qsTr("<h3>Export</h3>")
+                    color: "white"
+                }
+
+                //only what the map shows, the filters inside the visible area
+                CheckBox
+                {
+                    id: exportViewportCheckBox
+                    text: "Viewport"
+                }
+
+                Button
+                {
+                    Layout.preferredHeight: 35
+                    Layout.rightMargin: 6
+                    text: "Export"
+
+                    onClicked:
+                    {
+                        if(!exportDialog.visible)
+                            exportDialog.open()
+                    }
+                }
+            }
+
             Rectangle { color:"transparent"; Layout.fillHeight: true; }
 
             Button
@@ -182,6 +452,20 @@ Item
         }
     }
 
+    //the format follows the extension, a trailing .gz compresses
+    FileDialog
+    {
+        id: exportDialog
+        currentFolder: StandardPaths.standardLocations(StandardPaths.HomeLocation)[0]
+        fileMode: FileDialog.SaveFile
+        nameFilters: ["WiGLE CSV files (*.csv *.csv.gz)", "KML files (*.kml *.kml.gz)", "GeoJSON files (*.geojson *.geojson.gz)"]
+
+        onAccepted:
+        {
+            locationModel.exportFile(selectedFile, exportViewportCheckBox.checked)
+        }
+    }
+
     Dialog
     {
         id: databaseNameDialog
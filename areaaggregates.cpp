@@ -0,0 +1,303 @@
+#include "areaaggregates.h"
+#include "locationmodel.h"
+
+#include <algorithm>
+#include <cmath>
+
+void AreaStats::add(const AreaStats &other, qreal weight)
+{
+    total += other.total * weight;
+
+    for(int radio = 0; radio < Radios; ++radio)
+        radios[radio] += other.radios[radio] * weight;
+
+    for(int encryptionClass = 0; encryptionClass < LocationFilter::EncryptionClasses; ++encryptionClass)
+        encryption[encryptionClass] += other.encryption[encryptionClass] * weight;
+
+    heat += other.heat * weight;
+}
+
+QVariantMap AreaStats::toVariantMap() const
+{
+    auto count = [](qreal value) { return QVariant::fromValue<quint64>(static_cast<quint64>(std::llround(value))); };
+
+    QVariantMap map;
+    map["total"] = count(total);
+    map["wifi"] = count(radios[Wifi]);
+    map["bluetooth"] = count(radios[Bluetooth]);
+    map["bluetoothLE"] = count(radios[BluetoothLE]);
+    map["gsm"] = count(radios[Gsm]);
+    map["cdma"] = count(radios[Cdma]);
+    map["wcdma"] = count(radios[Wcdma]);
+    map["lte"] = count(radios[Lte]);
+    map["nr"] = count(radios[Nr]);
+    map["other"] = count(radios[OtherRadio]);
+    map["cellular"] = count(radios[Gsm] + radios[Cdma] + radios[Wcdma] + radios[Lte] + radios[Nr]);
+    map["open"] = count(encryption[LocationFilter::Open]);
+
+    for(int encryptionClass = 0; encryptionClass < LocationFilter::EncryptionClasses; ++encryptionClass)
+        map[LocationFilter::encryptionName(static_cast<LocationFilter::EncryptionClass>(encryptionClass))] = count(encryption[encryptionClass]);
+
+    return map;
+}
+
+AreaStats::Radio AreaStats::radio(const QString &type)
+{
+    static const QList<QPair<QLatin1String, Radio>> radios {
+        { QLatin1String("WIFI"), Wifi },
+        { QLatin1String("BT"), Bluetooth },
+        { QLatin1String("BLE"), BluetoothLE },
+        { QLatin1String("GSM"), Gsm },
+        { QLatin1String("CDMA"), Cdma },
+        { QLatin1String("WCDMA"), Wcdma },
+        { QLatin1String("LTE"), Lte },
+        { QLatin1String("NR"), Nr }
+    };
+
+    //KML exports leave the type out for wifi
+    if(type.isEmpty())
+        return Wifi;
+
+    for(const QPair<QLatin1String, Radio> &radio : radios)
+    {
+        if(type.compare(radio.first, Qt::CaseInsensitive) == 0)
+            return radio.second;
+    }
+
+    return OtherRadio;
+}
+
+AreaStats::Radio AreaAggregates::append(const LocationData &data)
+{
+    qreal longitude = data.coordinates.longitude();
+    qreal latitude = data.coordinates.latitude();
+    quint32 id = SectorDirectory::sectorId(SectorDirectory::column(longitude), SectorDirectory::row(latitude));
+
+    qreal cellSize = SectorDirectory::SectorSize / Subdivisions;
+    int column = std::clamp(static_cast<int>((longitude - SectorDirectory::longitudeOf(id)) / cellSize), 0, Subdivisions - 1);
+    int row = std::clamp(static_cast<int>((latitude - SectorDirectory::latitudeOf(id)) / cellSize), 0, Subdivisions - 1);
+
+    AreaStats::Radio radio = AreaStats::radio(data.type);
+    LocationFilter::EncryptionClass encryption = LocationFilter::encryptionClass(data.encryption);
+    float heat = HeatmapEngine::signalWeight(data.signal);
+
+    QWriteLocker locker(&m_lock);
+
+    SectorStats &sector = m_sectors[id];
+
+    for(AreaStats *stats : { &m_total, &sector.total, &sector.cells[(row * Subdivisions) + column] })
+    {
+        ++stats->total;
+        ++stats->radios[radio];
+        ++stats->encryption[encryption];
+        stats->heat += heat;
+    }
+
+    return radio;
+}
+
+void AreaAggregates::clear()
+{
+    QWriteLocker locker(&m_lock);
+
+    m_sectors.clear();
+    m_total = AreaStats();
+}
+
+AreaStats AreaAggregates::total() const
+{
+    QReadLocker locker(&m_lock);
+    return m_total;
+}
+
+//must be called with the lock held, west must not be east of east
+void AreaAggregates::addRect(AreaStats &stats, qreal west, qreal south, qreal east, qreal north) const
+{
+    int columnStart = SectorDirectory::column(west);
+    int columnEnd = SectorDirectory::column(east);
+    int rowStart = SectorDirectory::row(south);
+    int rowEnd = SectorDirectory::row(north);
+
+    qreal cellSize = SectorDirectory::SectorSize / Subdivisions;
+    qreal cellArea = cellSize * cellSize;
+
+    auto addSector = [&](quint32 id, const SectorStats &sector) {
+        qreal sectorWest = SectorDirectory::longitudeOf(id);
+        qreal sectorSouth = SectorDirectory::latitudeOf(id);
+
+        //whole sectors only need their totals
+        if(west <= sectorWest && east >= sectorWest + SectorDirectory::SectorSize && south <= sectorSouth && north >= sectorSouth + SectorDirectory::SectorSize)
+        {
+            stats.add(sector.total);
+            return;
+        }
+
+        for(int row = 0; row < Subdivisions; ++row)
+        {
+            qreal cellSouth = sectorSouth + (row * cellSize);
+            qreal height = std::min(north, cellSouth + cellSize) - std::max(south, cellSouth);
+
+            if(height <= 0)
+                continue;
+
+            for(int column = 0; column < Subdivisions; ++column)
+            {
+                const AreaStats &cell = sector.cells[(row * Subdivisions) + column];
+
+                if(cell.total == 0)
+                    continue;
+
+                qreal cellWest = sectorWest + (column * cellSize);
+                qreal width = std::min(east, cellWest + cellSize) - std::max(west, cellWest);
+
+                if(width > 0)
+                    stats.add(cell, std::min<qreal>((width * height) / cellArea, 1));
+            }
+        }
+    };
+
+    //walk whichever is smaller, the covered sector range or the occupied sectors
+    qint64 covered = static_cast<qint64>(columnEnd - columnStart + 1) * (rowEnd - rowStart + 1);
+
+    if(covered <= m_sectors.count())
+    {
+        for(int column = columnStart; column <= columnEnd; ++column)
+        {
+            for(int row = rowStart; row <= rowEnd; ++row)
+            {
+                quint32 id = SectorDirectory::sectorId(column, row);
+                auto sector = m_sectors.constFind(id);
+
+                if(sector != m_sectors.constEnd())
+                    addSector(id, sector.value());
+            }
+        }
+    }
+    else
+    {
+        for(auto sector = m_sectors.constBegin(); sector != m_sectors.constEnd(); ++sector)
+        {
+            int column = SectorDirectory::columnOf(sector.key());
+            int row = SectorDirectory::rowOf(sector.key());
+
+            if(column >= columnStart && column <= columnEnd && row >= rowStart && row <= rowEnd)
+                addSector(sector.key(), sector.value());
+        }
+    }
+}
+
+AreaStats AreaAggregates::statsInRect(const QGeoRectangle &rect) const
+{
+    AreaStats stats;
+
+    if(!rect.isValid())
+        return stats;
+
+    qreal west = rect.topLeft().longitude();
+    qreal east = rect.bottomRight().longitude();
+    qreal south = rect.bottomRight().latitude();
+    qreal north = rect.topLeft().latitude();
+
+    QReadLocker locker(&m_lock);
+
+    //rects crossing the dateline come in two halves
+    if(west > east)
+    {
+        addRect(stats, west, south, 180, north);
+        addRect(stats, -180, south, east, north);
+    }
+    else
+        addRect(stats, west, south, east, north);
+
+    return stats;
+}
+
+AreaStats AreaAggregates::statsInShape(const QGeoShape &shape) const
+{
+    if(shape.type() == QGeoShape::RectangleType)
+        return statsInRect(QGeoRectangle(shape));
+
+    AreaStats stats;
+
+    if(!shape.isValid())
+        return stats;
+
+    QGeoRectangle bounds = shape.boundingGeoRectangle();
+    qreal cellSize = SectorDirectory::SectorSize / Subdivisions;
+
+    QReadLocker locker(&m_lock);
+
+    for(auto sector = m_sectors.constBegin(); sector != m_sectors.constEnd(); ++sector)
+    {
+        qreal sectorWest = SectorDirectory::longitudeOf(sector.key());
+        qreal sectorSouth = SectorDirectory::latitudeOf(sector.key());
+
+        if(!bounds.intersects(QGeoRectangle(QGeoCoordinate(sectorSouth + SectorDirectory::SectorSize, sectorWest), QGeoCoordinate(sectorSouth, sectorWest + SectorDirectory::SectorSize))))
+            continue;
+
+        for(int row = 0; row < Subdivisions; ++row)
+        {
+            for(int column = 0; column < Subdivisions; ++column)
+            {
+                const AreaStats &cell = sector->cells[(row * Subdivisions) + column];
+
+                if(cell.total > 0 && shape.contains(QGeoCoordinate(sectorSouth + ((row + 0.5) * cellSize), sectorWest + ((column + 0.5) * cellSize))))
+                    stats.add(cell);
+            }
+        }
+    }
+
+    return stats;
+}
+
+QVector<AreaCell> AreaAggregates::cellsInRect(const QGeoRectangle &rect) const
+{
+    QVector<AreaCell> cells;
+
+    if(!rect.isValid())
+        return cells;
+
+    int columnStart = SectorDirectory::column(rect.topLeft().longitude());
+    int columnEnd = SectorDirectory::column(rect.bottomRight().longitude());
+    int rowStart = SectorDirectory::row(rect.bottomRight().latitude());
+    int rowEnd = SectorDirectory::row(rect.topLeft().latitude());
+
+    qreal cellSize = SectorDirectory::SectorSize / Subdivisions;
+
+    QReadLocker locker(&m_lock);
+
+    for(auto sector = m_sectors.constBegin(); sector != m_sectors.constEnd(); ++sector)
+    {
+        int column = SectorDirectory::columnOf(sector.key());
+        int row = SectorDirectory::rowOf(sector.key());
+
+        //rects crossing the dateline wrap the columns
+        bool inColumns = columnStart <= columnEnd ? column >= columnStart && column <= columnEnd : column >= columnStart || column <= columnEnd;
+
+        if(!inColumns || row < rowStart || row > rowEnd)
+            continue;
+
+        qreal sectorWest = SectorDirectory::longitudeOf(sector.key());
+        qreal sectorSouth = SectorDirectory::latitudeOf(sector.key());
+
+        for(int cellRow = 0; cellRow < Subdivisions; ++cellRow)
+        {
+            for(int cellColumn = 0; cellColumn < Subdivisions; ++cellColumn)
+            {
+                const AreaStats &stats = sector->cells[(cellRow * Subdivisions) + cellColumn];
+
+                if(stats.total == 0)
+                    continue;
+
+                AreaCell cell;
+                cell.latitude = sectorSouth + ((cellRow + 0.5) * cellSize);
+                cell.longitude = sectorWest + ((cellColumn + 0.5) * cellSize);
+                cell.total = stats.total;
+                cell.heat = stats.heat;
+                cells.append(cell);
+            }
+        }
+    }
+
+    return cells;
+}
@@ -0,0 +1,92 @@
+#ifndef AREAAGGREGATES_H
+#define AREAAGGREGATES_H
+
+#include <QGeoRectangle>
+#include <QGeoShape>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QVariantMap>
+#include <QVector>
+
+#include "sectorindex.h"
+
+struct LocationData;
+
+struct AreaStats
+{
+    enum Radio
+    {
+        Wifi = 0,
+        Bluetooth,
+        BluetoothLE,
+        Gsm,
+        Cdma,
+        Wcdma,
+        Lte,
+        Nr,
+        OtherRadio,
+        Radios
+    };
+
+    //fractional while an area only partly covers a cell
+    qreal total = 0;
+    qreal radios[Radios] = {};
+    qreal encryption[LocationFilter::EncryptionClasses] = {};
+    qreal heat = 0; //sum of the heatmap signal weights
+
+    void add(const AreaStats &other, qreal weight = 1);
+    QVariantMap toVariantMap() const;
+
+    static Radio radio(const QString &type);
+};
+
+//center of an aggregate cell and its counts
+struct AreaCell
+{
+    qreal latitude = 0;
+    qreal longitude = 0;
+    qreal total = 0;
+    qreal heat = 0;
+};
+
+/*
+ * Per cell aggregate counters
+ *
+ * Every sector keeps its totals plus a Subdivisions x Subdivisions grid of cell totals, counted once
+ * per POI as it is appended. An area is summarized from the totals of the sectors it covers and the
+ * cells along its edges, so the cost depends on the area's outline rather than on the POIs inside.
+ *
+ * Cells an area only partly covers are weighted by the covered fraction, which assumes the POIs are
+ * spread evenly inside a cell. Non rectangular shapes take the cells whose centers they contain.
+ */
+class AreaAggregates
+{
+public:
+    static constexpr int Subdivisions = 10;
+
+    //returns the radio the POI was counted as
+    AreaStats::Radio append(const LocationData &data);
+    void clear();
+
+    AreaStats total() const;
+    AreaStats statsInRect(const QGeoRectangle &rect) const;
+    AreaStats statsInShape(const QGeoShape &shape) const;
+
+    //the non empty cells of the sectors the rect touches
+    QVector<AreaCell> cellsInRect(const QGeoRectangle &rect) const;
+
+private:
+    struct SectorStats
+    {
+        AreaStats total;
+        AreaStats cells[Subdivisions * Subdivisions];
+    };
+
+    void addRect(AreaStats &stats, qreal west, qreal south, qreal east, qreal north) const;
+
+    mutable QReadWriteLock m_lock;
+    QHash<quint32, SectorStats> m_sectors;
+    AreaStats m_total;
+};
+
+#endif // AREAAGGREGATES_H
@@ -0,0 +1,386 @@
+#include "locationmodel.h"
+#include "syntheticdataset.h"
+
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <cmath>
+
+/*
+ * Hot path benchmarks
+ *
+ * Every benchmark runs once per dataset size. Sizes come from WDRVR_BENCH_SIZES as a comma separated
+ * list and default to 10000, the release comparison sizes are 10000,1000000,10000000. Datasets come
+ * from SyntheticDataset with a fixed seed so runs on different machines and releases see the same POIs,
+ * wdrvr_gen writes the same rows for reproducing a result outside the suite.
+ *
+ * QtTest writes machine readable results with its usual output options, for example
+ *
+ *   WDRVR_BENCH_SIZES=10000,1000000 wdrvr_bench -o results.xml,xml
+ *   wdrvr_bench -o results.csv,csv
+ *
+ * Databases are created in QStandardPaths' test locations so a run never touches real captures.
+ */
+class LocationModelBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void parseCSV_data();
+    void parseCSV();
+    void parseKML_data();
+    void parseKML();
+    void append_data();
+    void append();
+    void sort_data();
+    void sort();
+    void getPointsInRect_data();
+    void getPointsInRect();
+    void save_data();
+    void save();
+    void load_data();
+    void load();
+
+private:
+    static constexpr int OperationTimeout = 3600000; //ms, 10M rows take a while
+    static constexpr quint32 Seed = 0x77647276;
+
+    void addSizes();
+    static SyntheticDataset::Options options(int size);
+    const QVector<LocationData> &dataset(int size);
+    QString csvFile(int size);
+    QString kmlFile(int size);
+    QString database(int size);
+
+    static void wait(LocationModel &model);
+    static void populate(LocationModel &model, const QVector<LocationData> &data);
+
+    QList<int> m_sizes;
+    QTemporaryDir m_directory;
+    QHash<int, QVector<LocationData>> m_datasets;
+    QHash<int, QString> m_csvFiles;
+    QHash<int, QString> m_kmlFiles;
+    QSet<int> m_databases;
+};
+
+void LocationModelBench::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_directory.isValid());
+
+    QByteArray sizes = qgetenv("WDRVR_BENCH_SIZES");
+
+    if(sizes.isEmpty())
+        sizes = "10000";
+
+    for(const QByteArray &size : sizes.split(','))
+    {
+        bool valid = false;
+        int value = size.trimmed().toInt(&valid);
+
+        if(valid && value > 0)
+            m_sizes.append(value);
+    }
+
+    QVERIFY(!m_sizes.isEmpty());
+}
+
+void LocationModelBench::addSizes()
+{
+    QTest::addColumn<int>("size");
+
+    for(int size : std::as_const(m_sizes))
+        QTest::addRow("%d", size) << size;
+}
+
+SyntheticDataset::Options LocationModelBench::options(int size)
+{
+    SyntheticDataset::Options options;
+    options.size = size;
+    options.seed = Seed;
+
+    return options;
+}
+
+const QVector<LocationData> &LocationModelBench::dataset(int size)
+{
+    auto existing = m_datasets.constFind(size);
+
+    if(existing != m_datasets.constEnd())
+        return existing.value();
+
+    SyntheticDataset generator(options(size));
+    QVector<LocationData> data;
+    data.reserve(size);
+
+    while(!generator.atEnd())
+        data.append(generator.next());
+
+    return m_datasets[size] = data;
+}
+
+QString LocationModelBench::csvFile(int size)
+{
+    auto existing = m_csvFiles.constFind(size);
+
+    if(existing != m_csvFiles.constEnd())
+        return existing.value();
+
+    QString fileName = m_directory.filePath(QString("bench-%1.csv").arg(size));
+    QFile file(fileName);
+    SyntheticDataset generator(options(size));
+
+    if(!file.open(QFile::WriteOnly) || !generator.writeCsv(&file))
+        return QString();
+
+    return m_csvFiles[size] = fileName;
+}
+
+QString LocationModelBench::kmlFile(int size)
+{
+    auto existing = m_kmlFiles.constFind(size);
+
+    if(existing != m_kmlFiles.constEnd())
+        return existing.value();
+
+    QString fileName = m_directory.filePath(QString("bench-%1.kml").arg(size));
+    QFile file(fileName);
+    SyntheticDataset generator(options(size));
+
+    if(!file.open(QFile::WriteOnly) || !generator.writeKml(&file))
+        return QString();
+
+    return m_kmlFiles[size] = fileName;
+}
+
+//an empty database named after the size, created on first use
+QString LocationModelBench::database(int size)
+{
+    QString name = QString("bench%1").arg(size);
+
+    if(!m_databases.contains(size))
+    {
+        LocationModel model;
+        wait(model);
+
+        QDir directory = model.getDatabaseDirectory(name);
+        QFile::remove(directory.absoluteFilePath(name + ".db"));
+
+        model.createDatabase(name);
+        wait(model);
+
+        m_databases.insert(size);
+    }
+
+    return name;
+}
+
+void LocationModelBench::wait(LocationModel &model)
+{
+    if(!model.loading())
+        return;
+
+    QSignalSpy finished(&model, &LocationModel::loadingFinished);
+    finished.wait(OperationTimeout);
+}
+
+void LocationModelBench::populate(LocationModel &model, const QVector<LocationData> &data)
+{
+    for(const LocationData &poi : data)
+        model.append(poi, false);
+}
+
+void LocationModelBench::parseCSV_data()
+{
+    addSizes();
+}
+
+//import into an empty database, every row is deduplicated and written through
+void LocationModelBench::parseCSV()
+{
+    QFETCH(int, size);
+
+    QString fileName = csvFile(size);
+    QVERIFY(!fileName.isEmpty());
+
+    QString name = database(size);
+    m_databases.remove(size);
+
+    LocationModel model;
+    wait(model);
+    model.load(name);
+    wait(model);
+
+    //a second pass would only find duplicates
+    QBENCHMARK_ONCE
+    {
+        model.openFile(fileName);
+        wait(model);
+    }
+}
+
+void LocationModelBench::parseKML_data()
+{
+    addSizes();
+}
+
+void LocationModelBench::parseKML()
+{
+    QFETCH(int, size);
+
+    QString fileName = kmlFile(size);
+    QVERIFY(!fileName.isEmpty());
+
+    QString name = database(size);
+    m_databases.remove(size);
+
+    LocationModel model;
+    wait(model);
+    model.load(name);
+    wait(model);
+
+    QBENCHMARK_ONCE
+    {
+        model.openFile(fileName);
+        wait(model);
+    }
+}
+
+void LocationModelBench::append_data()
+{
+    addSizes();
+}
+
+//dedup, sector lookup and the indexes, without the database
+void LocationModelBench::append()
+{
+    QFETCH(int, size);
+
+    const QVector<LocationData> &data = dataset(size);
+
+    LocationModel model;
+    wait(model);
+
+    QBENCHMARK_ONCE
+    {
+        populate(model, data);
+    }
+}
+
+void LocationModelBench::sort_data()
+{
+    addSizes();
+}
+
+void LocationModelBench::sort()
+{
+    QFETCH(int, size);
+
+    LocationModel model;
+    wait(model);
+    populate(model, dataset(size));
+
+    //sorting clears the updated flags, so only the first pass does any work
+    QBENCHMARK_ONCE
+    {
+        model.sort();
+        wait(model);
+    }
+}
+
+void LocationModelBench::getPointsInRect_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<qreal>("zoom");
+    QTest::addColumn<bool>("cached");
+
+    for(int size : std::as_const(m_sizes))
+    {
+        for(qreal zoom : { 0.15, 0.4, 0.75 })
+        {
+            QTest::addRow("%d zoom %.2f", size, zoom) << size << zoom << false;
+            QTest::addRow("%d zoom %.2f cached", size, zoom) << size << zoom << true;
+        }
+    }
+}
+
+//the viewport spans more or less of the world around the largest cluster with the zoom, like the map does
+void LocationModelBench::getPointsInRect()
+{
+    QFETCH(int, size);
+    QFETCH(qreal, zoom);
+    QFETCH(bool, cached);
+
+    LocationModel model;
+    wait(model);
+    populate(model, dataset(size));
+
+    //without a budget every request clusters from scratch
+    if(!cached)
+        model.setTileCacheBudget(0);
+
+    qreal span = 360 * std::pow(2, -zoom * 20);
+    QGeoRectangle area(SyntheticDataset(options(size)).clusterCenters().first(), span, span / 2);
+
+    QSignalSpy published(&model, &QAbstractItemModel::modelReset);
+
+    QBENCHMARK
+    {
+        published.clear();
+        model.getPointsInRect(area, zoom);
+        QVERIFY(published.wait(OperationTimeout));
+    }
+}
+
+void LocationModelBench::save_data()
+{
+    addSizes();
+}
+
+void LocationModelBench::save()
+{
+    QFETCH(int, size);
+
+    QString name = database(size);
+
+    LocationModel model;
+    wait(model);
+    model.load(name);
+    wait(model);
+    populate(model, dataset(size));
+
+    QBENCHMARK_ONCE
+    {
+        model.save();
+        wait(model);
+    }
+}
+
+void LocationModelBench::load_data()
+{
+    addSizes();
+}
+
+//loads the database the save benchmark wrote
+void LocationModelBench::load()
+{
+    QFETCH(int, size);
+
+    QString name = database(size);
+
+    LocationModel model;
+    wait(model);
+
+    QBENCHMARK
+    {
+        model.load(name);
+        wait(model);
+    }
+}
+
+QTEST_GUILESS_MAIN(LocationModelBench)
+#include "locationmodelbench.moc"
@@ -0,0 +1,84 @@
+#include "clustertilecache.h"
+#include "locationmodel.h"
+
+#include <algorithm>
+#include <cmath>
+
+ClusterTileCache::ClusterTileCache()
+{
+    setBudget(DefaultBudget);
+}
+
+int ClusterTileCache::zoomFor(qreal longitudeSpan)
+{
+    if(longitudeSpan <= 0)
+        return MaximumZoom;
+
+    return std::clamp(static_cast<int>(std::ceil(std::log2(360 / longitudeSpan))), 0, MaximumZoom);
+}
+
+int ClusterTileCache::column(qreal longitude, int zoom)
+{
+    int tiles = 1 << zoom;
+    return std::clamp(static_cast<int>(std::floor(((longitude + 180) / 360) * tiles)), 0, tiles - 1);
+}
+
+//rows count down from the north pole
+int ClusterTileCache::row(qreal latitude, int zoom)
+{
+    int tiles = 1 << zoom;
+    return std::clamp(static_cast<int>(std::floor(((90 - latitude) / 180) * tiles)), 0, tiles - 1);
+}
+
+QGeoRectangle ClusterTileCache::bounds(int zoom, int column, int row)
+{
+    qreal width = 360.0 / (1 << zoom);
+    qreal height = 180.0 / (1 << zoom);
+
+    return QGeoRectangle(QGeoCoordinate(90 - (row * height), (column * width) - 180), QGeoCoordinate(90 - ((row + 1) * height), ((column + 1) * width) - 180));
+}
+
+quint64 ClusterTileCache::key(int step, int zoom, int column, int row)
+{
+    return (static_cast<quint64>(step) << 57) | (static_cast<quint64>(zoom) << 50) | (static_cast<quint64>(column) << 25) | static_cast<quint64>(row);
+}
+
+bool ClusterTileCache::find(quint64 key, quint64 stamp, ClusterTile &tile) const
+{
+    QMutexLocker locker(&m_mutex);
+    ClusterTile *cached = m_cache.object(key);
+
+    if(!cached || cached->stamp != stamp)
+        return false;
+
+    tile = *cached;
+
+    return true;
+}
+
+void ClusterTileCache::insert(quint64 key, const ClusterTile &tile)
+{
+    //cost in kb
+    qsizetype cost = ((tile.clusters.count() * sizeof(LocationCluster)) + (tile.sectorIds.count() * sizeof(quint32)) + sizeof(ClusterTile)) / 1024;
+
+    QMutexLocker locker(&m_mutex);
+    m_cache.insert(key, new ClusterTile(tile), std::max<qsizetype>(cost, 1));
+}
+
+void ClusterTileCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+}
+
+qint64 ClusterTileCache::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.maxCost() / 1024;
+}
+
+void ClusterTileCache::setBudget(qint64 budget)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.setMaxCost(std::max<qint64>(budget, 0) * 1024);
+}
@@ -0,0 +1,58 @@
+#ifndef CLUSTERTILECACHE_H
+#define CLUSTERTILECACHE_H
+
+#include <QCache>
+#include <QList>
+#include <QMutex>
+#include <QVector>
+#include <QGeoRectangle>
+
+struct LocationCluster;
+
+struct ClusterTile
+{
+    QVector<LocationCluster> clusters;
+    QList<quint32> sectorIds; //sectors the cluster representatives point into
+    quint64 stamp = 0;
+};
+
+/*
+ * Cache of clustered viewport tiles
+ *
+ * Viewports are split into tiles of a plain longitude/latitude grid, 360 / 2^zoom by 180 / 2^zoom
+ * degrees, and each tile is clustered on its own. Tiles are kept in an LRU bounded by the memory their
+ * clusters take, and carry the stamp of the sectors they were built from so the caller can tell when
+ * an append or a load made them stale.
+ *
+ * The cluster distance is snapped to DistanceSteps steps so nearby zoom levels share tiles.
+ */
+class ClusterTileCache
+{
+public:
+    static constexpr int MaximumZoom = 20;
+    static constexpr int DistanceSteps = 64;
+    static constexpr qint64 DefaultBudget = 32; //mb
+
+    ClusterTileCache();
+
+    //zoom at which a tile is about as wide as the viewport
+    static int zoomFor(qreal longitudeSpan);
+    static int column(qreal longitude, int zoom);
+    static int row(qreal latitude, int zoom);
+    static QGeoRectangle bounds(int zoom, int column, int row);
+    static quint64 key(int step, int zoom, int column, int row);
+
+    //returns true and copies the tile if it is cached for this stamp
+    bool find(quint64 key, quint64 stamp, ClusterTile &tile) const;
+    void insert(quint64 key, const ClusterTile &tile);
+    void clear();
+
+    qint64 budget() const;
+    void setBudget(qint64 budget);
+
+private:
+    mutable QMutex m_mutex;
+    QCache<quint64, ClusterTile> m_cache;
+};
+
+#endif // CLUSTERTILECACHE_H
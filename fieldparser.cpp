@@ -0,0 +1,109 @@
+#include "fieldparser.h"
+
+#include <charconv>
+#include <system_error>
+
+//numbers in our sources are never longer than this, longer fields are rejected before narrowing
+static constexpr qsizetype MaximumFieldLength = 64;
+
+static bool isSpace(char character)
+{
+    return character == ' ' || character == '\t' || character == '\r' || character == '\n';
+}
+
+template<typename Number>
+static FieldParser::Error parseNumber(const char *begin, const char *end, Number &value)
+{
+    while(begin != end && isSpace(*begin))
+        ++begin;
+
+    while(end != begin && isSpace(end[-1]))
+        --end;
+
+    if(begin == end)
+        return FieldParser::EmptyField;
+
+    //from_chars does not accept an explicit positive sign
+    if(*begin == '+')
+        ++begin;
+
+    Number result {};
+    std::from_chars_result parsed = std::from_chars(begin, end, result);
+
+    if(parsed.ec == std::errc::result_out_of_range)
+        return FieldParser::OutOfRange;
+
+    if(parsed.ec != std::errc() || parsed.ptr != end)
+        return FieldParser::InvalidField;
+
+    value = result;
+    return FieldParser::NoError;
+}
+
+template<typename Number>
+static FieldParser::Error parseNumber(QStringView field, Number &value)
+{
+    if(field.size() > MaximumFieldLength)
+        return FieldParser::InvalidField;
+
+    char buffer[MaximumFieldLength];
+    qsizetype length = 0;
+
+    for(QChar character : field)
+    {
+        //anything outside ASCII can't be part of a number
+        if(character.unicode() > 0x7f)
+            return FieldParser::InvalidField;
+
+        buffer[length++] = static_cast<char>(character.unicode());
+    }
+
+    return parseNumber(buffer, buffer + length, value);
+}
+
+FieldParser::Error FieldParser::toDouble(QByteArrayView field, double &value)
+{
+    return parseNumber(field.data(), field.data() + field.size(), value);
+}
+
+FieldParser::Error FieldParser::toDouble(QStringView field, double &value)
+{
+    return parseNumber(field, value);
+}
+
+FieldParser::Error FieldParser::toInt(QByteArrayView field, int &value)
+{
+    return parseNumber(field.data(), field.data() + field.size(), value);
+}
+
+FieldParser::Error FieldParser::toInt(QStringView field, int &value)
+{
+    return parseNumber(field, value);
+}
+
+FieldParser::Error FieldParser::toLongLong(QByteArrayView field, qint64 &value)
+{
+    return parseNumber(field.data(), field.data() + field.size(), value);
+}
+
+FieldParser::Error FieldParser::toLongLong(QStringView field, qint64 &value)
+{
+    return parseNumber(field, value);
+}
+
+const char *FieldParser::errorString(Error error)
+{
+    switch(error)
+    {
+    case NoError:
+        return "no error";
+    case EmptyField:
+        return "empty field";
+    case InvalidField:
+        return "invalid number";
+    case OutOfRange:
+        return "number out of range";
+    }
+
+    return "unknown error";
+}
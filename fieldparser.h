@@ -0,0 +1,38 @@
+#ifndef FIELDPARSER_H
+#define FIELDPARSER_H
+
+#include <QByteArrayView>
+#include <QStringView>
+#include <QtGlobal>
+
+/*
+ * Numeric field parsing
+ *
+ * Locale-free conversion of CSV, KML and SQLite fields built on std::from_chars. Byte fields are parsed
+ * in place, UTF-16 fields are narrowed into a stack buffer first, so neither allocates. Surrounding
+ * whitespace and a leading '+' are accepted, anything else left over makes the field invalid.
+ */
+class FieldParser
+{
+public:
+    enum Error
+    {
+        NoError = 0,
+        EmptyField,
+        InvalidField,
+        OutOfRange
+    };
+
+    static Error toDouble(QByteArrayView field, double &value);
+    static Error toDouble(QStringView field, double &value);
+
+    static Error toInt(QByteArrayView field, int &value);
+    static Error toInt(QStringView field, int &value);
+
+    static Error toLongLong(QByteArrayView field, qint64 &value);
+    static Error toLongLong(QStringView field, qint64 &value);
+
+    static const char *errorString(Error error);
+};
+
+#endif // FIELDPARSER_H
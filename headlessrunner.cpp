@@ -0,0 +1,250 @@
+#include "headlessrunner.h"
+#include "locationmodel.h"
+#include "wigleparser.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QTimer>
+
+HeadlessRunner::HeadlessRunner(LocationModel *model, QObject *parent)
+    : QObject{parent}
+{
+    m_model = model;
+}
+
+bool HeadlessRunner::requested(int argc, char **argv)
+{
+    static const QByteArray options[] = { "--import", "--stats", "--export" };
+
+    for(int index = 1; index < argc; ++index)
+    {
+        QByteArray argument(argv[index]);
+
+        //the parser also takes values in the --option=value form
+        for(const QByteArray &option : options)
+        {
+            if(argument == option || argument.startsWith(option + '='))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+bool HeadlessRunner::parse(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("wdrvr batch mode");
+    QCommandLineOption helpOption = parser.addHelpOption();
+
+    QCommandLineOption importOption("import", "Import the given WiGLE CSV and KML files and directories.");
+    QCommandLineOption databaseOption("db", "Database to use, created if it doesn't exist.", "name", "default");
+    QCommandLineOption statsOption("stats", "Print the database statistics.");
+    QCommandLineOption exportOption("export", "Export the database, WiGLE CSV, KML or GeoJSON by the extension, .gz compresses.", "file");
+    QCommandLineOption traceOption("trace", "Record trace spans and write them as Chrome trace JSON on exit.", "file");
+    QCommandLineOption attachOption("attach", "Attach another database for stats and export, may be repeated.", "name");
+    QCommandLineOption memoryOption("memory-budget", "MB the sectors may hold before idle ones are evicted, 0 for no limit.", "MB", "0");
+
+    parser.addOptions({ importOption, databaseOption, statsOption, exportOption, traceOption, attachOption, memoryOption });
+    parser.addPositionalArgument("files", "Files and directories to import.", "[files...]");
+
+    if(!parser.parse(arguments))
+    {
+        qCritical().noquote() << parser.errorText();
+        return false;
+    }
+
+    if(parser.isSet(helpOption))
+        parser.showHelp();
+
+    m_database = parser.value(databaseOption);
+    m_stats = parser.isSet(statsOption);
+    m_exportFile = parser.value(exportOption);
+    m_traceFile = parser.value(traceOption);
+    m_attachments = parser.values(attachOption);
+
+    bool validBudget = false;
+    m_memoryBudget = parser.value(memoryOption).toLongLong(&validBudget);
+
+    if(!validBudget || m_memoryBudget < 0)
+    {
+        qCritical().noquote() << "--memory-budget needs a size in MB";
+        return false;
+    }
+
+    if(parser.isSet(importOption))
+    {
+        m_imports = parser.positionalArguments();
+
+        if(m_imports.isEmpty())
+        {
+            qCritical().noquote() << "--import needs at least one file";
+            return false;
+        }
+
+        //the model only reports unusable inputs as an error, which would leave nothing to start the next step
+        for(const QString &fileName : std::as_const(m_imports))
+        {
+            QFileInfo info(fileName);
+
+            if(!info.exists())
+            {
+                qCritical().noquote() << "No such file" << fileName;
+                return false;
+            }
+
+            if(info.isDir() && !QDirIterator(info.absoluteFilePath(), { "*.csv", "*.kml" }, QDir::Files, QDirIterator::Subdirectories).hasNext())
+            {
+                qCritical().noquote() << "No WiGLE CSV or KML files in" << fileName;
+                return false;
+            }
+
+            if(!info.isDir() && WigleParser::format(fileName) == WigleParser::Unknown)
+            {
+                qCritical().noquote() << "Not a WiGLE CSV or KML file" << fileName;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void HeadlessRunner::start()
+{
+    if(!m_traceFile.isEmpty())
+        m_model->setTracing(true);
+
+    m_model->setMemoryBudget(m_memoryBudget);
+
+    if(!m_model->availableDatabases().contains(m_database))
+        m_steps.append([this]() { m_model->createDatabase(m_database); });
+
+    //load first so imports skip the ids the database already has
+    m_steps.append([this]() { m_model->load(m_database); });
+
+    //every file goes through one import, parsed in parallel and written in one transaction
+    if(!m_imports.isEmpty())
+    {
+        m_steps.append([this]() {
+            QStringList fileNames;
+
+            for(const QString &fileName : std::as_const(m_imports))
+                fileNames.append(QFileInfo(fileName).absoluteFilePath());
+
+            m_model->openFiles(fileNames);
+        });
+    }
+
+    //after the imports, so the stats and export see the imported rows together with the attached ones
+    for(const QString &name : std::as_const(m_attachments))
+    {
+        m_steps.append([this, name]() {
+            if(m_model->availableDatabases().contains(name) && name != m_database)
+                m_model->attach(name);
+            else
+            {
+                qCritical().noquote() << "Can't attach" << name;
+                m_exitCode = 1;
+                QTimer::singleShot(0, this, &HeadlessRunner::next);
+            }
+        });
+    }
+
+    if(m_stats)
+    {
+        m_steps.append([this]() {
+            printStats();
+            QTimer::singleShot(0, this, &HeadlessRunner::next);
+        });
+    }
+
+    if(!m_exportFile.isEmpty())
+        m_steps.append([this]() { m_model->exportFile(QFileInfo(m_exportFile).absoluteFilePath()); });
+
+    //queued so the model is done with its watcher before the next step reuses it
+    connect(m_model, &LocationModel::loadingFinished, this, &HeadlessRunner::next, Qt::QueuedConnection);
+    connect(m_model, &LocationModel::error, this, &HeadlessRunner::failed);
+    connect(m_model->metrics(), &PipelineMetrics::updated, this, &HeadlessRunner::printMetrics);
+
+    //the model may still be creating the default database, its loadingFinished starts the first step
+    if(!m_model->loading())
+        next();
+}
+
+void HeadlessRunner::next()
+{
+    ++m_step;
+
+    if(m_steps.isEmpty())
+    {
+        if(!m_traceFile.isEmpty() && m_model->dumpTrace(QFileInfo(m_traceFile).absoluteFilePath()).isEmpty())
+            m_exitCode = 1;
+
+        QCoreApplication::exit(m_exitCode);
+        return;
+    }
+
+    m_steps.takeFirst()();
+}
+
+void HeadlessRunner::failed()
+{
+    qCritical().noquote() << m_model->errorTitle() << m_model->errorMessage();
+    m_exitCode = 1;
+
+    //a step that fails before it starts loading never reports loadingFinished, move on unless it already did
+    if(!m_model->loading())
+    {
+        int step = m_step;
+
+        QTimer::singleShot(0, this, [this, step]() {
+            if(step == m_step)
+                next();
+        });
+    }
+}
+
+//one line per publish while an operation runs, on stderr so --stats output stays parseable
+void HeadlessRunner::printMetrics()
+{
+    PipelineMetrics *metrics = m_model->metrics();
+
+    if(!metrics->active())
+        return;
+
+    QTextStream err(stderr);
+
+    err << metrics->rows() << " rows, " << qRound64(metrics->rowsPerSecond()) << " rows/s, ";
+    err << QString::number(metrics->bytesPerSecond() / (1024 * 1024), 'f', 1) << " MB/s, ";
+    err << QString::number(metrics->duplicateRate() * 100, 'f', 1) << "% duplicates, ";
+    err << "queue " << metrics->writerQueue() << ", ";
+    err << "resident " << QString::number(metrics->residentBytes() / (1024.0 * 1024), 'f', 1) << " MB";
+
+    if(metrics->eta() >= 0)
+        err << ", eta " << qRound64(metrics->eta()) << " s";
+
+    err << Qt::endl;
+}
+
+void HeadlessRunner::printStats()
+{
+    QTextStream out(stdout);
+
+    out << "database " << m_model->loadedDatabase() << Qt::endl;
+    out << "total " << m_model->totalPointsOfInterest() << Qt::endl;
+    out << "wifi " << m_model->wifiStats() << Qt::endl;
+    out << "bluetooth " << m_model->bluetoothStats() << Qt::endl;
+    out << "bluetoothLE " << m_model->bluetoothLEStats() << Qt::endl;
+    out << "gsm " << m_model->gsmStats() << Qt::endl;
+    out << "cdma " << m_model->cdmaStats() << Qt::endl;
+    out << "wcdma " << m_model->wcdmaStats() << Qt::endl;
+    out << "lte " << m_model->lteStats() << Qt::endl;
+    out << "nr " << m_model->nrStats() << Qt::endl;
+    out << "first seen " << m_model->timelineStart() << Qt::endl;
+    out << "last seen " << m_model->timelineEnd() << Qt::endl;
+    out << "resident bytes " << m_model->metrics()->residentBytes() << Qt::endl;
+}
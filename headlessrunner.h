@@ -0,0 +1,64 @@
+#ifndef HEADLESSRUNNER_H
+#define HEADLESSRUNNER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QList>
+
+#include <functional>
+
+class LocationModel;
+
+/*
+ * Command line batch mode
+ *
+ *   wdrvr --import [--db name] files...     import WiGLE CSV and KML files and directories into a database
+ *   wdrvr --stats [--db name]               print the database's counters
+ *   wdrvr --export file [--db name]         write the database as WiGLE CSV, KML or GeoJSON, .gz compresses
+ *   wdrvr ... --attach name                 also show another database, stats and export cover both
+ *   wdrvr ... --trace file                  also record trace spans of the steps as Chrome trace JSON
+ *   wdrvr ... --memory-budget MB            evict idle sectors once they hold more than MB
+ *
+ * Runs from a QCoreApplication, so no QML engine, window or map plugin is ever created. The options
+ * combine, steps run in the order import, attach, stats, export. Every step is one of LocationModel's own
+ * background operations, the next one starts when the model reports loadingFinished.
+ */
+class HeadlessRunner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HeadlessRunner(LocationModel *model, QObject *parent = nullptr);
+
+    //true if the arguments ask for batch mode instead of the GUI
+    static bool requested(int argc, char **argv);
+
+    //returns false and prints the problem if the arguments are unusable
+    bool parse(const QStringList &arguments);
+
+public slots:
+    void start();
+
+private slots:
+    void next();
+    void failed();
+    void printMetrics();
+
+private:
+    void printStats();
+
+    LocationModel *m_model = nullptr;
+
+    QString m_database = "default";
+    QStringList m_imports;
+    QString m_exportFile;
+    QString m_traceFile;
+    QStringList m_attachments;
+    qint64 m_memoryBudget = 0; //MB
+    bool m_stats = false;
+
+    QList<std::function<void()>> m_steps;
+    int m_step = 0; //steps started so far
+    int m_exitCode = 0;
+};
+
+#endif // HEADLESSRUNNER_H
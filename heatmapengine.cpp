@@ -0,0 +1,241 @@
+#include "heatmapengine.h"
+#include "locationmodel.h"
+#include "mapprojection.h"
+
+#include <algorithm>
+#include <cmath>
+
+//points are projected in batches so the math runs over contiguous arrays
+static constexpr int AccumulateBatch = 256;
+
+quint64 HeatmapEngine::Tile::key() const
+{
+    return (static_cast<quint64>(zoom) << 58) | (static_cast<quint64>(weighted) << 57) | (static_cast<quint64>(x) << 28) | static_cast<quint64>(y);
+}
+
+HeatmapEngine::HeatmapEngine()
+{
+    m_cache.setMaxCost(CacheBudget);
+
+    //unnormalized so a lone point peaks at 1
+    qreal sigma = BlurRadius / 2.0;
+
+    for(int offset = -BlurRadius; offset <= BlurRadius; ++offset)
+        m_kernel[offset + BlurRadius] = static_cast<float>(std::exp(-(offset * offset) / (2 * sigma * sigma)));
+
+    struct Stop
+    {
+        qreal position;
+        QColor color;
+    };
+
+    const Stop stops[] = {
+        { 0.00, QColor(0, 0, 255, 0) },
+        { 0.15, QColor(0, 0, 255, 120) },
+        { 0.35, QColor(0, 255, 255, 160) },
+        { 0.55, QColor(0, 255, 0, 190) },
+        { 0.75, QColor(255, 255, 0, 210) },
+        { 1.00, QColor(255, 0, 0, 230) }
+    };
+
+    for(int index = 0; index < 256; ++index)
+    {
+        qreal position = index / 255.0;
+        int stop = 1;
+
+        while(stop < 5 && stops[stop].position < position)
+            ++stop;
+
+        const Stop &from = stops[stop - 1];
+        const Stop &to = stops[stop];
+        qreal t = (position - from.position) / (to.position - from.position);
+
+        QColor color = QColor::fromRgbF(from.color.redF() + (to.color.redF() - from.color.redF()) * t,
+                                        from.color.greenF() + (to.color.greenF() - from.color.greenF()) * t,
+                                        from.color.blueF() + (to.color.blueF() - from.color.blueF()) * t,
+                                        from.color.alphaF() + (to.color.alphaF() - from.color.alphaF()) * t);
+
+        m_palette[index] = qPremultiply(color.rgba());
+    }
+
+    m_palette[0] = 0;
+}
+
+QGeoRectangle HeatmapEngine::bounds(const Tile &tile)
+{
+    qreal tiles = std::ldexp(1.0, tile.zoom);
+    qreal margin = static_cast<qreal>(BlurRadius) / TileSize;
+
+    QGeoCoordinate topLeft = MapProjection::toCoordinate(std::max<qreal>(tile.x - margin, 0) / tiles, std::max<qreal>(tile.y - margin, 0) / tiles);
+    QGeoCoordinate bottomRight = MapProjection::toCoordinate(std::min<qreal>(tile.x + 1 + margin, tiles) / tiles, std::min<qreal>(tile.y + 1 + margin, tiles) / tiles);
+
+    return QGeoRectangle(topLeft, bottomRight);
+}
+
+void HeatmapEngine::accumulate(const Tile &tile, const LocationDataNode *head, QVector<float> &density)
+{
+    qreal tiles = std::ldexp(1.0, tile.zoom);
+
+    qreal latitudes[AccumulateBatch];
+    qreal longitudes[AccumulateBatch];
+    float weights[AccumulateBatch];
+    int columns[AccumulateBatch];
+    int rows[AccumulateBatch];
+
+    const LocationDataNode *node = head;
+
+    while(node)
+    {
+        int count = 0;
+
+        for(; node && count < AccumulateBatch; node = node->next, ++count)
+        {
+            latitudes[count] = node->data.coordinates.latitude();
+            longitudes[count] = node->data.coordinates.longitude();
+
+            weights[count] = tile.weighted ? signalWeight(node->data.signal) : 1.0f;
+        }
+
+        for(int index = 0; index < count; ++index)
+        {
+            qreal x = ((MapProjection::mercatorX(longitudes[index]) * tiles) - tile.x) * TileSize;
+            qreal y = ((MapProjection::mercatorY(latitudes[index]) * tiles) - tile.y) * TileSize;
+
+            columns[index] = static_cast<int>(std::floor(x)) + BlurRadius;
+            rows[index] = static_cast<int>(std::floor(y)) + BlurRadius;
+        }
+
+        for(int index = 0; index < count; ++index)
+        {
+            if(columns[index] < 0 || columns[index] >= GridSize || rows[index] < 0 || rows[index] >= GridSize)
+                continue;
+
+            density[(rows[index] * GridSize) + columns[index]] += weights[index];
+        }
+    }
+}
+
+void HeatmapEngine::accumulate(const Tile &tile, const QVector<AreaCell> &cells, QVector<float> &density)
+{
+    qreal tiles = std::ldexp(1.0, tile.zoom);
+
+    for(const AreaCell &cell : cells)
+    {
+        qreal x = ((MapProjection::mercatorX(cell.longitude) * tiles) - tile.x) * TileSize;
+        qreal y = ((MapProjection::mercatorY(cell.latitude) * tiles) - tile.y) * TileSize;
+
+        int column = static_cast<int>(std::floor(x)) + BlurRadius;
+        int row = static_cast<int>(std::floor(y)) + BlurRadius;
+
+        if(column < 0 || column >= GridSize || row < 0 || row >= GridSize)
+            continue;
+
+        density[(row * GridSize) + column] += static_cast<float>(tile.weighted ? cell.heat : cell.total);
+    }
+}
+
+float HeatmapEngine::signalWeight(qreal signal)
+{
+    return signal < 0 ? static_cast<float>(std::clamp((signal + 100) / 70, 0.05, 1.0)) : 1.0f;
+}
+
+QImage HeatmapEngine::render(const QVector<float> &density) const
+{
+    //horizontal pass keeps every row but only the columns of the tile itself
+    QVector<float> horizontal(GridSize * TileSize, 0.0f);
+
+    for(int row = 0; row < GridSize; ++row)
+    {
+        const float *source = density.constData() + (row * GridSize);
+        float *target = horizontal.data() + (row * TileSize);
+
+        for(int offset = 0; offset <= 2 * BlurRadius; ++offset)
+        {
+            float weight = m_kernel[offset];
+
+            for(int column = 0; column < TileSize; ++column)
+                target[column] += source[column + offset] * weight;
+        }
+    }
+
+    QVector<float> blurred(TileSize * TileSize, 0.0f);
+
+    for(int row = 0; row < TileSize; ++row)
+    {
+        float *target = blurred.data() + (row * TileSize);
+
+        for(int offset = 0; offset <= 2 * BlurRadius; ++offset)
+        {
+            const float *source = horizontal.constData() + ((row + offset) * TileSize);
+            float weight = m_kernel[offset];
+
+            for(int column = 0; column < TileSize; ++column)
+                target[column] += source[column] * weight;
+        }
+    }
+
+    QImage image(TileSize, TileSize, QImage::Format_ARGB32_Premultiplied);
+    float scale = static_cast<float>(255 / std::log1p(ReferenceDensity));
+
+    for(int row = 0; row < TileSize; ++row)
+    {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(row));
+        const float *values = blurred.constData() + (row * TileSize);
+
+        for(int column = 0; column < TileSize; ++column)
+        {
+            int index = static_cast<int>(std::log1p(values[column]) * scale);
+            line[column] = m_palette[std::clamp(index, 0, 255)];
+        }
+    }
+
+    return image;
+}
+
+bool HeatmapEngine::find(const Tile &tile, quint64 stamp, QImage &image) const
+{
+    QMutexLocker locker(&m_mutex);
+    CachedTile *cached = m_cache.object(tile.key());
+
+    if(!cached)
+        return false;
+
+    image = cached->image;
+
+    return cached->stamp == stamp;
+}
+
+bool HeatmapEngine::schedule(const Tile &tile, quint64 stamp)
+{
+    QMutexLocker locker(&m_mutex);
+    auto pending = m_pending.constFind(tile.key());
+
+    if(pending != m_pending.constEnd() && pending.value() == stamp)
+        return false;
+
+    m_pending.insert(tile.key(), stamp);
+
+    return true;
+}
+
+void HeatmapEngine::insert(const Tile &tile, quint64 stamp, const QImage &image)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(m_pending.value(tile.key()) == stamp)
+        m_pending.remove(tile.key());
+
+    CachedTile *cached = new CachedTile;
+    cached->image = image;
+    cached->stamp = stamp;
+
+    m_cache.insert(tile.key(), cached, std::max<qsizetype>(image.sizeInBytes() / 1024, 1));
+}
+
+void HeatmapEngine::clear()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_cache.clear();
+    m_pending.clear();
+}
@@ -0,0 +1,92 @@
+#ifndef HEATMAPENGINE_H
+#define HEATMAPENGINE_H
+
+#include <QImage>
+#include <QColor>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <QGeoRectangle>
+
+#include <array>
+
+struct LocationDataNode;
+struct AreaCell;
+
+/*
+ * Density heatmap tiles
+ *
+ * Tiles follow the web mercator tile scheme. Points are counted, optionally weighted by signal, into
+ * a float grid that extends BlurRadius pixels past the tile so neighbouring tiles blur into each
+ * other without seams. The grid is blurred with a separable gaussian and mapped through a palette
+ * on a log scale.
+ *
+ * Up to AggregateZoom a tile pixel spans more than an aggregate cell, so those tiles add the cell
+ * counts at the cell centers instead of walking the POIs and decoding the packed sectors.
+ *
+ * Rendered tiles are cached together with a stamp of the sectors they were drawn from. A tile is
+ * only redrawn when the stamp the caller computes from the current sectors differs.
+ */
+class HeatmapEngine
+{
+public:
+    static constexpr int TileSize = 256; //px
+    static constexpr int BlurRadius = 12; //px
+    static constexpr int GridSize = TileSize + (2 * BlurRadius);
+    static constexpr int MaximumZoom = 20;
+    static constexpr qreal ReferenceDensity = 64; //blurred points per pixel drawn at full heat
+    static constexpr int AggregateZoom = 6; //tiles up to this zoom are drawn from the aggregate cells
+
+    struct Tile
+    {
+        int zoom = 0;
+        int x = 0;
+        int y = 0;
+        bool weighted = false;
+
+        quint64 key() const;
+    };
+
+    HeatmapEngine();
+
+    //area the tile and its blur margin cover
+    static QGeoRectangle bounds(const Tile &tile);
+
+    //adds the points of a sector to a GridSize * GridSize density grid
+    static void accumulate(const Tile &tile, const LocationDataNode *head, QVector<float> &density);
+
+    //adds aggregate cells, each as its count or signal weight at the cell center
+    static void accumulate(const Tile &tile, const QVector<AreaCell> &cells, QVector<float> &density);
+
+    //dBm readings, -100 barely heard and -30 next to the antenna
+    static float signalWeight(qreal signal);
+
+    QImage render(const QVector<float> &density) const;
+
+    //image is set to the cached tile even if it is stale, returns true if the stamp matched
+    bool find(const Tile &tile, quint64 stamp, QImage &image) const;
+
+    //returns false if the tile is already being drawn for this stamp
+    bool schedule(const Tile &tile, quint64 stamp);
+    void insert(const Tile &tile, quint64 stamp, const QImage &image);
+    void clear();
+
+private:
+    struct CachedTile
+    {
+        QImage image;
+        quint64 stamp = 0;
+    };
+
+    static constexpr qsizetype CacheBudget = 64 * 1024; //kb
+
+    mutable QMutex m_mutex;
+    QCache<quint64, CachedTile> m_cache;
+    QHash<quint64, quint64> m_pending;
+
+    std::array<float, (2 * BlurRadius) + 1> m_kernel;
+    std::array<QRgb, 256> m_palette;
+};
+
+#endif // HEATMAPENGINE_H
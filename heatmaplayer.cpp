@@ -0,0 +1,185 @@
+#include "heatmaplayer.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+
+HeatmapLayer::HeatmapLayer(QQuickItem *parent)
+    : QQuickPaintedItem{parent}
+{
+    connect(this, &QQuickItem::visibleChanged, this, &HeatmapLayer::invalidate);
+}
+
+void HeatmapLayer::paint(QPainter *painter)
+{
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+
+    for(const VisibleTile &tile : std::as_const(m_tiles))
+    {
+        //on top of whatever scaling the painted item already applies
+        painter->save();
+        painter->setTransform(tile.transform, true);
+        painter->drawImage(QPointF(0, 0), tile.image);
+        painter->restore();
+    }
+}
+
+LocationModel *HeatmapLayer::model() const
+{
+    return m_model;
+}
+
+void HeatmapLayer::setModel(LocationModel *model)
+{
+    if (m_model == model)
+        return;
+
+    for(const QMetaObject::Connection &connection : std::as_const(m_modelConnections))
+        disconnect(connection);
+
+    m_modelConnections.clear();
+    m_model = model;
+
+    if(m_model)
+    {
+        m_modelConnections += connect(m_model, &LocationModel::heatmapTileReady, this, &HeatmapLayer::invalidate);
+        m_modelConnections += connect(m_model, &LocationModel::sectorsUpdated, this, &HeatmapLayer::invalidate);
+    }
+
+    invalidate();
+    emit modelChanged();
+}
+
+QQuickItem *HeatmapLayer::map() const
+{
+    return m_map;
+}
+
+void HeatmapLayer::setMap(QQuickItem *map)
+{
+    if (m_map == map)
+        return;
+
+    for(const QMetaObject::Connection &connection : std::as_const(m_mapConnections))
+        disconnect(connection);
+
+    m_mapConnections.clear();
+    m_map = map;
+
+    if(m_map)
+        m_mapConnections = MapProjection::connectCamera(m_map, this, "invalidate()");
+
+    invalidate();
+    emit mapChanged();
+}
+
+bool HeatmapLayer::weighted() const
+{
+    return m_weighted;
+}
+
+void HeatmapLayer::setWeighted(bool weighted)
+{
+    if (m_weighted == weighted)
+        return;
+
+    m_weighted = weighted;
+
+    invalidate();
+    emit weightedChanged();
+}
+
+void HeatmapLayer::updatePolish()
+{
+    m_tiles.clear();
+
+    if(!m_model || !isVisible() || width() <= 0 || height() <= 0)
+    {
+        update();
+        return;
+    }
+
+    m_projection.calibrate(m_map, this);
+
+    //the tile zoom whose pixels are closest to the screen's
+    int zoom = std::clamp(static_cast<int>(std::round(std::log2(m_projection.scale() / HeatmapEngine::TileSize))), 0, HeatmapEngine::MaximumZoom);
+
+    const QPointF corners[] = {
+        m_projection.toMercator(QPointF(0, 0)),
+        m_projection.toMercator(QPointF(width(), 0)),
+        m_projection.toMercator(QPointF(0, height())),
+        m_projection.toMercator(QPointF(width(), height()))
+    };
+
+    qreal left = corners[0].x();
+    qreal right = corners[0].x();
+    qreal top = corners[0].y();
+    qreal bottom = corners[0].y();
+
+    for(const QPointF &corner : corners)
+    {
+        left = std::min(left, corner.x());
+        right = std::max(right, corner.x());
+        top = std::min(top, corner.y());
+        bottom = std::max(bottom, corner.y());
+    }
+
+    qint64 tiles = 0;
+    qint64 columnStart = 0;
+    qint64 columnEnd = 0;
+    qint64 rowStart = 0;
+    qint64 rowEnd = 0;
+
+    //step out when rotation or a small window would need too many tiles
+    for(;; --zoom)
+    {
+        tiles = qint64(1) << zoom;
+
+        columnStart = static_cast<qint64>(std::floor(left * tiles));
+        columnEnd = static_cast<qint64>(std::floor(right * tiles));
+        rowStart = std::max<qint64>(static_cast<qint64>(std::floor(top * tiles)), 0);
+        rowEnd = std::min<qint64>(static_cast<qint64>(std::floor(bottom * tiles)), tiles - 1);
+
+        if(zoom == 0 || (columnEnd - columnStart + 1) * (rowEnd - rowStart + 1) <= MaximumTiles)
+            break;
+    }
+
+    //the columns are left unwrapped so they line up with the center, only the lookup wraps
+    qreal tileScale = 1.0 / (tiles * HeatmapEngine::TileSize);
+    QPointF axisX = m_projection.axisX() * tileScale;
+    QPointF axisY = m_projection.axisY() * tileScale;
+
+    for(qint64 row = rowStart; row <= rowEnd; ++row)
+    {
+        for(qint64 column = std::max(columnStart, columnEnd - tiles + 1); column <= columnEnd; ++column)
+        {
+            int x = static_cast<int>(((column % tiles) + tiles) % tiles);
+            QImage image = m_model->heatmapTile(zoom, x, static_cast<int>(row), m_weighted);
+
+            if(image.isNull())
+                continue;
+
+            QPointF origin = m_projection.origin() + (m_projection.axisX() * ((static_cast<qreal>(column) / tiles) - m_projection.centerX())) + (m_projection.axisY() * ((static_cast<qreal>(row) / tiles) - m_projection.centerY()));
+
+            VisibleTile tile;
+            tile.transform = QTransform(axisX.x(), axisX.y(), axisY.x(), axisY.y(), origin.x(), origin.y());
+            tile.image = image;
+
+            m_tiles.append(tile);
+        }
+    }
+
+    update();
+}
+
+void HeatmapLayer::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickPaintedItem::geometryChange(newGeometry, oldGeometry);
+    invalidate();
+}
+
+void HeatmapLayer::invalidate()
+{
+    polish();
+}
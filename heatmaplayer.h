@@ -0,0 +1,73 @@
+#ifndef HEATMAPLAYER_H
+#define HEATMAPLAYER_H
+
+#include <QObject>
+#include <QQuickPaintedItem>
+#include <QPointer>
+#include <QTransform>
+#include <QImage>
+
+#include "locationmodel.h"
+#include "mapprojection.h"
+
+/*
+ * Heatmap overlay
+ *
+ * Asks the model for the heatmap tiles under the map at the nearest whole zoom level and paints them
+ * with the map's projection. Tiles that are missing or stale are drawn by the model in the background,
+ * stale ones keep being shown until then.
+ */
+class HeatmapLayer : public QQuickPaintedItem
+{
+    Q_OBJECT
+public:
+    explicit HeatmapLayer(QQuickItem *parent = nullptr);
+
+    void paint(QPainter *painter) override;
+
+    LocationModel *model() const;
+    void setModel(LocationModel *model);
+
+    QQuickItem *map() const;
+    void setMap(QQuickItem *map);
+
+    bool weighted() const;
+    void setWeighted(bool weighted);
+
+signals:
+    void modelChanged();
+    void mapChanged();
+    void weightedChanged();
+
+protected:
+    void updatePolish() override;
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private slots:
+    void invalidate();
+
+private:
+    static constexpr int MaximumTiles = 64;
+
+    struct VisibleTile
+    {
+        QTransform transform; //tile pixels to item coordinates
+        QImage image;
+    };
+
+    QPointer<LocationModel> m_model;
+    QPointer<QQuickItem> m_map;
+    QList<QMetaObject::Connection> m_modelConnections;
+    QList<QMetaObject::Connection> m_mapConnections;
+
+    bool m_weighted = false;
+
+    MapProjection m_projection;
+    QList<VisibleTile> m_tiles;
+
+    Q_PROPERTY(LocationModel *model READ model WRITE setModel NOTIFY modelChanged FINAL)
+    Q_PROPERTY(QQuickItem *map READ map WRITE setMap NOTIFY mapChanged FINAL)
+    Q_PROPERTY(bool weighted READ weighted WRITE setWeighted NOTIFY weightedChanged FINAL)
+};
+
+#endif // HEATMAPLAYER_H
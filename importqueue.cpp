@@ -0,0 +1,56 @@
+#include "importqueue.h"
+
+ImportQueue::ImportQueue(int producers)
+    : m_producers(producers)
+{
+}
+
+bool ImportQueue::push(ImportBatch &&batch)
+{
+    QMutexLocker locker(&m_mutex);
+
+    while(m_batches.count() >= Capacity && !m_cancelled)
+        m_notFull.wait(&m_mutex);
+
+    if(m_cancelled)
+        return false;
+
+    m_batches.enqueue(std::move(batch));
+    m_notEmpty.wakeOne();
+
+    return true;
+}
+
+bool ImportQueue::pop(ImportBatch &batch)
+{
+    QMutexLocker locker(&m_mutex);
+
+    while(m_batches.isEmpty() && m_producers > 0 && !m_cancelled)
+        m_notEmpty.wait(&m_mutex);
+
+    if(m_cancelled || m_batches.isEmpty())
+        return false;
+
+    batch = m_batches.dequeue();
+    m_notFull.wakeOne();
+
+    return true;
+}
+
+void ImportQueue::finish()
+{
+    QMutexLocker locker(&m_mutex);
+
+    --m_producers;
+    m_notEmpty.wakeAll();
+}
+
+void ImportQueue::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_cancelled = true;
+    m_batches.clear();
+    m_notEmpty.wakeAll();
+    m_notFull.wakeAll();
+}
@@ -0,0 +1,82 @@
+#ifndef IMPORTQUEUE_H
+#define IMPORTQUEUE_H
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "locationmodel.h"
+
+/*
+ * Import file state
+ *
+ * Written by the parser of the file and the ingest, read by the model thread for the per file progress.
+ */
+struct ImportFile
+{
+    enum State
+    {
+        Queued,
+        Parsing,
+        Done,
+        Failed
+    };
+
+    QString fileName;
+    qint64 size = 0;
+
+    QAtomicInteger<qint64> position = 0; //bytes parsed
+    QAtomicInteger<quint64> rows = 0; //rows ingested
+    QAtomicInteger<quint64> duplicates = 0;
+    QAtomicInt state = Queued;
+
+    //set by the parser before it finishes
+    QString error;
+    qint64 first = 0;
+    qint64 last = 0;
+};
+
+struct ImportBatch
+{
+    int file = -1;
+    QVector<LocationData> rows;
+};
+
+/*
+ * Bounded batch queue between the import parsers and the ingest
+ *
+ * Any number of parsers push, one ingest pops. Parsers block once Capacity batches are waiting so a
+ * slow database can't make a fast parser buffer a whole file. pop() returns false once every parser
+ * has called finish() and the queue is drained, or once the import was cancelled.
+ */
+class ImportQueue
+{
+public:
+    static constexpr int Capacity = 64; //batches
+
+    explicit ImportQueue(int producers);
+
+    ImportQueue(const ImportQueue &) = delete;
+    ImportQueue &operator=(const ImportQueue &) = delete;
+
+    //false once cancelled, the batch is dropped then
+    bool push(ImportBatch &&batch);
+    bool pop(ImportBatch &batch);
+
+    //called by every parser once it is done pushing
+    void finish();
+    void cancel();
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QQueue<ImportBatch> m_batches;
+    int m_producers = 0;
+    bool m_cancelled = false;
+};
+
+#endif // IMPORTQUEUE_H
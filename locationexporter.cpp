@@ -0,0 +1,252 @@
+#include "locationexporter.h"
+#include "locationmodel.h"
+
+#include <QDateTime>
+#include <QTimeZone>
+#include <QtEndian>
+
+#include <array>
+
+LocationExporter::Format LocationExporter::format(const QString &fileName)
+{
+    QString name = fileName.toLower();
+
+    if(name.endsWith(".gz"))
+        name.chop(3);
+
+    if(name.endsWith(".kml"))
+        return Kml;
+
+    if(name.endsWith(".geojson") || name.endsWith(".json"))
+        return GeoJson;
+
+    return Csv;
+}
+
+bool LocationExporter::compressed(const QString &fileName)
+{
+    return fileName.endsWith(".gz", Qt::CaseInsensitive);
+}
+
+LocationExporter::LocationExporter(Format format, bool compressed)
+    : m_format(format), m_compressed(compressed)
+{
+}
+
+void LocationExporter::setFilter(const LocationFilter &filter)
+{
+    m_filter = filter;
+    m_filtered = !filter.isEmpty();
+}
+
+void LocationExporter::setArea(const QGeoRectangle &area)
+{
+    m_area = area;
+}
+
+QGeoRectangle LocationExporter::area() const
+{
+    return m_area;
+}
+
+bool LocationExporter::accepts(const LocationData &data) const
+{
+    if(m_area.isValid() && !m_area.contains(data.coordinates))
+        return false;
+
+    return !m_filtered || m_filter.accepts(data);
+}
+
+//the importer splits on every comma, so they can't survive inside a field
+static QByteArray csvField(const QString &value)
+{
+    QString sanitized = value;
+    sanitized.replace(',', ' ');
+    sanitized.remove('\n');
+    sanitized.remove('\r');
+    return sanitized.toUtf8();
+}
+
+//the importer splits KML descriptions on whitespace that doesn't follow a colon, values can't contain any
+static QString kmlValue(const QString &value)
+{
+    QString sanitized = value.simplified();
+    sanitized.replace(' ', '_');
+    return sanitized.toHtmlEscaped();
+}
+
+static void appendJsonString(QByteArray &buffer, const QString &value)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    buffer += '"';
+
+    for(char character : value.toUtf8())
+    {
+        uchar byte = static_cast<uchar>(character);
+
+        if(byte == '"' || byte == '\\')
+        {
+            buffer += '\\';
+            buffer += character;
+        }
+        else if(byte < 0x20)
+        {
+            buffer += "\\u00";
+            buffer += hex[byte >> 4];
+            buffer += hex[byte & 0xf];
+        }
+        else
+            buffer += character;
+    }
+
+    buffer += '"';
+}
+
+//JSON has no NaN or infinity
+static QByteArray jsonNumber(qreal value, int precision = 6)
+{
+    return QByteArray::number(qIsFinite(value) ? value : 0, 'g', precision);
+}
+
+void LocationExporter::append(QByteArray &buffer, const LocationData &data) const
+{
+    qreal altitude = qIsNaN(data.coordinates.altitude()) ? 0 : data.coordinates.altitude();
+
+    switch(m_format)
+    {
+    case Csv:
+        buffer += csvField(data.id) + ',' + csvField(data.name) + ',' + csvField(data.encryption) + ',';
+        buffer += QDateTime::fromMSecsSinceEpoch(data.timestamp, QTimeZone::UTC).toString("yyyy-MM-dd HH:mm:ss").toUtf8() + ',';
+        buffer += QByteArray::number(data.open) + ',' + QByteArray::number(data.frequency) + ',' + QByteArray::number(data.signal) + ',';
+        buffer += QByteArray::number(data.coordinates.latitude(), 'g', 12) + ',' + QByteArray::number(data.coordinates.longitude(), 'g', 12) + ',';
+        buffer += QByteArray::number(altitude) + ',' + QByteArray::number(data.accuracy) + ',';
+        buffer += csvField(data.rois.join(' ')) + ',' + csvField(data.mfgid) + ',' + csvField(data.type) + '\n';
+        break;
+
+    case Kml:
+        buffer += "<Placemark>\n<name>" + data.name.toHtmlEscaped().toUtf8() + "</name>\n<open>" + QByteArray::number(data.open) + "</open>\n";
+        buffer += "<description>Network ID: " + kmlValue(data.id).toUtf8() + "\nEncryption: " + kmlValue(data.encryption).toUtf8();
+        buffer += "\nTime: " + QDateTime::fromMSecsSinceEpoch(data.timestamp, QTimeZone::UTC).toString(Qt::ISODateWithMs).toUtf8();
+        buffer += "\nSignal: " + QByteArray::number(data.signal) + "\nAccuracy: " + QByteArray::number(data.accuracy);
+        buffer += "\nType: " + kmlValue(data.type).toUtf8() + "\nFrequency: " + QByteArray::number(data.frequency) + "</description>\n";
+        buffer += "<Point>\n<coordinates>" + QByteArray::number(data.coordinates.longitude(), 'f', 7) + ',' + QByteArray::number(data.coordinates.latitude(), 'f', 7);
+        buffer += "</coordinates>\n</Point>\n</Placemark>\n";
+        break;
+
+    case GeoJson:
+        if(!buffer.isEmpty())
+            buffer += ",\n";
+
+        buffer += "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\",\"coordinates\":[";
+        buffer += jsonNumber(data.coordinates.longitude(), 12) + ',' + jsonNumber(data.coordinates.latitude(), 12) + ',' + jsonNumber(altitude);
+        buffer += "]},\"properties\":{\"id\":";
+        appendJsonString(buffer, data.id);
+        buffer += ",\"name\":";
+        appendJsonString(buffer, data.name);
+        buffer += ",\"encryption\":";
+        appendJsonString(buffer, data.encryption);
+        buffer += ",\"type\":";
+        appendJsonString(buffer, data.type);
+        buffer += ",\"time\":";
+        appendJsonString(buffer, QDateTime::fromMSecsSinceEpoch(data.timestamp, QTimeZone::UTC).toString(Qt::ISODateWithMs));
+        buffer += ",\"channel\":" + QByteArray::number(data.open) + ",\"frequency\":" + jsonNumber(data.frequency);
+        buffer += ",\"signal\":" + jsonNumber(data.signal) + ",\"accuracy\":" + jsonNumber(data.accuracy) + ",\"mfgid\":";
+        appendJsonString(buffer, data.mfgid);
+        buffer += ",\"rcois\":";
+        appendJsonString(buffer, data.rois.join(' '));
+        buffer += "}}";
+        break;
+    }
+}
+
+QByteArray LocationExporter::encode(const QByteArray &buffer) const
+{
+    return m_compressed ? gzip(buffer) : buffer;
+}
+
+QByteArray LocationExporter::header() const
+{
+    switch(m_format)
+    {
+    case Csv:
+        return encode("WigleWifi-1.4,appRelease=wdrvr,model=wdrvr,release=0.1,device=wdrvr,display=wdrvr,board=wdrvr,brand=wdrvr\n"
+                      "MAC,SSID,AuthMode,FirstSeen,Channel,Frequency,RSSI,CurrentLatitude,CurrentLongitude,AltitudeMeters,AccuracyMeters,RCOIs,MfgrId,Type\n");
+    case Kml:
+        return encode("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n<Document>\n<name>wdrvr</name>\n");
+    case GeoJson:
+        return encode("{\"type\":\"FeatureCollection\",\"features\":[\n");
+    }
+
+    return QByteArray();
+}
+
+QByteArray LocationExporter::footer() const
+{
+    switch(m_format)
+    {
+    case Csv:
+        break;
+    case Kml:
+        return encode("</Document>\n</kml>\n");
+    case GeoJson:
+        return encode("\n]}\n");
+    }
+
+    return QByteArray();
+}
+
+QByteArray LocationExporter::separator() const
+{
+    return m_format == GeoJson ? encode(",\n") : QByteArray();
+}
+
+QByteArray LocationExporter::gzip(const QByteArray &data)
+{
+    if(data.isEmpty())
+        return QByteArray();
+
+    //qCompress writes the size as 4 bytes, then a zlib stream of a 2 byte header, the deflate data and
+    //a 4 byte adler-32, gzip wants the bare deflate data
+    QByteArray deflated = qCompress(data, 6);
+
+    static const char header[10] = { 0x1f, static_cast<char>(0x8b), 8, 0, 0, 0, 0, 0, 0, static_cast<char>(0xff) };
+
+    QByteArray member;
+    member.reserve(deflated.size() + 8);
+    member.append(header, sizeof(header));
+    member.append(deflated.constData() + 6, deflated.size() - 10);
+
+    char trailer[8];
+    qToLittleEndian<quint32>(crc32(data), trailer);
+    qToLittleEndian<quint32>(static_cast<quint32>(data.size()), trailer + 4);
+    member.append(trailer, sizeof(trailer));
+
+    return member;
+}
+
+quint32 LocationExporter::crc32(const QByteArray &data)
+{
+    static const std::array<quint32, 256> table = []() {
+        std::array<quint32, 256> entries {};
+
+        for(quint32 index = 0; index < 256; ++index)
+        {
+            quint32 value = index;
+
+            for(int bit = 0; bit < 8; ++bit)
+                value = (value & 1) ? 0xedb88320 ^ (value >> 1) : value >> 1;
+
+            entries[index] = value;
+        }
+
+        return entries;
+    }();
+
+    quint32 crc = 0xffffffff;
+
+    for(char character : data)
+        crc = table[(crc ^ static_cast<uchar>(character)) & 0xff] ^ (crc >> 8);
+
+    return crc ^ 0xffffffff;
+}
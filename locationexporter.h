@@ -0,0 +1,70 @@
+#ifndef LOCATIONEXPORTER_H
+#define LOCATIONEXPORTER_H
+
+#include <QByteArray>
+#include <QGeoRectangle>
+#include <QString>
+
+#include "sectorindex.h"
+
+struct LocationData;
+
+/*
+ * Export formatting
+ *
+ * Turns POIs into WiGLE CSV, KML or GeoJSON. The export cuts the sectors into batches, every batch is
+ * formatted into its own buffer on a pool thread and encoded there, and a single writer appends the
+ * encoded buffers to the file in batch order. Nothing here holds state between buffers, so any number
+ * of batches can be formatted at once.
+ *
+ * A compressed export is a gzip file with one member per buffer. gzip, zcat and zlib read concatenated
+ * members as one stream, and it lets every batch be compressed on its own thread.
+ */
+class LocationExporter
+{
+public:
+    enum Format
+    {
+        Csv = 0,
+        Kml,
+        GeoJson
+    };
+
+    //from the extension, .csv, .kml, .geojson or .json, optionally followed by .gz. Csv if unknown
+    static Format format(const QString &fileName);
+    static bool compressed(const QString &fileName);
+
+    LocationExporter(Format format = Csv, bool compressed = false);
+
+    //restricts the export to the POIs passing the filter inside the area, an invalid area is everywhere
+    void setFilter(const LocationFilter &filter);
+    void setArea(const QGeoRectangle &area);
+    QGeoRectangle area() const;
+
+    bool accepts(const LocationData &data) const;
+
+    //appends one POI to a buffer of this batch
+    void append(QByteArray &buffer, const LocationData &data) const;
+
+    //a formatted buffer as it goes into the file
+    QByteArray encode(const QByteArray &buffer) const;
+
+    //already encoded
+    QByteArray header() const;
+    QByteArray footer() const;
+    QByteArray separator() const; //between two non empty buffers
+
+    //one gzip member
+    static QByteArray gzip(const QByteArray &data);
+
+private:
+    static quint32 crc32(const QByteArray &data);
+
+    Format m_format = Csv;
+    bool m_compressed = false;
+    LocationFilter m_filter;
+    bool m_filtered = false;
+    QGeoRectangle m_area;
+};
+
+#endif // LOCATIONEXPORTER_H
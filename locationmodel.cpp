@@ -1,23 +1,24 @@
 #include "locationmodel.h"
+#include "importqueue.h"
+#include "locationexporter.h"
+#include "sectorcodec.h"
+#include "wigleparser.h"
 
+#include <QDirIterator>
+#include <QQueue>
+#include <QScopeGuard>
+#include <QTimeZone>
 
-LocationData::~LocationData()
-{
-    // while(children)
-    // {
-    //     LocationDataNode *node = children;
-    //     children = children->next;
-
-    //     delete node;
-    // }
-}
+#include <limits>
 
 LocationModel::LocationModel(QObject *parent)
     : QAbstractListModel{parent}
 {
 
     m_updateTimer = new QTimer;
-    m_updateTimer->setInterval(10);
+    m_updateTimer->setInterval(ProgressInterval);
+
+    m_metrics = new PipelineMetrics(this);
 
     connect(m_updateTimer, &QTimer::timeout, this, &LocationModel::updateProgress);
 
@@ -33,10 +34,56 @@ LocationModel::LocationModel(QObject *parent)
     }
 
     setAvailableDatabases(databases);
+
+    //pack sectors nobody looked at for a while
+    m_coldStorageTimer = new QTimer(this);
+    m_coldStorageTimer->setInterval(ColdStorageInterval);
+
+    connect(m_coldStorageTimer, &QTimer::timeout, this, &LocationModel::freezeIdleSectors);
+
+    //usage is published with the other counters
+    connect(m_metrics, &PipelineMetrics::updated, this, &LocationModel::memoryUsageChanged);
+
+    m_coldStorageTimer->start();
+
+    //replay frames
+    m_replayTimer = new QTimer(this);
+    m_replayTimer->setInterval(ReplayFrameInterval);
+    m_replayTimer->setTimerType(Qt::PreciseTimer);
+
+    connect(m_replayTimer, &QTimer::timeout, this, &LocationModel::advanceReplay);
+
+    //imports keep their own watcher, the other operations disconnect the shared one when they start
+    connect(&m_importWatcher, &QFutureWatcher<void>::finished, this, &LocationModel::finishImport);
+
+    //leave the rest of the cores to loading and clustering
+    m_heatmapPool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() / 2));
+
+    //the ingest of an import keeps one core to itself
+    m_importPool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+    m_exportPool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+
+    //guesses only get the cores nothing else wants
+    m_prefetchPool.setMaxThreadCount(1);
+    m_prefetchPool.setThreadPriority(QThread::LowestPriority);
+
+    //one query at a time, the newest waiting one is the only one that matters
+    m_searchPool.setMaxThreadCount(1);
 }
 
 LocationModel::~LocationModel()
 {
+    ++m_prefetchGeneration;
+    m_prefetchPool.clear();
+    m_prefetchPool.waitForDone();
+
+    m_heatmapPool.clear();
+    m_heatmapPool.waitForDone();
+
+    ++m_searchGeneration;
+    m_searchPool.clear();
+    m_searchPool.waitForDone();
+
     if(m_updateTimer)
         delete m_updateTimer;
 
@@ -53,52 +100,62 @@ int LocationModel::rowCount(const QModelIndex &parent) const
 
 QVariant LocationModel::data(const QModelIndex &index, int role) const
 {
-    if(!index.isValid())
+    if(!index.isValid() || index.row() >= m_filteredData.count())
         return QVariant();
 
-    QVariant data;
+    return roleData(m_filteredData[index.row()], role);
+}
+
+//delegates request every role at once, so resolve the row a single time
+void LocationModel::multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const
+{
+    if(!index.isValid() || index.row() >= m_filteredData.count())
+    {
+        for(QModelRoleData &data : roleDataSpan)
+            data.clearData();
+
+        return;
+    }
+
+    const LocationCluster &cluster = m_filteredData[index.row()];
+
+    for(QModelRoleData &data : roleDataSpan)
+        data.setData(roleData(cluster, data.role()));
+}
 
+QVariant LocationModel::roleData(const LocationCluster &cluster, int role) const
+{
     switch(static_cast<LocationDataRole>(role))
     {
     case LocationRole:
-        data = QVariant::fromValue<QGeoCoordinate>(m_filteredData[index.row()].coordinates);
-        break;
+        return QVariant::fromValue<QGeoCoordinate>(cluster.coordinates);
     case NameRole:
-        data = QVariant::fromValue<QString>(m_filteredData[index.row()].name);
-        break;
+        return QVariant::fromValue<QString>(cluster.name);
     case StyleRole:
-        data = QVariant::fromValue<QString>(m_filteredData[index.row()].styleTag);
-        break;
+        return QVariant::fromValue<QString>(cluster.styleTag);
     case DescriptionRole:
-        data = QVariant::fromValue<QString>(m_filteredData[index.row()].description);
-        break;
+        return QVariant::fromValue<QString>(cluster.description);
     case OpenNetworksRole:
-        data = QVariant::fromValue<int>(m_filteredData[index.row()].open);
-        break;
+        return QVariant::fromValue<int>(cluster.open);
     case TypeRole:
-        data = QVariant::fromValue<QString>(m_filteredData[index.row()].type);
-        break;
+        return QVariant::fromValue<QString>(cluster.type);
     case EncryptionRole:
-        data = QVariant::fromValue<QString>(m_filteredData[index.row()].encryption);
-        break;
+        return QVariant::fromValue<QString>(cluster.encryption);
     case TimestampRole:
-        data = QVariant::fromValue<qreal>(m_filteredData[index.row()].timestamp.toMSecsSinceEpoch());
-        break;
+        return QVariant::fromValue<qint64>(cluster.timestamp);
     case AccuracyRole:
-        data = QVariant::fromValue<qreal>(m_filteredData[index.row()].accuracy);
-        break;
+        return QVariant::fromValue<qreal>(cluster.accuracy);
     case SignalRole:
-        data = QVariant::fromValue<qreal>(m_filteredData[index.row()].signal);
-        break;
+        return QVariant::fromValue<qreal>(cluster.signal);
     case ColorRole:
-        data = QVariant::fromValue<QColor>(m_filteredData[index.row()].color);
-        break;
+        return QVariant::fromValue<QColor>(cluster.color);
     case SizeRole:
-        data = QVariant::fromValue<qreal>(m_filteredData[index.row()].dotSize);
-        break;
+        return QVariant::fromValue<qreal>(cluster.dotSize);
+    case ClusterCountRole:
+        return QVariant::fromValue<qint64>(cluster.clusterCount);
     }
 
-    return data;
+    return QVariant();
 }
 
 QHash<int, QByteArray> LocationModel::roleNames() const
@@ -115,7 +172,8 @@ QHash<int, QByteArray> LocationModel::roleNames() const
         { AccuracyRole, "accuracy" },
         { SignalRole, "signal" },
         { ColorRole, "dotColor" },
-        { SizeRole, "dotSize" }
+        { SizeRole, "dotSize" },
+        { ClusterCountRole, "clusterCount" }
     };
 
     return roleMap;
@@ -134,400 +192,429 @@ double LocationModel::logScale(double percentage, double min, double max)
     return max * std::pow(min / max, percentage);
 }
 
-void LocationModel::parseCSV(QString fileName)
+void LocationModel::openFile(QString fileName)
+{
+    openFiles({ fileName });
+}
+
+void LocationModel::openDirectory(QString path)
+{
+    openFiles({ path });
+}
+
+void LocationModel::openFiles(QStringList fileNames)
+{
+    QStringList imports;
+
+    for(QString fileName : std::as_const(fileNames))
+    {
+#ifdef Q_OS_WIN
+        //damn windows
+        if(fileName.startsWith("file:///", Qt::CaseInsensitive))
+            fileName.remove(0,8);
+#endif
+#ifdef Q_OS_LINUX
+        if(fileName.startsWith("file://", Qt::CaseInsensitive))
+            fileName.remove(0,7);
+#endif
+
+        QFileInfo info(fileName);
+
+        //directories are searched for anything the parsers can read
+        if(info.isDir())
+        {
+            QDirIterator iterator(info.absoluteFilePath(), { "*.csv", "*.kml" }, QDir::Files, QDirIterator::Subdirectories);
+            QStringList found;
+
+            while(iterator.hasNext())
+                found.append(iterator.next());
+
+            found.sort();
+            imports += found;
+        }
+        else if(WigleParser::format(fileName) != WigleParser::Unknown)
+            imports.append(info.absoluteFilePath());
+        else
+            qDebug() << "Skipping" << fileName << "unsupported file type";
+    }
+
+    if(imports.isEmpty())
+    {
+        errorOccurred("File Error", "No WiGLE CSV or KML files to import.");
+        return;
+    }
+
+    m_pendingImports += imports;
+
+    //files opened while an import runs go in the next pass, files opened while a load streams in wait
+    //for it so they are deduplicated against every stored ID
+    if(!m_importing && !m_streaming)
+        startImport();
+}
+
+void LocationModel::startImport()
 {
-    startLoading(QString("Importing file into database `%1`").arg(m_loadedDatabase));
+    m_importing = true;
+    emit importingChanged();
+
+    QList<QSharedPointer<ImportFile>> files;
+
+    for(const QString &fileName : std::as_const(m_pendingImports))
+    {
+        QSharedPointer<ImportFile> file(new ImportFile);
+        file->fileName = fileName;
+        file->size = QFileInfo(fileName).size();
+        files.append(file);
+    }
+
+    m_pendingImports.clear();
+    m_importFiles = files;
+    updateImportProgress();
+
+    startLoading(files.count() == 1 ? QString("Importing file into database `%1`").arg(m_loadedDatabase) :
+                                      QString("Importing %1 files into database `%2`").arg(files.count()).arg(m_loadedDatabase));
 
     m_totalPointsOfInterestTemp = m_totalPointsOfInterest;
     m_bluetoothPointsOfInterestTemp = m_bluetoothPointsOfInterest;
     m_cellularPointsOfInterestTemp = m_cellularPointsOfInterest;
     m_wifiPointsOfInterestTemp = m_wifiPointsOfInterest;
 
-    auto result = QtConcurrent::run([this, fileName] {
-        QDateTime first = QDateTime::fromMSecsSinceEpoch(0);
-        QDateTime last = QDateTime::fromMSecsSinceEpoch(0);
+    QString database = m_loadedDatabase;
+    quint64 generation = m_loadGeneration;
 
-        quint64 imported = 0;
+    m_importWatcher.setFuture(QtConcurrent::run([this, files, database, generation]() {
+        importFiles(files, database, generation);
+    }));
+}
 
-        QFile file(fileName);
+//runs the parsers on the import pool and ingests everything they produce on the calling thread
+void LocationModel::importFiles(const QList<QSharedPointer<ImportFile>> &files, const QString &database, quint64 generation)
+{
+    TraceSpan span("import", "import");
 
-        qDebug() << "Opening file" << fileName;
+    qint64 totalBytes = 0;
 
-        if(!file.exists())
-        {
-            qDebug() << "Couldnt open file " + file.errorString();
-            errorOccurred("File Error", "Could not open file due to invalid filename or path.");
-            return;
-        }
+    for(const QSharedPointer<ImportFile> &file : files)
+        totalBytes += file->size;
 
-        if(!file.open(QFile::ReadOnly))
-        {
-            qDebug() << "Couldnt open file " + file.errorString();
-            errorOccurred("File Error", "Could not open file. " + file.errorString());
-            return;
-        }
+    m_metrics->begin(totalBytes);
+    auto metricsGuard = qScopeGuard([this]() { m_metrics->end(); });
 
-        bool valid = false;
+    ImportQueue queue(files.count());
+    QFutureSynchronizer<void> parsers;
 
-        while(!file.atEnd())
-        {
-            QString line = file.readLine();
+    for(int index = 0; index < files.count(); ++index)
+    {
+        parsers.addFuture(QtConcurrent::run(&m_importPool, [this, &queue, file = files[index], index]() {
+            parseImportFile(queue, file.data(), index);
+        }));
+    }
 
-            //pre-header and header information not currently being used
-            if(line.startsWith("wigle", Qt::CaseInsensitive) || line.startsWith("mac,ssid", Qt::CaseInsensitive))
-            {
-                if(line.startsWith("wigle", Qt::CaseInsensitive))
-                    valid = true; //eventually change this to properly validate versions
+    //one connection and one transaction for the whole import, after any streaming load let go of the database
+    QMutexLocker databaseLocker(&m_databaseMutex);
 
-                setProgress(file.pos() / file.size());
-                continue;
+    QString connection = QString("wdrvr_import_%1").arg(reinterpret_cast<quintptr>(this));
+    quint64 pending = 0;
+    quint64 failedWrites = 0;
+
+    //sectors that got rows since the last publish
+    QSet<quint32> importedSectors;
+    QElapsedTimer publishTimer;
+    publishTimer.start();
+
+    {
+        QSqlDatabase sqlDatabase = QSqlDatabase::addDatabase("QSQLITE", connection);
+        sqlDatabase.setDatabaseName(getDatabaseDirectory(database).absoluteFilePath(database + ".db"));
+
+        bool writing = sqlDatabase.open();
+
+        if(!writing)
+            qDebug() << "Could not open database" << database << sqlDatabase.lastError();
+
+        QSqlQuery insert(sqlDatabase);
+        writing = writing && sqlDatabase.transaction() && prepareInsert(insert);
+
+        ImportBatch batch;
+
+        while(queue.pop(batch))
+        {
+            //a newer load threw the sectors away, the rest of the files would land in the wrong database
+            if(generation != m_loadGeneration)
+            {
+                queue.cancel();
+                writing = false;
+                sqlDatabase.rollback();
+                break;
             }
 
-            // if(!valid)
-            // {
-            //     errorOccurred("CSV Error", "File is not a valid Wigle CSV file");
-            //     return;
-            // }
+            TraceSpan chunk("ingest batch", "import");
+            chunk.setCount(batch.rows.count());
 
-            QStringList segments = line.split(',');
+            ImportFile *file = files[batch.file].data();
 
-            if(segments.count() != 14)
-                continue;
+            for(const LocationData &data : std::as_const(batch.rows))
+            {
+                bool local = false;
+                bool shown = append(data, false, &local);
 
-            QString capabilitiesString = segments[2];
-            capabilitiesString.replace("][", " ");
-            capabilitiesString.remove("[");
-            capabilitiesString.remove("]");
+                //IDs only an attached database has are written without showing a second copy
+                if(!local)
+                {
+                    ++file->duplicates;
+                    continue;
+                }
 
-            QStringList capabilities = capabilitiesString.split(' ', Qt::SkipEmptyParts);
-            QDateTime timestamp;
+                ++file->rows;
 
-            bool okay = false;
-            quint64 ms = segments[3].toLongLong(&okay);
+                if(shown)
+                {
+                    ++m_totalPointsOfInterestTemp;
+                    importedSectors.insert(SectorDirectory::sectorId(SectorDirectory::column(data.coordinates.longitude()), SectorDirectory::row(data.coordinates.latitude())));
+                }
 
-            if(okay)
-                timestamp = QDateTime::fromMSecsSinceEpoch(ms);
+                if(!writing)
+                    continue;
 
-            if(!timestamp.isValid()) //fallback attempt
-                timestamp = QDateTime::fromString(segments[3],QString("yyyy-MM-ddThh:mm:sstt"));
+                bindInsert(insert, data);
 
-            if(!timestamp.isValid()) //fallback attempt 2
-                timestamp = QDateTime::fromString(segments[3],QString("yyyy-MM-ddThh:mm:ss.zzzt"));
+                //uncommitted rows count as the writer queue
+                if(insert.exec())
+                {
+                    m_metrics->addWrites(1);
+                    ++pending;
+                }
+                else if(++failedWrites == 1)
+                    qDebug() << "Failed to save database" << database << insert.lastError();
+            }
 
-            if(!timestamp.isValid()) //well crap
+            //the map fills in while the import runs
+            if(publishTimer.elapsed() > ImportPublishInterval && !importedSectors.isEmpty())
             {
-                errorOccurred("Document Parsing Error", "Document uses an invalid timestamp format. Aborting.");
-                file.close();
+                m_importedSectorsMutex.lock();
+                m_importedSectors.unite(importedSectors);
+                m_importedSectorsMutex.unlock();
 
-                return;
+                importedSectors.clear();
+                QMetaObject::invokeMethod(this, &LocationModel::publishImportedSectors, Qt::QueuedConnection);
+                publishTimer.restart();
             }
+        }
+
+        if(writing)
+        {
+            TraceSpan commitSpan("commit", "sql");
+            commitSpan.setCount(pending);
 
-            LocationData data {
-                segments[10].toDouble(),
-                1,
-                QGeoCoordinate(segments[7].toDouble(), segments[8].toDouble(), segments[9].toDouble()),
-                "",
-                segments[2],
-                segments[0],
-                segments[1],
-                segments[4].toInt(),
-                segments[6].toDouble(),
-                "", //don't know how wigle calculates style tags
-                segments[13],
-                timestamp,
-                segments[12],
-                segments[5].toDouble(),
-                capabilities,
-                segments[11].split(' ', Qt::SkipEmptyParts)
-            };
-
-            if(first == QDateTime::fromMSecsSinceEpoch(0) || data.timestamp < first)
-                first = data.timestamp;
-            if(last == QDateTime::fromMSecsSinceEpoch(0) || data.timestamp > last)
-                last = data.timestamp;
-
-            append(data);
-            setProgress(file.pos() / file.size());
-
-            ++imported; //for mps
+            if(!sqlDatabase.commit())
+            {
+                qDebug() << "Failed to commit import" << database << sqlDatabase.lastError();
+                errorOccurred("Database Error", "Could not write the imported rows. " + sqlDatabase.lastError().text());
+            }
         }
 
-        quint64 totalSecs = last.toSecsSinceEpoch() - first.toSecsSinceEpoch();
+        m_metrics->addWrites(-static_cast<qint64>(pending));
 
-        m_mps.append(static_cast<qreal>(imported) / totalSecs);
+        insert.finish();
+        sqlDatabase.close();
+    }
 
-        file.close();
-    });
+    QSqlDatabase::removeDatabase(connection);
+    databaseLocker.unlock();
 
-    watcher.setFuture(result);
+    //the rest is published by finishImport()
+    m_importedSectorsMutex.lock();
+    m_importedSectors.unite(importedSectors);
+    m_importedSectorsMutex.unlock();
 
-    connect(&watcher, &QFutureWatcher<void>::finished, this, [this](){
+    parsers.waitForFinished();
 
-        calculateMPS();
-
-        emit lteStatsChanged();
-        emit bluetoothStatsChanged();
-        emit bluetoothLEStatsChanged();
-        emit gsmStatsChanged();
-        emit cdmaStatsChanged();
-        emit wcdmaStatsChanged();
-        emit lteStatsChanged();
-        emit nrStatsChanged();
-        emit wifiStatsChanged();
-
-        setTotalPointsOfInterest(m_totalPointsOfInterestTemp);
-        setBluetoothPointsOfInterest(m_bluetoothPointsOfInterestTemp);
-        setWifiPointsOfInterest(m_wifiPointsOfInterestTemp);
-        setCellularPointsOfInterest(m_cellularPointsOfInterestTemp);
-        endLoading();
-    });
+    if(failedWrites)
+        qDebug() << failedWrites << "rows failed to save";
+
+    QStringList failures;
+
+    for(const QSharedPointer<ImportFile> &file : files)
+    {
+        if(!file->error.isEmpty())
+            failures.append(QString("%1: %2").arg(QFileInfo(file->fileName).fileName(), file->error));
+
+        quint64 totalSecs = (file->last - file->first) / 1000;
+
+        if(totalSecs)
+            m_mps.append(static_cast<qreal>(file->rows) / totalSecs);
+    }
+
+    span.setCount(m_totalPointsOfInterestTemp - m_totalPointsOfInterest);
+
+    if(!failures.isEmpty())
+        errorOccurred("Import Error", "Some files were not imported completely.\n" + failures.join('\n'));
 }
 
-void LocationModel::parseKML(QString fileName)
+//parser side of importFiles(), runs on the import pool
+void LocationModel::parseImportFile(ImportQueue &queue, ImportFile *file, int index)
 {
-    startLoading(QString("Importing file into database `%1`").arg(m_loadedDatabase));
+    auto finished = qScopeGuard([&queue]() { queue.finish(); });
 
-    auto result = QtConcurrent::run([this, fileName] {
-        QDateTime first = QDateTime::fromMSecsSinceEpoch(0);
-        QDateTime last = QDateTime::fromMSecsSinceEpoch(0);
+    QFile device(file->fileName);
+    qDebug() << "Opening file" << file->fileName;
 
-        if(!m_threadMutex.tryLock(QDeadlineTimer(1500)))
-            return;
+    if(!device.open(QFile::ReadOnly))
+    {
+        qDebug() << "Couldnt open file " + device.errorString();
+        file->error = "Could not open file. " + device.errorString();
+        file->state.storeRelease(ImportFile::Failed);
+        m_metrics->addPosition(file->size);
+        return;
+    }
 
-        QFile file(fileName);
-        qDebug() << "Opening file" << fileName;
+    file->state.storeRelaxed(ImportFile::Parsing);
 
-        if(!file.exists())
-        {
-            qDebug() << "Couldnt open file " + file.errorString();
-            errorOccurred("File Error", "Could not open file due to invalid filename or path.");
-            return;
-        }
+    ImportBatch batch { index, {} };
+    batch.rows.reserve(ImportBatchRows);
+
+    qint64 reported = 0;
+    bool cancelled = false;
+
+    //positions go to the metrics per batch, not per row
+    auto report = [this, file, &reported](qint64 position) {
+        m_metrics->addPosition(position - reported);
+        file->position.storeRelaxed(position);
+        reported = position;
+    };
 
-        if(!file.open(QFile::ReadOnly))
+    WigleParser::Result result = WigleParser::parse(&device, WigleParser::format(file->fileName), [&](LocationData &data, qint64 position) {
+        batch.rows.append(std::move(data));
+
+        if(batch.rows.count() < ImportBatchRows)
+            return true;
+
+        report(position);
+
+        if(!queue.push(std::move(batch)))
         {
-            qDebug() << "Couldnt open file " + file.errorString();
-            errorOccurred("File Error", "Could not open file. " + file.errorString());
-            return;
+            cancelled = true;
+            return false;
         }
 
-        QXmlStreamReader xml(&file);
-        quint64 loop = 0;
+        batch = ImportBatch { index, {} };
+        batch.rows.reserve(ImportBatchRows);
 
-        m_totalPointsOfInterestTemp = m_totalPointsOfInterest;
-        m_bluetoothPointsOfInterestTemp = m_bluetoothPointsOfInterest;
-        m_cellularPointsOfInterestTemp = m_cellularPointsOfInterest;
-        m_wifiPointsOfInterestTemp = m_wifiPointsOfInterest;
+        return true;
+    });
 
-        quint64 imported = 0;
+    if(!cancelled && !batch.rows.isEmpty())
+        queue.push(std::move(batch));
 
-        while(!xml.atEnd())
-        {
-            setProgress(static_cast<qreal>(file.pos()) / file.size());
+    //whatever the parser skipped at the end still counts as done
+    report(file->size);
 
-            xml.readNextStartElement();
-            QString elementName = xml.name().toString().toLower();
-            if(elementName.toLower() == "placemark")
-            {
-                LocationData data;
+    file->error = result.error;
+    file->first = result.first;
+    file->last = result.last;
+    file->state.storeRelease(result.error.isEmpty() ? ImportFile::Done : ImportFile::Failed);
 
-                bool placemark = true;
-                while(placemark)
-                {
-                    //read by element type to catch the end of the placemark
-                    xml.readNext();
-                    elementName = xml.name().toString().toLower();
+    device.close();
+}
 
-                    if(xml.isEndElement() && elementName == "placemark")
-                    {
-                        placemark = false;
-                        continue;
-                    }
-                    else if(!xml.isStartElement())
-                        continue;
+void LocationModel::finishImport()
+{
+    calculateMPS();
 
-                    QString markerAttribute = xml.name().toString().toLower();
-
-                    if(markerAttribute == "name")
-                        data.name = xml.readElementText();
-
-                    else if(markerAttribute == "description")
-                    {
-                        QString description = xml.readElementText();
-                        QString descriptionValue = description;
-
-                        //remove newlines, they are not a reliable separator for this block
-                        description.replace('\n', ' ');
-                        QStringList lines = description.split(m_kmlDescriptionSeparator);
-
-                        for(const QString &line : std::as_const(lines))
-                        {
-                            QStringList descriptorParts = line.split(QString(": "), Qt::SkipEmptyParts);
-
-                            if(descriptorParts.count() > 1)
-                            {
-                                QString key = descriptorParts.takeAt(0).toLower();
-                                QString value = descriptorParts.join(':');
-
-                                if(key == "type")
-                                    data.type = value;
-                                else if(key == "encryption")
-                                    data.encryption = value;
-                                else if(key == "capabilities")
-                                {
-                                    QString capabilitiesString = value;
-                                    capabilitiesString.remove("[");
-                                    capabilitiesString.remove("]");
-
-                                    data.capabilities = capabilitiesString.split("][", Qt::SkipEmptyParts);
-                                }
-                                else if(key == "frequency")
-                                    data.frequency = value.toDouble();
-                                else if(key == "time")//"2025-05-29T08:45:33.000-07:00" OR MS Since Epoch
-                                {
-
-                                    bool okay = false;
-                                    quint64 ms = value.toLongLong(&okay);
-
-                                    if(okay)
-                                        data.timestamp = QDateTime::fromMSecsSinceEpoch(ms);
-
-                                    if(!okay || !data.timestamp.isValid()) //fallback attempt
-                                        data.timestamp = QDateTime::fromString(value,QString("yyyy-MM-ddThh:mm:sstt"));
-
-                                    if(!data.timestamp.isValid()) //fallback attempt 2
-                                        data.timestamp = QDateTime::fromString(value,QString("yyyy-MM-ddThh:mm:ss.zzzt"));
-
-                                    if(!data.timestamp.isValid()) //well crap
-                                    {
-                                        errorOccurred("Document Parsing Error", "Document uses an invalid timestamp format. Aborting.");
-                                        file.close();
-
-                                        return;
-                                    }
-                                }
-                                else if(key == "signal")
-                                    data.signal = value.toDouble();
-                                else if(key == "network id" || key == "id")
-                                    data.id = value;
-                            }
-                        }
-
-                        data.description = descriptionValue;
-                    }
-
-                    else if(markerAttribute == "styleurl")
-                        data.styleTag = xml.readElementText();
-
-                    else if(markerAttribute == "point")
-                    {
-                        bool position = true;
-                        while(position)
-                        {
-                            xml.readNext();
-                            elementName = xml.name().toString().toLower();
-
-                            if(xml.isEndElement() && elementName == "point")
-                            {
-                                position = false;
-                                continue;
-                            }
-                            else if(!xml.isStartElement())
-                                continue;
-
-                            QString positionAttribute = xml.name().toString().toLower();
-
-                            if(positionAttribute == "coordinates")
-                            {
-                                QString coordinateString = xml.readElementText();
-                                QStringList coordinateList = coordinateString.split(',');
-
-                                if(coordinateList.count() == 2)
-                                {
-                                    //wiggle has them backwards
-                                    qreal x = coordinateList[1].toDouble();
-                                    qreal y = coordinateList[0].toDouble();
-
-                                    data.coordinates = QGeoCoordinate(x, y);
-                                }
-                            }
-                        }
-                    }
-
-                    else if(markerAttribute == "open")
-                        data.open = xml.readElementText().toInt();
-                }
+    //only the tiles of the sectors added since the last publish are clustered again
+    publishImportedSectors();
 
-                if(first == QDateTime::fromMSecsSinceEpoch(0) || data.timestamp < first)
-                    first = data.timestamp;
-                if(last == QDateTime::fromMSecsSinceEpoch(0) || data.timestamp > last)
-                    last = data.timestamp;
+    updateImportProgress();
+    m_importing = false;
+    emit importingChanged();
 
-                this->append(data);
-                ++m_totalPointsOfInterestTemp;
-                ++imported;
-            }
-        }
+    endLoading();
 
-        file.close();
+    //files opened while the last pass ran
+    if(!m_pendingImports.isEmpty() && !m_streaming)
+        startImport();
+}
+
+//model thread, the background load is done with the database, imports waiting for it can start. A
+//newer load keeps streaming
+void LocationModel::endStreaming(quint64 generation)
+{
+    if(generation != m_loadGeneration)
+        return;
 
-        quint64 totalSecs = last.toSecsSinceEpoch() - first.toSecsSinceEpoch();
+    m_streaming = false;
 
-        m_mps.append(static_cast<qreal>(imported) / totalSecs);
+    if(!m_importing && !m_pendingImports.isEmpty())
+        startImport();
+}
 
-        if(xml.hasError())
-        {
-            qDebug() << xml.errorString();
-        }
+//model thread, shows the rows the ingest added since the last call without a full query
+void LocationModel::publishImportedSectors()
+{
+    m_importedSectorsMutex.lock();
+    QSet<quint32> sectorIds = std::exchange(m_importedSectors, QSet<quint32>());
+    m_importedSectorsMutex.unlock();
+
+    if(sectorIds.isEmpty())
+        return;
 
-        qDebug() << "Parsed" << m_totalPointsOfInterestTemp - m_totalPointsOfInterest << "POIs";
+    TraceSpan span("publish import", "model");
+    span.setCount(sectorIds.count());
 
-        if(m_debug)
+    publishCounters();
+
+    //sectors off screen only change the counters, the tiles on screen notice their own stamps
+    QGeoRectangle viewport = m_viewportArea.boundingGeoRectangle();
+
+    for(quint32 id : std::as_const(sectorIds))
+    {
+        QGeoCoordinate southWest(SectorDirectory::latitudeOf(id), SectorDirectory::longitudeOf(id));
+        QGeoRectangle sectorBounds(QGeoCoordinate(southWest.latitude() + SectorDirectory::SectorSize, southWest.longitude()),
+                                   QGeoCoordinate(southWest.latitude(), southWest.longitude() + SectorDirectory::SectorSize));
+
+        if(!viewport.isValid() || viewport.intersects(sectorBounds))
         {
-            // need an updated verification
+            emit sectorsUpdated();
+            break;
         }
+    }
+}
 
-        m_threadMutex.unlock();
-    });
-    watcher.setFuture(result);
-
-    connect(&watcher, &QFutureWatcher<void>::finished, this, [this](){
-        calculateMPS();
-
-        emit lteStatsChanged();
-        emit bluetoothStatsChanged();
-        emit bluetoothLEStatsChanged();
-        emit gsmStatsChanged();
-        emit cdmaStatsChanged();
-        emit wcdmaStatsChanged();
-        emit lteStatsChanged();
-        emit nrStatsChanged();
-        emit wifiStatsChanged();
-
-        setTotalPointsOfInterest(m_totalPointsOfInterestTemp);
-        setBluetoothPointsOfInterest(m_bluetoothPointsOfInterestTemp);
-        setWifiPointsOfInterest(m_wifiPointsOfInterestTemp);
-        setCellularPointsOfInterest(m_cellularPointsOfInterestTemp);
-        endLoading();
-    });
+bool LocationModel::importing() const
+{
+    return m_importing;
 }
 
-void LocationModel::openFile(QString fileName)
+void LocationModel::updateImportProgress()
 {
-#ifdef Q_OS_WIN
-    //damn windows
-    if(fileName.startsWith("file:///", Qt::CaseInsensitive))
-        fileName.remove(0,8);
-#endif
-#ifdef Q_OS_LINUX
-    if(fileName.startsWith("file://", Qt::CaseInsensitive))
-        fileName.remove(0,7);
-#endif
+    QVariantList importProgress;
+
+    static const char *states[] { "queued", "parsing", "done", "failed" };
+
+    for(const QSharedPointer<ImportFile> &file : std::as_const(m_importFiles))
+    {
+        QVariantMap entry;
+        entry["fileName"] = QFileInfo(file->fileName).fileName();
+        entry["progress"] = file->size > 0 ? std::clamp(static_cast<qreal>(file->position.loadRelaxed()) / file->size, 0.0, 1.0) : 1.0;
+        entry["rows"] = file->rows.loadRelaxed();
+        entry["duplicates"] = file->duplicates.loadRelaxed();
+        entry["state"] = states[file->state.loadAcquire()];
+
+        if(file->state.loadAcquire() == ImportFile::Failed)
+            entry["error"] = file->error;
 
-    if(fileName.endsWith(".kml", Qt::CaseInsensitive))
-        parseKML(fileName);
-    else if(fileName.endsWith(".csv", Qt::CaseInsensitive))
-        parseCSV(fileName);
+        importProgress.append(entry);
+    }
+
+    if(m_importProgress == importProgress)
+        return;
+
+    m_importProgress = importProgress;
+    emit importProgressChanged();
+}
+
+QVariantList LocationModel::importProgress() const
+{
+    return m_importProgress;
 }
 
 qreal LocationModel::progress() const
@@ -548,129 +635,199 @@ void LocationModel::setProgress(qreal progress)
     m_progress = progress;
 }
 
-void LocationModel::append(const LocationData &data, bool save)
+bool LocationModel::append(const LocationData &data, bool save, bool *local)
 {
-    if(m_ids.contains(data.id))
-    {
-        m_ids[data.id] = m_ids[data.id] + 1;
-        return;
-    }
-
-    m_ids.insert(data.id, 1);
-
-    int latitudeIndex = std::floor(data.coordinates.latitude() + 90);
-    int longitudeIndex = std::floor(data.coordinates.longitude() + 180);
+    bool shown = false;
+    bool newLocal = false;
 
-    m_sectors[longitudeIndex][latitudeIndex].mutex.lock();
+    //every ID is shown once, but whether the loaded database has it is tracked on its own so rows
+    //an attached database already shows still get written to the loaded one
+    m_idsMutex.lock();
 
-    ++m_sectors[longitudeIndex][latitudeIndex].locations;
+    auto id = m_ids.find(data.id);
 
-    //construct the first POI for the sector
-    if(!m_sectors[longitudeIndex][latitudeIndex].head)
+    if(id == m_ids.end())
     {
-        m_sectors[longitudeIndex][latitudeIndex].head = new LocationDataNode(data);
-        m_sectors[longitudeIndex][latitudeIndex].last = m_sectors[longitudeIndex][latitudeIndex].head;
+        m_ids.insert(data.id, data.source | (data.source == 0 ? LoadedId : 0));
+        shown = true;
+        newLocal = data.source == 0;
     }
-
-    //otherwise add it to the end of the element
-    else
+    else if(data.source == 0 && !(id.value() & LoadedId))
     {
-        m_sectors[longitudeIndex][latitudeIndex].last->next = new LocationDataNode(data);
-        m_sectors[longitudeIndex][latitudeIndex].last = m_sectors[longitudeIndex][latitudeIndex].last->next;
+        id.value() |= LoadedId;
+        newLocal = true;
     }
 
-    m_sectors[longitudeIndex][latitudeIndex].updated = true;
-    m_sectors[longitudeIndex][latitudeIndex].mutex.unlock();
+    m_idsMutex.unlock();
 
-    if(save)
+    if(local)
+        *local = newLocal;
+
+    if(!shown)
     {
-        m_databaseMutex.lock();
-        addToDataBase(data);
-        m_databaseMutex.unlock();
+        m_metrics->addRow(!newLocal);
+
+        if(save && newLocal)
+            storeRow(data);
+
+        return false;
     }
 
-    //set type stats
-    if(bluetoothTypeKeys.contains(data.type))
+    m_metrics->addRow();
+
+    m_searchIndex.append(data);
+
+    //widen the timeline
+    if(data.timestamp > 0)
     {
-        if(data.type.toLower() == "bt")
-            ++m_bluetoothStats;
-        else if(data.type.toLower() == "ble")
-            ++m_bluetoothLEStats;
+        qint64 earliest = m_earliestTimestamp.loadRelaxed();
+        while((earliest == 0 || data.timestamp < earliest) && !m_earliestTimestamp.testAndSetRelaxed(earliest, data.timestamp, earliest));
 
-        ++m_bluetoothPointsOfInterestTemp;
+        qint64 latest = m_latestTimestamp.loadRelaxed();
+        while(data.timestamp > latest && !m_latestTimestamp.testAndSetRelaxed(latest, data.timestamp, latest));
     }
 
-    else if(cellTypeKeys.contains(data.type))
-    {
-        if(data.type.toLower() == "lte")
-            ++m_lteStats;
-        else if(data.type.toLower() == "nr")
-            ++m_nrStats;
-        else if(data.type.toLower() == "gsm")
-            ++m_gsmStats;
-        else if(data.type.toLower() == "wcdma")
-            ++m_wcdmaStats;
-        else if(data.type.toLower() == "cdma")
-            ++m_cdmaStats;
+    //counted before the revision moves, a heatmap tile drawn from the cells in between is only redrawn once more
+    AreaStats::Radio radio = m_aggregates.append(data);
 
-        ++m_cellularPointsOfInterestTemp;
+    Sector *sector = m_sectors.findOrCreate(data.coordinates.latitude(), data.coordinates.longitude());
+
+    sector->mutex.lock();
+
+    thawSector(sector);
+    sector->lastAccess = QDateTime::currentMSecsSinceEpoch();
+    ++sector->locations;
+    ++sector->revision;
+
+    if(sector->locations == 1 || data.timestamp < sector->earliest)
+        sector->earliest = data.timestamp;
+    if(sector->locations == 1 || data.timestamp > sector->latest)
+        sector->latest = data.timestamp;
+
+    //construct the first POI for the sector
+    if(!sector->head)
+    {
+        sector->head = new LocationDataNode(data);
+        sector->last = sector->head;
     }
 
-    else if(wifiTypeKeys.contains(data.type) || data.type.isEmpty())
+    //otherwise add it to the end of the element
+    else
     {
-        ++m_wifiStats;
-        ++m_wifiPointsOfInterestTemp;
+        sector->last->next = new LocationDataNode(data);
+        sector->last = sector->last->next;
     }
-}
 
-void LocationModel::sort()
-{
-    startLoading("Sorting");
+    if(sector->index)
+        sector->index->append(sector->last);
 
-    watcher.disconnect();
-    watcher.setFuture(QtConcurrent::run([this](){
-        for(int longitudeIndex = 0; longitudeIndex < 360; ++longitudeIndex)
-        {
-            for(int latitudeIndex = 0; latitudeIndex < 180; ++latitudeIndex)
-            {
-                if(!m_sectors[longitudeIndex][latitudeIndex].updated || !m_sectors[longitudeIndex][latitudeIndex].head)
-                    continue;
+    accountSector(sector, 1, sector->bytes + nodeBytes(data));
 
-                m_sectors[longitudeIndex][latitudeIndex].mutex.lock();
-                setLoadingTitle(QString("Sorting Sector [%1][%2]").arg(QString::number(longitudeIndex - 180), QString::number(latitudeIndex - 90)));
+    sector->updated = true;
+    sector->mutex.unlock();
 
-                bool op = true;
-                while(op)
-                {
-                    LocationDataNode *node = m_sectors[longitudeIndex][latitudeIndex].head;
-                    op = false;
-
-                    while(node && node->next)
-                    {
-                        LocationDataNode *nextNode = node->next;
-                        qreal nodeDistance = QGeoCoordinate(-90,-180).distanceTo(node->data.coordinates);
-                        qreal nextNodeDistance = QGeoCoordinate(-90,-180).distanceTo(node->next->data.coordinates);
-
-                        if(nodeDistance > nextNodeDistance)
-                        {
-                            node->next = nextNode->next;
-                            nextNode->next = node;
-                            op = true;
-                        }
-
-                        node = node->next;
-                    }
-                }
+    evictSectors();
 
-                m_sectors[longitudeIndex][latitudeIndex].mutex.unlock();
-            }
-        }
-    }));
+    if(save)
+        storeRow(data);
 
-    watcher.connect(&watcher, &QFutureWatcher<void>::finished, this, [this](){
-        endLoading();
-    });
-}
+    //set type stats, the type is only classified once for these and the cell aggregates
+    switch(radio)
+    {
+    case AreaStats::Wifi:
+        ++m_wifiStats;
+        ++m_wifiPointsOfInterestTemp;
+        break;
+    case AreaStats::Bluetooth:
+        ++m_bluetoothStats;
+        ++m_bluetoothPointsOfInterestTemp;
+        break;
+    case AreaStats::BluetoothLE:
+        ++m_bluetoothLEStats;
+        ++m_bluetoothPointsOfInterestTemp;
+        break;
+    case AreaStats::Gsm:
+        ++m_gsmStats;
+        ++m_cellularPointsOfInterestTemp;
+        break;
+    case AreaStats::Cdma:
+        ++m_cdmaStats;
+        ++m_cellularPointsOfInterestTemp;
+        break;
+    case AreaStats::Wcdma:
+        ++m_wcdmaStats;
+        ++m_cellularPointsOfInterestTemp;
+        break;
+    case AreaStats::Lte:
+        ++m_lteStats;
+        ++m_cellularPointsOfInterestTemp;
+        break;
+    case AreaStats::Nr:
+        ++m_nrStats;
+        ++m_cellularPointsOfInterestTemp;
+        break;
+    case AreaStats::OtherRadio:
+    case AreaStats::Radios:
+        break;
+    }
+
+    return true;
+}
+
+void LocationModel::sort()
+{
+    startLoading("Sorting");
+
+    watcher.disconnect();
+    watcher.setFuture(QtConcurrent::run([this](){
+        TraceSpan span("sort", "sort");
+        const QList<Sector*> sectors = m_sectors.sectors();
+
+        for(Sector *sector : sectors)
+        {
+            sector->mutex.lock();
+
+            //packed sectors are already stored in spatial order
+            if(!sector->updated || !sector->head)
+            {
+                sector->mutex.unlock();
+                continue;
+            }
+
+            setLoadingTitle(QString("Sorting Sector [%1][%2]").arg(QString::number(SectorDirectory::longitudeOf(sector->id)), QString::number(SectorDirectory::latitudeOf(sector->id))));
+
+            TraceSpan sectorSpan("sort sector", "sort");
+            sectorSpan.setCount(sector->locations);
+
+            //order by distance from the south west corner of the map
+            QVector<QPair<qreal, LocationDataNode*>> nodes;
+            nodes.reserve(sector->locations);
+
+            for(LocationDataNode *node = sector->head; node; node = node->next)
+                nodes.append(qMakePair(QGeoCoordinate(-90,-180).distanceTo(node->data.coordinates), node));
+
+            std::stable_sort(nodes.begin(), nodes.end(), [](const QPair<qreal, LocationDataNode*> &a, const QPair<qreal, LocationDataNode*> &b) {
+                return a.first < b.first;
+            });
+
+            for(qsizetype i = 0; i < nodes.count(); ++i)
+                nodes[i].second->next = (i + 1 < nodes.count()) ? nodes[i + 1].second : nullptr;
+
+            sector->head = nodes.first().second;
+            sector->last = nodes.last().second;
+
+            //the index addresses nodes by list position
+            delete sector->index;
+            sector->index = nullptr;
+
+            sector->mutex.unlock();
+        }
+    }));
+
+    watcher.connect(&watcher, &QFutureWatcher<void>::finished, this, [this](){
+        endLoading();
+    });
+}
 
 void LocationModel::save()
 {
@@ -678,6 +835,7 @@ void LocationModel::save()
 
     watcher.disconnect();
     watcher.setFuture(QtConcurrent::run([this](){
+        TraceSpan span("save", "sql");
 
         m_databaseMutex.lock();
         QDir databaseDirectory = getDatabaseDirectory();
@@ -703,52 +861,87 @@ void LocationModel::save()
         quint64 totalOps = 0;
         quint64 currentOp = 0;
 
+        const QList<Sector*> sectors = m_sectors.sectors();
+
         //get total ops
-        for(int longitudeIndex = 0; longitudeIndex < 360; ++longitudeIndex)
+        for(const Sector *sector : sectors)
         {
-            for(int latitudeIndex = 0; latitudeIndex < 180; ++latitudeIndex)
-            {
-                if(m_sectors[longitudeIndex][latitudeIndex].updated)
-                    totalOps += m_sectors[longitudeIndex][latitudeIndex].locations;
-            }
+            if(sector->updated)
+                totalOps += sector->locations;
         }
 
+        m_metrics->begin(0, totalOps);
+        m_metrics->addWrites(totalOps);
+
+        auto metricsGuard = qScopeGuard([this, &totalOps, &currentOp]() {
+            m_metrics->addWrites(-static_cast<qint64>(totalOps - std::min(currentOp, totalOps)));
+            m_metrics->end();
+        });
+
         QSqlQuery query(m_sqlDatabase);
 
-        for(int longitudeIndex = 0; longitudeIndex < 360; ++longitudeIndex)
+        for(Sector *sector : sectors)
         {
-            for(int latitudeIndex = 0; latitudeIndex < 180; ++latitudeIndex)
+            QMutexLocker sectorLocker(&sector->mutex);
+            TraceSpan sectorSpan("save sector", "sql");
+            sectorSpan.setCount(sector->locations);
+
+            //write packed and evicted sectors from a temporary copy instead of thawing them for good
+            LocationDataNode *node = sector->head;
+            LocationDataNode *coldHead = nullptr;
+
+            if(!node)
             {
-                LocationDataNode *node = m_sectors[longitudeIndex][latitudeIndex].head;
+                LocationDataNode *coldLast = nullptr;
+                quint64 coldCount = 0;
 
-                while(node)
-                {
-                    LocationData &data = node->data;
-
-                    QString sanitizedDescription = QUrl::toPercentEncoding(data.description);
-                    sanitizedDescription.replace('%', "\%");
-
-                    QString command = QString("INSERT OR REPLACE INTO pois(id, accuracy, longitude, latitude, description, encryption, name, open, signal, style, type, timestamp, mfgid, frequency, capabilities, rois) VALUES(\"%1\",").arg(data.id);
-                    command += QString(" \"%1\", \"%2\", \"%3\"").arg(QString::number(data.accuracy), QString::number(data.coordinates.longitude()), QString::number(data.coordinates.latitude()));
-                    command += QString(", \"%1\", \"%2\", \"%3\"").arg(sanitizedDescription, data.encryption, QUrl::toPercentEncoding(data.name));
-                    command += QString(", \"%1\", \"%2\", \"%3\"").arg(QString::number(data.open), QString::number(data.signal), data.styleTag);
-                    command += QString(", \"%1\", \"%2\", \"%3\"").arg(data.type, data.timestamp.toString(), data.mfgid);
-                    command += QString(", \"%1\", \"%2\", \"%3\")").arg(QString::number(data.frequency), data.capabilities.join(':'), data.rois.join(':'));
-
-                    if(!query.exec(command))
-                    {
-                        qDebug() << "Failed to save database" << m_database;
-                        qDebug() << query.lastError();
-                        qDebug() << command;
-                        m_databaseMutex.unlock();
-                        return;
-                    }
+                SectorCodec::decode(sectorBlock(sector), coldHead, coldLast, coldCount);
+                node = coldHead;
+            }
 
+            while(node)
+            {
+                LocationData &data = node->data;
+
+                //rows of attached databases stay where they came from
+                if(data.source)
+                {
                     node = node->next;
+                    continue;
+                }
+
+                QString sanitizedDescription = QUrl::toPercentEncoding(data.description);
+                sanitizedDescription.replace('%', "\%");
+
+                QString command = QString("INSERT OR REPLACE INTO pois(id, accuracy, longitude, latitude, description, encryption, name, open, signal, style, type, timestamp, mfgid, frequency, capabilities, rois) VALUES(\"%1\",").arg(data.id);
+                command += QString(" \"%1\", \"%2\", \"%3\"").arg(QString::number(data.accuracy), QString::number(data.coordinates.longitude()), QString::number(data.coordinates.latitude()));
+                command += QString(", \"%1\", \"%2\", \"%3\"").arg(sanitizedDescription, data.encryption, QUrl::toPercentEncoding(data.name));
+                command += QString(", \"%1\", \"%2\", \"%3\"").arg(QString::number(data.open), QString::number(data.signal), data.styleTag);
+                command += QString(", \"%1\", \"%2\", \"%3\"").arg(data.type, QString::number(data.timestamp), data.mfgid);
+                command += QString(", \"%1\", \"%2\", \"%3\")").arg(QString::number(data.frequency), data.capabilities.join(':'), data.rois.join(':'));
+
+                if(!query.exec(command))
+                {
+                    qDebug() << "Failed to save database" << m_database;
+                    qDebug() << query.lastError();
+                    qDebug() << command;
+                    SectorDirectory::deleteNodes(coldHead);
+                    m_databaseMutex.unlock();
+                    return;
+                }
+
+                node = node->next;
+
+                setProgress(static_cast<qreal>(++currentOp) / totalOps);
 
-                    setProgress(static_cast<qreal>(++currentOp) / totalOps);
+                if(currentOp <= totalOps)
+                {
+                    m_metrics->addRow();
+                    m_metrics->addWrites(-1);
                 }
             }
+
+            SectorDirectory::deleteNodes(coldHead);
         }
 
         m_databaseMutex.unlock();
@@ -759,323 +952,1530 @@ void LocationModel::save()
     });
 }
 
-void LocationModel::load(QString database)
+void LocationModel::exportFile(QString fileName, bool viewport)
 {
-    startLoading("Loading");
+    if(fileName.startsWith("file://", Qt::CaseInsensitive))
+        fileName = QUrl(fileName).toLocalFile();
 
-    resetSectorData();
-    resetDataModel();
+    LocationExporter exporter(LocationExporter::format(fileName), LocationExporter::compressed(fileName));
 
-    m_bluetoothPointsOfInterestTemp = 0;
-    m_wifiPointsOfInterestTemp = 0;
-    m_totalPointsOfInterestTemp = 0;
-    m_cellularPointsOfInterestTemp = 0;
+    //what the map shows, the filters inside the visible area
+    if(viewport)
+    {
+        exporter.setFilter(m_filter);
+        exporter.setArea(m_viewportArea.boundingGeoRectangle());
+    }
 
-    m_bluetoothStats = 0;
-    m_bluetoothLEStats = 0;
-    m_gsmStats = 0;
-    m_cdmaStats = 0;
-    m_wcdmaStats = 0;
-    m_lteStats = 0;
-    m_nrStats = 0;
-    m_wifiStats = 0;
+    startLoading("Exporting");
 
     watcher.disconnect();
-    watcher.setFuture(QtConcurrent::run([this, database](){
-
-        if(!m_databaseMutex.tryLock(500))
-            return;
-
-        QDir databaseDirectory = getDatabaseDirectory(database);
+    watcher.setFuture(QtConcurrent::run([this, fileName, exporter](){
+        TraceSpan span("export", "export");
+        QFile file(fileName);
 
-        if(m_sqlDatabase.isOpen())
+        if(!file.open(QFile::WriteOnly | QFile::Truncate))
         {
-            m_sqlDatabase.close();
-            QSqlDatabase::removeDatabase(m_sqlDatabase.connectionName());
+            qDebug() << "Couldnt open file " + file.errorString();
+            errorOccurred("Export Error", "Could not open file. " + file.errorString());
+            return;
         }
 
-        m_sqlDatabase = QSqlDatabase::addDatabase("QSQLITE");
-        m_sqlDatabase.setDatabaseName(databaseDirectory.absoluteFilePath(database + ".db"));
+        //the sectors are only locked while a batch is formatted, so a reset never waits for the whole export
+        m_sectorLock.lockForRead();
 
-        if(!m_sqlDatabase.open())
-        {
-            qDebug() << "Could not open database" << database << m_sqlDatabase.lastError();
-            m_databaseMutex.unlock();
-            return;
-        }
+        quint64 generation = m_sectorGeneration;
+        QGeoRectangle area = exporter.area();
+        QList<Sector*> sectors;
 
-        //get DB size
-        QSqlQuery query(m_sqlDatabase);
-        query.prepare(QString("SELECT COUNT(*) FROM pois"));
-        query.exec();
+        //an area across the antimeridian is left to the exporter's own check
+        if(area.isValid() && area.topLeft().longitude() <= area.bottomRight().longitude())
+            sectors = m_sectors.sectorsInRect(SectorDirectory::column(area.topLeft().longitude()), SectorDirectory::column(area.bottomRight().longitude()),
+                                              SectorDirectory::row(area.bottomRight().latitude()), SectorDirectory::row(area.topLeft().latitude()));
+        else
+            sectors = m_sectors.sectors();
 
-        if (query.next()) {
-            m_totalPointsOfInterestTemp = query.value(0).toInt();
-        }
+        //whole sectors per batch, cut by their counts so the batches are about the same work
+        QList<QList<Sector*>> batches;
+        quint64 batchPois = 0;
+        quint64 total = 0;
 
-        setProgress(0);
+        for(Sector *sector : std::as_const(sectors))
+        {
+            if(batches.isEmpty() || batchPois >= ExportBatchPois)
+            {
+                batches.append(QList<Sector*>());
+                batchPois = 0;
+            }
 
-        quint64 loadedDataCount = 0;
-        quint64 loops = (m_totalPointsOfInterestTemp / 1000);
+            batches.last().append(sector);
+            batchPois += sector->locations;
+            total += sector->locations;
+        }
 
-        if(m_totalPointsOfInterestTemp % 1000)
-            ++loops;
+        m_sectorLock.unlock();
 
-        //read in chunks of 1000 entries
-        for(quint64 i = 0; i < loops; ++i)
+        struct Formatted
         {
-            quint64 sqlStartIndex = (i * 1000);
+            QByteArray bytes;
+            quint64 visited = 0;
+            quint64 exported = 0;
+            bool stale = false; //the sectors were destroyed since the batches were cut
+        };
 
-            QString command = QString("SELECT * FROM pois LIMIT 1000 OFFSET %1").arg(QString::number(sqlStartIndex));
+        auto format = [this, &exporter, generation](const QList<Sector*> &batch) {
+            TraceSpan span("format batch", "export");
+            QByteArray buffer;
+            Formatted formatted;
 
-            query.prepare(command);
+            QReadLocker locker(&m_sectorLock);
 
-            if(!query.exec())
+            if(generation != m_sectorGeneration)
             {
-                qDebug() << "Could not load database" << database << m_sqlDatabase.lastError();
-                m_databaseMutex.unlock();
-                return;
+                formatted.stale = true;
+                return formatted;
             }
 
-            while(query.next())
+            for(Sector *sector : batch)
             {
-                LocationData data
+                QMutexLocker sectorLocker(&sector->mutex);
+
+                //write packed and evicted sectors from a temporary copy instead of thawing them for good
+                LocationDataNode *node = sector->head;
+                LocationDataNode *coldHead = nullptr;
+
+                if(!node)
                 {
-                    query.value("accuracy").toDouble(),
-                    1,
-                    QGeoCoordinate(query.value("latitude").toDouble(), query.value("longitude").toDouble()),
-                    QUrl::fromPercentEncoding(query.value("description").toByteArray()),
-                    query.value("encryption").toString(),
-                    query.value("id").toString(),
-                    QUrl::fromPercentEncoding(query.value("name").toByteArray()),
-                    query.value("open").toString().toInt(),
-                    query.value("signal").toDouble(),
-                    query.value("style").toString(),
-                    query.value("type").toString(),
-                    query.value("timestamp").toDateTime(),
-                    query.value("mfgid").toString(),
-                    query.value("frequency").toDouble(),
-                    query.value("capabilities").toString().split(':'),
-                    query.value("rois").toString().split(':')
-                };
+                    LocationDataNode *coldLast = nullptr;
+                    quint64 coldCount = 0;
 
-                append(data, false);
+                    SectorCodec::decode(sectorBlock(sector), coldHead, coldLast, coldCount);
+                    node = coldHead;
+                }
+
+                for(; node; node = node->next)
+                {
+                    ++formatted.visited;
+
+                    if(!exporter.accepts(node->data))
+                        continue;
+
+                    exporter.append(buffer, node->data);
+                    ++formatted.exported;
+                }
 
-                setProgress(++loadedDataCount / m_totalPointsOfInterestTemp);
+                SectorDirectory::deleteNodes(coldHead);
             }
-        }
 
-        setLoadedDatabase(database);
-        m_databaseMutex.unlock();
-    }));
+            formatted.bytes = exporter.encode(buffer);
+            span.setCount(formatted.exported);
 
-    watcher.connect(&watcher, &QFutureWatcher<void>::finished, this, [this](){
+            return formatted;
+        };
 
-        emit lteStatsChanged();
-        emit bluetoothStatsChanged();
-        emit bluetoothLEStatsChanged();
-        emit gsmStatsChanged();
-        emit cdmaStatsChanged();
-        emit wcdmaStatsChanged();
-        emit lteStatsChanged();
-        emit nrStatsChanged();
-        emit wifiStatsChanged();
-
-        setTotalPointsOfInterest(m_totalPointsOfInterestTemp);
-        setBluetoothPointsOfInterest(m_bluetoothPointsOfInterestTemp);
-        setWifiPointsOfInterest(m_wifiPointsOfInterestTemp);
-        setCellularPointsOfInterest(m_cellularPointsOfInterestTemp);
-        endLoading();
-    });
-}
+        m_metrics->begin(0, total);
+        auto metricsGuard = qScopeGuard([this]() { m_metrics->end(); });
 
-//this should be able to go into the class, but QtConcurrent::run
-LocationDataNode *groupPoints(LocationDataNode *node, QGeoShape area,  qreal clusterDistance, quint64 &count)
-{
-    //copy for clustering
-    LocationDataNode *nodeToCopy = node;
-    LocationDataNode *nodeToWrite = nullptr;
-    LocationDataNode *copiedHead = nullptr;
+        //buffers are written in batch order, formatting runs at most the window ahead of the writer
+        QQueue<QFuture<Formatted>> pending;
+        qsizetype window = static_cast<qsizetype>(m_exportPool.maxThreadCount()) * ExportWindow;
+        qsizetype next = 0;
 
-    while(nodeToCopy)
-    {
-        if(area.contains(nodeToCopy->data.coordinates))
+        QByteArray separator = exporter.separator();
+        bool separate = false;
+        bool success = file.write(exporter.header()) >= 0;
+        bool stale = false;
+        quint64 exported = 0;
+
+        while(success && (next < batches.count() || !pending.isEmpty()))
         {
-            if(!nodeToWrite)
+            while(next < batches.count() && pending.count() < window)
+                pending.enqueue(QtConcurrent::run(&m_exportPool, format, batches[next++]));
+
+            Formatted formatted = pending.dequeue().result();
+
+            if(formatted.stale)
             {
-                nodeToWrite = new LocationDataNode(nodeToCopy->data);
-                copiedHead = nodeToWrite;
+                stale = true;
+                break;
             }
-            else
+
+            if(!formatted.bytes.isEmpty())
             {
-                nodeToWrite->next = new LocationDataNode(nodeToCopy->data);
-                nodeToWrite = nodeToWrite->next;
+                if(separate && !separator.isEmpty())
+                    success = file.write(separator) == separator.size();
+
+                success = success && file.write(formatted.bytes) == formatted.bytes.size();
+                separate = true;
             }
 
-            ++count;
+            exported += formatted.exported;
+            m_metrics->addRows(formatted.visited);
+            m_metrics->setPosition(file.pos());
         }
 
-        nodeToCopy = nodeToCopy->next;
-    }
+        //the formatters point into the sectors and this frame
+        for(QFuture<Formatted> &future : pending)
+            future.waitForFinished();
 
-    //group POI clusters
-    LocationDataNode *viewportNodeIteratorA = copiedHead;
+        success = success && file.write(exporter.footer()) >= 0;
+        file.close();
 
-    while(viewportNodeIteratorA)
-    {
-        LocationDataNode *viewportNodeIteratorB = viewportNodeIteratorA->next;
-        LocationDataNode *viewportNodeIteratorC = viewportNodeIteratorA; //last referenced for splicing
-        QGeoCoordinate coordA(viewportNodeIteratorA->data.coordinates.latitude(), viewportNodeIteratorA->data.coordinates.longitude());
+        if(stale)
+        {
+            qDebug() << "Export" << fileName << "stopped, the data was reloaded";
+            errorOccurred("Export Error", "The data was reloaded while exporting, the file is incomplete.");
+            return;
+        }
 
-        while(viewportNodeIteratorB)
+        if(!success || file.error() != QFile::NoError)
         {
-            QGeoCoordinate coordB(viewportNodeIteratorB->data.coordinates.latitude(), viewportNodeIteratorB->data.coordinates.longitude());
-            qreal coordDistance = coordA.distanceTo(coordB);
+            qDebug() << "Could not write export" << fileName << file.errorString();
+            errorOccurred("Export Error", "Could not write file. " + file.errorString());
+            return;
+        }
 
-            if(coordDistance <= clusterDistance)
-            {
-                viewportNodeIteratorC->next = viewportNodeIteratorB->next;
-                delete viewportNodeIteratorB;
-                // if(!viewportNodeIteratorC->data.children)
-                // {
-                //     viewportNodeIteratorC->data.children = viewportNodeIteratorB;
-                //     viewportNodeIteratorC->data.lastChild = viewportNodeIteratorB;
-                // }
-                // else
-                // {
-                //     viewportNodeIteratorC->data.lastChild->next = viewportNodeIteratorB;
-                //     viewportNodeIteratorC->data.lastChild = viewportNodeIteratorC->data.lastChild->next;
-                // }
-
-                viewportNodeIteratorB = viewportNodeIteratorC->next;
-
-                //set the size and color for the heatmap
-                if(viewportNodeIteratorC->data.color.green() > 16)
-                    viewportNodeIteratorC->data.color.setGreen(viewportNodeIteratorC->data.color.green() - 16);
-
-                if(viewportNodeIteratorC->data.color.red() < (249))
-                    viewportNodeIteratorC->data.color.setRed(viewportNodeIteratorC->data.color.red() + 16);
-                else if(viewportNodeIteratorC->data.color.blue() < 249)
-                    viewportNodeIteratorC->data.color.setBlue(viewportNodeIteratorC->data.color.blue() + 16);
-
-                --count;
+        span.setCount(exported);
+        qDebug() << "Exported" << exported << "POIs to" << fileName;
+    }));
 
-                continue;
-            }
+    connect(&watcher, &QFutureWatcher<void>::finished, this, [this](){
+        endLoading();
+    });
+}
+
+//rows written before timestamps were stored as ms since epoch hold QDateTime::toString() output
+qint64 loadTimestamp(const QString &value)
+{
+    qint64 timestamp = 0;
+
+    if(!TimestampParser::parse(QStringView(value), timestamp))
+        timestamp = QDateTime::fromString(value, Qt::TextDate).toMSecsSinceEpoch();
+
+    return timestamp;
+}
+
+//numeric columns are stored as text. Comparing the text to its cast applies numeric affinity to it, so
+//numbers come back from SQLite typed and only values that aren't numbers arrive as text
+static QString numericColumn(const QString &column, const QString &type)
+{
+    return QString("CASE WHEN CAST(%1 AS %2) = %1 THEN CAST(%1 AS %2) ELSE %1 END").arg(column, type);
+}
+
+//column order of every SELECT decoded by decodeRow()
+static const QString PoiColumns = QStringList {
+    numericColumn("accuracy", "REAL"), numericColumn("latitude", "REAL"), numericColumn("longitude", "REAL"), "description", "encryption", "id", "name",
+    numericColumn("open", "INTEGER"), numericColumn("signal", "REAL"), "style", "type", numericColumn("timestamp", "INTEGER"), "mfgid",
+    numericColumn("frequency", "REAL"), "capabilities", "rois"
+}.join(", ");
+static constexpr int PoiColumnCount = 16;
+
+//positions are stored as text, these expressions match the pois_position index
+static const QString PoiLatitudeColumn = "CAST(latitude AS REAL)";
+static const QString PoiLongitudeColumn = "CAST(longitude AS REAL)";
+static const QString PoiPositionColumns = PoiLatitudeColumn + ", " + PoiLongitudeColumn;
+static const char *PoiColumnNames[PoiColumnCount] {
+    "accuracy", "latitude", "longitude", "description", "encryption", "id", "name", "open",
+    "signal", "style", "type", "timestamp", "mfgid", "frequency", "capabilities", "rois"
+};
+
+//decodes a row selected with PoiColumns. returns false if the row has no usable position
+bool decodeRow(const QSqlQuery &query, LocationData &data, quint64 (&fieldErrors)[PoiColumnCount])
+{
+    //numbers arrive typed and are read straight out of the variant, text goes through the importers' parser
+    auto parseDouble = [&query, &fieldErrors](int column, qreal &value) {
+        QVariant field = query.value(column);
 
-            viewportNodeIteratorC = viewportNodeIteratorB;
-            viewportNodeIteratorB = viewportNodeIteratorB->next;
+        if(field.typeId() == QMetaType::Double || field.typeId() == QMetaType::LongLong)
+        {
+            value = field.toDouble();
+            return true;
         }
 
-        viewportNodeIteratorA = viewportNodeIteratorA->next;
+        QString text = field.toString();
+        FieldParser::Error error = FieldParser::toDouble(QStringView(text), value);
+
+        if(error != FieldParser::NoError && error != FieldParser::EmptyField)
+            ++fieldErrors[column];
+
+        return error == FieldParser::NoError;
+    };
+
+    double latitude = 0;
+    double longitude = 0;
+
+    if(!parseDouble(1, latitude) || !parseDouble(2, longitude))
+        return false;
+
+    parseDouble(0, data.accuracy);
+    parseDouble(8, data.signal);
+    parseDouble(13, data.frequency);
+
+    QVariant open = query.value(7);
+
+    if(open.typeId() == QMetaType::LongLong)
+        data.open = open.toInt();
+    else
+    {
+        QString text = open.toString();
+        FieldParser::Error openError = FieldParser::toInt(QStringView(text), data.open);
+
+        if(openError != FieldParser::NoError && openError != FieldParser::EmptyField)
+            ++fieldErrors[7];
     }
 
-    // qDebug() << "Grouped" << groups << "within" << clusterDistance;
+    data.coordinates = QGeoCoordinate(latitude, longitude);
+    data.description = QUrl::fromPercentEncoding(query.value(3).toByteArray());
+    data.encryption = query.value(4).toString();
+    data.id = query.value(5).toString();
+    data.name = QUrl::fromPercentEncoding(query.value(6).toByteArray());
+    data.styleTag = query.value(9).toString();
+    data.type = query.value(10).toString();
 
-    return copiedHead;
+    //ms since epoch, or the text of rows from before that
+    QVariant timestamp = query.value(11);
+    data.timestamp = timestamp.typeId() == QMetaType::LongLong ? timestamp.toLongLong() : loadTimestamp(timestamp.toString());
+
+    data.mfgid = query.value(12).toString();
+    data.capabilities = query.value(14).toString().split(':');
+    data.rois = query.value(15).toString().split(':');
+
+    return true;
 }
 
-void LocationModel::getPointsInRect(QGeoShape area, qreal zoomLevel)
+void reportFieldErrors(const quint64 (&fieldErrors)[PoiColumnCount])
 {
-    auto result = QtConcurrent::run([this, area, zoomLevel]
+    for(int column = 0; column < PoiColumnCount; ++column)
     {
-        if(!m_threadMutex.tryLock(QDeadlineTimer(250)))
-            return;
+        if(fieldErrors[column])
+            qDebug() << "Column" << PoiColumnNames[column] << "failed to parse in" << fieldErrors[column] << "rows";
+    }
+}
 
-        qreal timeStart = QDateTime::currentMSecsSinceEpoch();
+void LocationModel::load(QString database, QGeoCoordinate focus)
+{
+    startLoading("Loading");
+    m_streaming = true;
 
-        // QFutureSynchronizer<LocationDataNode*> watcher;
-        // QList<QFuture<LocationDataNode*>> futures;
+    //any background load still streaming in gives up at its next row
+    quint64 generation = ++m_loadGeneration;
 
-        QGeoPolygon poly = area;
+    //a database can't be attached to itself
+    if(m_attachedDatabases.removeAll(database))
+        emit attachedDatabasesChanged();
 
-        //QGeoPolygon seems to be constructed from bottom right, to bottom left, to top left to top right
-        int latitudeStartIndex = poly.coordinateAt(1).latitude() + 90;
-        int latitudeEndIndex = poly.coordinateAt(2).latitude() + 90;
-        int longitudeStartIndex = poly.coordinateAt(1).longitude() + 180;
-        int longitudeEndIndex = poly.coordinateAt(0).longitude() + 180;
+    QStringList attached = m_attachedDatabases;
 
-        LocationDataNode *nodes = nullptr;
-        LocationDataNode *headNode = nullptr;
+    watcher.disconnect();
+    watcher.setFuture(QtConcurrent::run([this, database, focus, generation, attached](){
+        TraceSpan span("load", "load");
 
-        quint64 totalNodes = 0;
+        //wait for a cancelled load to release the database
+        m_databaseMutex.lock();
 
-        //get points in the bounding rect
-        for(int x = 0; x < 360; ++x)
+        if(generation != m_loadGeneration)
         {
-            for(int y = 0; y < 180; ++y)
-            {
-                if(x >= longitudeStartIndex && x <= longitudeEndIndex && y >= latitudeStartIndex && y <= latitudeEndIndex)
-                {
-                    quint64 count = 0;
-                    if(!nodes)
-                    {
-                        nodes = groupPoints(m_sectors[x][y].head, area, logScale(zoomLevel), count);
-                        headNode = nodes;
-                    }
+            m_databaseMutex.unlock();
+            return;
+        }
 
-                    else
-                        nodes->next = groupPoints(m_sectors[x][y].head, area, logScale(zoomLevel), count);
+        QMetaObject::invokeMethod(this, [this]() { resetSectorData(); }, Qt::BlockingQueuedConnection);
 
-                    while(nodes && nodes->next)
-                        nodes = nodes->next;
+        m_bluetoothPointsOfInterestTemp = 0;
+        m_wifiPointsOfInterestTemp = 0;
+        m_totalPointsOfInterestTemp = 0;
+        m_cellularPointsOfInterestTemp = 0;
 
-                    totalNodes += count;
+        m_bluetoothStats = 0;
+        m_bluetoothLEStats = 0;
+        m_gsmStats = 0;
+        m_cdmaStats = 0;
+        m_wcdmaStats = 0;
+        m_lteStats = 0;
+        m_nrStats = 0;
+        m_wifiStats = 0;
 
-                    // QFuture<LocationDataNode*> future = QtConcurrent::run(groupPoints, m_sectors[x][y].head, area, logScale(zoomLevel));
-                    // watcher.addFuture(future);
-                }
-            }
+        QDir databaseDirectory = getDatabaseDirectory(database);
+
+        if(m_sqlDatabase.isOpen())
+        {
+            m_sqlDatabase.close();
+            QSqlDatabase::removeDatabase(m_sqlDatabase.connectionName());
         }
 
-        watcher.waitForFinished();
+        m_sqlDatabase = QSqlDatabase::addDatabase("QSQLITE");
+        m_sqlDatabase.setDatabaseName(databaseDirectory.absoluteFilePath(database + ".db"));
+
+        if(!m_sqlDatabase.open())
+        {
+            qDebug() << "Could not open database" << database << m_sqlDatabase.lastError();
+            m_databaseMutex.unlock();
+            QMetaObject::invokeMethod(this, [this, generation]() {
+                endLoading();
+                endStreaming(generation);
+            }, Qt::QueuedConnection);
+            return;
+        }
 
-        resetDataModel();
+        //get DB size
+        TraceSpan prepareSpan("prepare database", "sql");
 
-        quint64 index = 0;
-        // beginInsertRows(QModelIndex(), 0, totalNodes - 1);
-        while(headNode)
         {
-            beginInsertRows(QModelIndex(), index, index + 1);
+            QSqlQuery query(m_sqlDatabase);
+            query.prepare(QString("SELECT COUNT(*) FROM pois"));
+            query.exec();
 
-            LocationDataNode *nodeToDelete = headNode;
-            m_filteredData.append(headNode->data);
-            headNode = headNode->next;
+            if (query.next()) {
+                m_totalPointsOfInterestTemp = query.value(0).toInt();
+            }
 
-            delete nodeToDelete;
-            endInsertRows();
-            ++index;
+            //lets the viewport query below use an index instead of scanning the table
+            if(!query.exec(QString("CREATE INDEX IF NOT EXISTS pois_position ON pois(%1)").arg(PoiPositionColumns)))
+                qDebug() << "Could not create position index" << query.lastError();
         }
-        // endInsertRows();
 
-        // for(const QFuture<LocationDataNode*> &future : std::as_const(futures))
-        // {
-        //     LocationDataNode *futureNodes = future.result();
+        prepareSpan.end();
 
-        //     if(!futureNodes)
-        //         continue;
+        m_metrics->begin(0, m_totalPointsOfInterestTemp);
+        auto metricsGuard = qScopeGuard([this]() { m_metrics->end(); });
 
-        //     while(futureNodes)
-        //     {
-        //         quint64 start = m_filteredData.count() > 0 ? m_filteredData.count() - 1 : 0;
-        //         quint64 end = m_filteredData.count() > 0 ? m_filteredData.count() : 1;
+        setProgress(0);
+        setLoadedDatabase(database);
 
-        //         beginInsertRows(QModelIndex(), start, end);
-        //         m_filteredData.append(futureNodes->data);
-        //         endInsertRows();
+        quint64 fieldErrors[PoiColumnCount] {};
+        quint64 skipped = 0;
+        qint64 lastRowId = std::numeric_limits<qint64>::min();
 
-        //         LocationDataNode *tempNode = futureNodes;
-        //         futureNodes = futureNodes->next;
+        QElapsedTimer publishTimer;
+        publishTimer.start();
 
-        //         delete tempNode;
-        //     }
-        // }
+        //streams rows into the sectors, returns false if a newer load took over. cursor is set to the
+        //rowid of the last row, only for queries in rowid order
+        auto loadRows = [this, &fieldErrors, &skipped, &publishTimer, generation](QSqlQuery &query, qint64 publishInterval, quint64 &rows, qint64 *cursor) {
+            TraceSpan chunk("load chunk", "load");
+            quint64 chunkRows = 0;
 
-        qreal endTime = QDateTime::currentMSecsSinceEpoch();
+            while(query.next())
+            {
+                if(generation != m_loadGeneration)
+                    return false;
 
-        m_threadMutex.unlock();
+                ++rows;
+
+                if(cursor)
+                    *cursor = query.value(PoiColumnCount).toLongLong();
+
+                LocationData data;
+
+                if(!decodeRow(query, data, fieldErrors))
+                {
+                    ++skipped;
+                    m_metrics->addRow();
+                    continue;
+                }
+
+                //counts itself in the metrics
+                append(data, false);
+
+                if(++chunkRows == TraceChunkRows)
+                {
+                    chunk.setCount(chunkRows);
+                    chunk.restart();
+                    chunkRows = 0;
+                }
+
+                if(publishInterval > 0 && publishTimer.elapsed() > publishInterval)
+                {
+                    QMetaObject::invokeMethod(this, [this]() { publishLoadedSectors(); }, Qt::QueuedConnection);
+                    publishTimer.restart();
+                }
+            }
+
+            chunk.setCount(chunkRows);
+
+            return true;
+        };
+
+        //the sectors around the last viewport go first, everything else streams in behind the map
+        bool hasFocus = focus.isValid();
+        QString focusCondition;
+
+        if(hasFocus)
+        {
+            qreal west = std::floor(focus.longitude()) - 1;
+            qreal east = std::floor(focus.longitude()) + 2;
+            QString longitudeCondition = "%1 >= %2 AND %1 < %3";
+
+            //the window wraps around the antimeridian
+            if(west < -180 || east > 180)
+            {
+                longitudeCondition = "(%1 >= %2 OR %1 < %3)";
+                west = west < -180 ? west + 360 : west;
+                east = east > 180 ? east - 360 : east;
+            }
+
+            focusCondition = QString("%1 >= %2 AND %1 < %3 AND ").arg(PoiLatitudeColumn, QString::number(std::floor(focus.latitude()) - 1), QString::number(std::floor(focus.latitude()) + 2));
+            focusCondition += longitudeCondition.arg(PoiLongitudeColumn, QString::number(west), QString::number(east));
+        }
+
+        if(hasFocus)
+        {
+            QSqlQuery query(m_sqlDatabase);
+            query.setForwardOnly(true);
+            quint64 rows = 0;
+
+            if(!query.exec(QString("SELECT %1, rowid FROM pois WHERE %2").arg(PoiColumns, focusCondition)))
+            {
+                qDebug() << "Could not load database" << database << query.lastError();
+                m_databaseMutex.unlock();
+                QMetaObject::invokeMethod(this, [this, generation]() {
+                    endLoading();
+                    endStreaming(generation);
+                }, Qt::QueuedConnection);
+                return;
+            }
+
+            //the position index hands the focus rows out of rowid order, the chunks below start from the first row
+            if(!loadRows(query, 0, rows, nullptr))
+            {
+                query.finish();
+                m_databaseMutex.unlock();
+                return;
+            }
+
+            QMetaObject::invokeMethod(this, [this]() {
+                publishLoadedSectors();
+                endLoading();
+            }, Qt::QueuedConnection);
+
+            QThread::currentThread()->setPriority(QThread::LowPriority);
+        }
+
+        //the rest goes in rowid order one chunk at a time, an import can write to the database in between
+        QString command = QString("SELECT %1, rowid FROM pois WHERE rowid > ?").arg(PoiColumns);
+
+        if(hasFocus)
+            command += QString(" AND NOT (%1)").arg(focusCondition);
+
+        command += QString(" ORDER BY rowid LIMIT %1").arg(LoadChunkRows);
+
+        bool completed = true;
+        quint64 rows = LoadChunkRows;
+
+        for(bool first = true; completed && rows == LoadChunkRows; first = false)
+        {
+            if(!first)
+            {
+                m_databaseMutex.unlock();
+                m_databaseMutex.lock();
+            }
+
+            //a newer load waits for the mutex, it owns the sectors from here
+            if(generation != m_loadGeneration)
+            {
+                completed = false;
+                break;
+            }
+
+            QSqlQuery query(m_sqlDatabase);
+            query.setForwardOnly(true);
+            query.prepare(command);
+            query.addBindValue(lastRowId);
+            rows = 0;
+
+            completed = query.exec();
+
+            if(!completed)
+                qDebug() << "Could not load database" << database << query.lastError();
+            else
+                completed = loadRows(query, hasFocus ? 1000 : 0, rows, &lastRowId);
+        }
+
+        //attached databases follow in the order they were attached, their source is their position
+        for(qsizetype index = 0; completed && index < attached.count(); ++index)
+            completed = attachRows(attached[index], static_cast<quint8>(index + 1), generation);
+
+        if(hasFocus)
+            QThread::currentThread()->setPriority(QThread::NormalPriority);
+
+        reportFieldErrors(fieldErrors);
+
+        if(skipped)
+            qDebug() << "Skipped" << skipped << "rows without a valid position";
+
+        m_databaseMutex.unlock();
+
+        if(!completed)
+            return;
+
+        //with a focus the loading screen is already gone and may belong to another operation by now
+        QMetaObject::invokeMethod(this, [this, hasFocus, generation]() {
+            publishLoadedSectors();
+
+            if(!hasFocus)
+                endLoading();
+
+            endStreaming(generation);
+        }, Qt::QueuedConnection);
+    }));
+}
+
+void LocationModel::attach(QString database)
+{
+    if(database == m_loadedDatabase || m_attachedDatabases.contains(database) || !m_availableDatabases.contains(database))
+        return;
+
+    if(m_attachedDatabases.count() >= MaximumAttachedDatabases)
+    {
+        errorOccurred("Attach Error", "Too many databases are attached already.");
+        return;
+    }
+
+    m_attachedDatabases.append(database);
+    emit attachedDatabasesChanged();
+
+    startLoading(QString("Attaching database `%1`").arg(database));
+
+    quint8 source = static_cast<quint8>(m_attachedDatabases.count());
+    quint64 generation = m_loadGeneration;
+
+    watcher.disconnect();
+    watcher.setFuture(QtConcurrent::run([this, database, source, generation]() {
+        //after any load still streaming in
+        QMutexLocker locker(&m_databaseMutex);
+
+        if(generation == m_loadGeneration)
+            attachRows(database, source, generation);
+    }));
+
+    connect(&watcher, &QFutureWatcher<void>::finished, this, [this]() {
+        publishLoadedSectors();
+        endLoading();
+    });
+}
+
+//the rows of a database can't be told apart once they are in the sectors, so the rest is loaded again
+void LocationModel::detach(QString database)
+{
+    if(!m_attachedDatabases.removeAll(database))
+        return;
+
+    emit attachedDatabasesChanged();
+
+    load(m_loadedDatabase, m_viewportArea.isValid() ? m_viewportArea.center() : QGeoCoordinate());
+}
+
+QStringList LocationModel::attachedDatabases() const
+{
+    return m_attachedDatabases;
+}
+
+//must be called with the database mutex held. streams a database into the sectors next to the loaded
+//one, rows whose ID is already loaded are merged into the first copy. false if a newer load took over
+bool LocationModel::attachRows(const QString &database, quint8 source, quint64 generation)
+{
+    TraceSpan span("attach", "load");
+
+    QString connection = QString("wdrvr_attach_%1_%2").arg(reinterpret_cast<quintptr>(this)).arg(source);
+    bool completed = true;
+
+    quint64 fieldErrors[PoiColumnCount] {};
+    quint64 rows = 0;
+    quint64 merged = 0;
+    quint64 skipped = 0;
+
+    {
+        QSqlDatabase sqlDatabase = QSqlDatabase::addDatabase("QSQLITE", connection);
+        sqlDatabase.setDatabaseName(getDatabaseDirectory(database).absoluteFilePath(database + ".db"));
+        sqlDatabase.setConnectOptions("QSQLITE_OPEN_READONLY");
+
+        QSqlQuery query(sqlDatabase);
+
+        if(!sqlDatabase.open())
+            qDebug() << "Could not open database" << database << sqlDatabase.lastError();
+
+        else if(query.exec("SELECT COUNT(*) FROM pois") && query.next())
+        {
+            m_metrics->begin(0, query.value(0).toULongLong());
+            auto metricsGuard = qScopeGuard([this]() { m_metrics->end(); });
+
+            QElapsedTimer publishTimer;
+            publishTimer.start();
+
+            query.setForwardOnly(true);
+
+            if(!query.exec(QString("SELECT %1 FROM pois").arg(PoiColumns)))
+                qDebug() << "Could not load database" << database << query.lastError();
+
+            while(query.next())
+            {
+                if(generation != m_loadGeneration)
+                {
+                    completed = false;
+                    break;
+                }
+
+                LocationData data;
+
+                if(!decodeRow(query, data, fieldErrors))
+                {
+                    ++skipped;
+                    continue;
+                }
+
+                data.source = source;
+
+                if(append(data, false))
+                {
+                    ++rows;
+                    ++m_totalPointsOfInterestTemp;
+                }
+                else
+                    ++merged;
+
+                if(publishTimer.elapsed() > 1000)
+                {
+                    QMetaObject::invokeMethod(this, [this]() { publishLoadedSectors(); }, Qt::QueuedConnection);
+                    publishTimer.restart();
+                }
+            }
+        }
+
+        query.finish();
+        sqlDatabase.close();
+    }
+
+    QSqlDatabase::removeDatabase(connection);
+
+    reportFieldErrors(fieldErrors);
+
+    if(skipped)
+        qDebug() << "Skipped" << skipped << "rows without a valid position";
+
+    span.setCount(rows);
+    qDebug() << "Attached" << database << "with" << rows << "rows," << merged << "IDs were already loaded";
+
+    return completed;
+}
+
+void LocationModel::publishLoadedSectors()
+{
+    TraceSpan span("publish sectors", "model");
+
+    publishCounters();
+    emit sectorsUpdated();
+}
+
+void LocationModel::publishCounters()
+{
+    emit lteStatsChanged();
+    emit bluetoothStatsChanged();
+    emit bluetoothLEStatsChanged();
+    emit gsmStatsChanged();
+    emit cdmaStatsChanged();
+    emit wcdmaStatsChanged();
+    emit nrStatsChanged();
+    emit wifiStatsChanged();
+
+    setTotalPointsOfInterest(m_totalPointsOfInterestTemp);
+    setBluetoothPointsOfInterest(m_bluetoothPointsOfInterestTemp);
+    setWifiPointsOfInterest(m_wifiPointsOfInterestTemp);
+    setCellularPointsOfInterest(m_cellularPointsOfInterestTemp);
+
+    updateViewportStats(m_viewportArea);
+
+    emit timelineChanged();
+}
+
+//shade a cluster by how many POIs were merged into it
+QColor clusterColor(qint64 clusterCount)
+{
+    qint64 merged = clusterCount - 1;
+
+    int red = std::min<qint64>(merged, 15) * 17;
+    int blue = 128 + std::min<qint64>(std::max<qint64>(merged - 15, 0), 7) * 16;
+
+    return QColor(red, 0, blue, 200);
+}
+
+static void groupPoint(QVector<LocationCluster> &clusters, LocationDataNode *node, const QGeoShape &area, qreal clusterDistance, quint64 &count)
+{
+    const QGeoCoordinate &coordinates = node->data.coordinates;
+
+    if(!area.contains(coordinates))
+        return;
+
+    ++count;
+
+    //merge into the first cluster whose representative is within range
+    for(LocationCluster &cluster : clusters)
+    {
+        if(cluster.representative->data.coordinates.distanceTo(coordinates) > clusterDistance)
+            continue;
+
+        ++cluster.clusterCount;
+
+        //running centroid
+        cluster.coordinates.setLatitude(cluster.coordinates.latitude() + ((coordinates.latitude() - cluster.coordinates.latitude()) / cluster.clusterCount));
+        cluster.coordinates.setLongitude(cluster.coordinates.longitude() + ((coordinates.longitude() - cluster.coordinates.longitude()) / cluster.clusterCount));
+
+        return;
+    }
+
+    LocationCluster cluster;
+    cluster.coordinates = QGeoCoordinate(coordinates.latitude(), coordinates.longitude());
+    cluster.setRepresentative(node);
+
+    clusters.append(cluster);
+}
+
+//this should be able to go into the class, but QtConcurrent::run
+QVector<LocationCluster> groupPoints(LocationDataNode *node, QGeoShape area,  qreal clusterDistance, quint64 &count)
+{
+    QVector<LocationCluster> clusters;
+
+    for(; node; node = node->next)
+        groupPoint(clusters, node, area, clusterDistance, count);
+
+    for(LocationCluster &cluster : clusters)
+        cluster.color = clusterColor(cluster.clusterCount);
+
+    return clusters;
+}
+
+QVector<LocationCluster> groupPoints(const QVector<LocationDataNode*> &nodes, QGeoShape area,  qreal clusterDistance, quint64 &count)
+{
+    QVector<LocationCluster> clusters;
+
+    for(LocationDataNode *node : nodes)
+        groupPoint(clusters, node, area, clusterDistance, count);
+
+    for(LocationCluster &cluster : clusters)
+        cluster.color = clusterColor(cluster.clusterCount);
+
+    return clusters;
+}
+
+void LocationModel::getPointsInRect(QGeoShape area, qreal zoomLevel)
+{
+    //the replay owns the rows until it is stopped
+    if(m_replaying)
+        return;
+
+    //a real request makes every queued guess stale
+    ++m_prefetchGeneration;
+    m_prefetchPool.clear();
+
+    quint64 prefetchGeneration = m_prefetchGeneration.loadAcquire();
+
+    QGeoRectangle bounds = area.boundingGeoRectangle();
+
+    //snap the cluster distance so neighbouring zoom levels share cached tiles
+    int step = std::clamp(static_cast<int>(std::round(zoomLevel * ClusterTileCache::DistanceSteps)), 0, ClusterTileCache::DistanceSteps);
+    int zoom = ClusterTileCache::zoomFor(bounds.width());
+
+    QList<PrefetchTile> prefetch = predictTiles(bounds, step, zoom);
+    LocationFilter filter = m_filter;
+
+    auto result = QtConcurrent::run([this, bounds, step, zoom, filter, prefetch, prefetchGeneration]
+    {
+        if(!m_threadMutex.tryLock(QDeadlineTimer(250)))
+            return;
+
+        TraceSpan span("getPointsInRect", "query");
+        qreal timeStart = QDateTime::currentMSecsSinceEpoch();
+
+        int tiles = 1 << zoom;
+        int rowStart = ClusterTileCache::row(bounds.topLeft().latitude(), zoom);
+        int rowEnd = ClusterTileCache::row(bounds.bottomRight().latitude(), zoom);
+        int columnStart = ClusterTileCache::column(bounds.topLeft().longitude(), zoom);
+        int columnEnd = ClusterTileCache::column(bounds.bottomRight().longitude(), zoom);
+
+        //the viewport crosses the antimeridian
+        if(columnEnd < columnStart)
+            columnEnd += tiles;
+
+        QVector<LocationCluster> clusters;
+        QSet<quint32> sectorIds;
+        QList<quint32> pendingSectors;
+        quint64 totalNodes = 0;
+        int cachedTiles = 0;
+        int builtTiles = 0;
+
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+        m_sectorLock.lockForRead();
+        quint64 generation = m_sectorGeneration;
+
+        for(int row = rowStart; row <= rowEnd; ++row)
+        {
+            for(int wrappedColumn = columnStart; wrappedColumn <= columnEnd; ++wrappedColumn)
+            {
+                bool cached = false;
+                ClusterTile tile = clusterTile(step, zoom, wrappedColumn % tiles, row, filter, now, cached, totalNodes, &pendingSectors);
+
+                if(cached)
+                    ++cachedTiles;
+                else
+                    ++builtTiles;
+
+                clusters += tile.clusters;
+
+                for(quint32 id : std::as_const(tile.sectorIds))
+                    sectorIds.insert(id);
+            }
+        }
+
+        m_sectorLock.unlock();
+
+        //swap the result in on the model's thread, unless the sectors it points into are gone
+        QMetaObject::invokeMethod(this, [this, clusters, sectorIds, pendingSectors, generation]() mutable {
+            TraceSpan span("model reset", "model");
+            span.setCount(clusters.count());
+
+            m_sectorLock.lockForRead();
+
+            bool current = generation == m_sectorGeneration && !m_replaying;
+
+            m_pinnedSectorsMutex.lock();
+
+            //the rows point into these sectors, so they must stay unpacked
+            if(current)
+                m_pinnedSectors = sectorIds;
+
+            //the result is swapped in or dropped, either way it no longer needs its own pins
+            for(quint32 id : std::as_const(pendingSectors))
+            {
+                auto pending = m_pendingSectors.find(id);
+
+                if(pending != m_pendingSectors.end() && --pending.value() <= 0)
+                    m_pendingSectors.erase(pending);
+            }
+
+            m_pinnedSectorsMutex.unlock();
+
+            if(current)
+            {
+                beginResetModel();
+                m_filteredData = std::move(clusters);
+                endResetModel();
+            }
+
+            m_sectorLock.unlock();
+
+            //the viewport may have reloaded evicted sectors, make room elsewhere
+            evictSectors();
+        }, Qt::QueuedConnection);
+
+        qreal endTime = QDateTime::currentMSecsSinceEpoch();
+        m_metrics->setQueryLatency(endTime - timeStart);
+
+        span.setCount(totalNodes);
+        span.end();
+
+        m_threadMutex.unlock();
+
+        //guess where the viewport goes next while the user is looking at this one
+        if(!prefetch.isEmpty())
+            m_prefetchPool.start([this, prefetch, filter, prefetchGeneration]() { prefetchTiles(prefetch, filter, prefetchGeneration); });
+
+        qDebug() << "Clustered nodes" << totalNodes << "into" << clusters.count() << "from" << builtTiles << "new and" << cachedTiles << "cached tiles in" << endTime - timeStart << "ms";
+    });
+}
+
+//must be called with the sector lock held, the sectors of tiles that become rows are added to pinned
+ClusterTile LocationModel::clusterTile(int step, int zoom, int column, int row, const LocationFilter &filter, qint64 now, bool &cached, quint64 &totalNodes, QList<quint32> *pinned)
+{
+    QGeoRectangle tileBounds = ClusterTileCache::bounds(zoom, column, row);
+    quint64 key = ClusterTileCache::key(step, zoom, column, row);
+
+    TraceSpan gatherSpan("gather sectors", "query");
+
+    const QList<Sector*> sectors = m_sectors.sectorsInRect(SectorDirectory::column(tileBounds.topLeft().longitude()), SectorDirectory::column(tileBounds.bottomRight().longitude()),
+                                                           SectorDirectory::row(tileBounds.bottomRight().latitude()), SectorDirectory::row(tileBounds.topLeft().latitude()));
+
+    //pinned before anything is read from them, so an eviction either runs first or leaves them alone
+    if(pinned)
+    {
+        QMutexLocker locker(&m_pinnedSectorsMutex);
+
+        for(Sector *sector : sectors)
+        {
+            ++m_pendingSectors[sector->id];
+            pinned->append(sector->id);
+        }
+    }
+
+    quint64 stamp = sectorStamp(sectors);
+
+    gatherSpan.setCount(sectors.count());
+    gatherSpan.end();
+    bool filtered = !filter.isEmpty();
+
+    //filtered tiles get their own slots so switching a filter back finds the old tiles
+    if(filtered)
+    {
+        key = qHashMulti(key, filter.hash());
+        stamp = qHashMulti(stamp, filter.hash());
+    }
+
+    ClusterTile tile;
+
+    cached = m_clusterTiles.find(key, stamp, tile);
+
+    if(cached)
+    {
+        //keep the sectors the cached representatives point into warm
+        for(Sector *sector : sectors)
+        {
+            QMutexLocker sectorLocker(&sector->mutex);
+            sector->lastAccess = now;
+        }
+
+        return tile;
+    }
+
+    TraceSpan span("cluster tile", "query");
+    quint64 tileNodes = totalNodes;
+
+    qreal clusterDistance = logScale(static_cast<qreal>(step) / ClusterTileCache::DistanceSteps);
+    tile.stamp = stamp;
+
+    for(Sector *sector : sectors)
+    {
+        //sectors keep growing while a load streams in
+        QMutexLocker sectorLocker(&sector->mutex);
+
+        thawSector(sector);
+        sector->lastAccess = now;
+        tile.sectorIds.append(sector->id);
+
+        if(!filtered)
+        {
+            tile.clusters += groupPoints(sector->head, tileBounds, clusterDistance, totalNodes);
+            continue;
+        }
+
+        tile.clusters += groupPoints(indexSector(sector)->select(filter), tileBounds, clusterDistance, totalNodes);
+    }
+
+    m_clusterTiles.insert(key, tile);
+    span.setCount(totalNodes - tileNodes);
+
+    return tile;
+}
+
+//must be called with the sector mutex held and the sector thawed
+SectorIndex *LocationModel::indexSector(Sector *sector)
+{
+    if(!sector->index)
+    {
+        sector->index = new SectorIndex;
+
+        for(LocationDataNode *node = sector->head; node; node = node->next)
+            sector->index->append(node);
+    }
+
+    return sector->index;
+}
+
+//appends the tiles of a rect that are not in seen yet
+void LocationModel::appendPrefetchTiles(QList<PrefetchTile> &tiles, QSet<quint64> &seen, const QGeoRectangle &bounds, int step, int zoom)
+{
+    int count = 1 << zoom;
+    int rowStart = ClusterTileCache::row(bounds.topLeft().latitude(), zoom);
+    int rowEnd = ClusterTileCache::row(bounds.bottomRight().latitude(), zoom);
+    int columnStart = ClusterTileCache::column(bounds.topLeft().longitude(), zoom);
+    int columnEnd = ClusterTileCache::column(bounds.bottomRight().longitude(), zoom);
+
+    if(columnEnd < columnStart)
+        columnEnd += count;
+
+    for(int row = rowStart; row <= rowEnd; ++row)
+    {
+        for(int wrappedColumn = columnStart; wrappedColumn <= columnEnd; ++wrappedColumn)
+        {
+            int column = wrappedColumn % count;
+            quint64 key = ClusterTileCache::key(step, zoom, column, row);
+
+            if(seen.contains(key))
+                continue;
+
+            seen.insert(key);
+            tiles.append({ step, zoom, column, row });
+        }
+    }
+}
+
+//tracks pan velocity and zoom direction and returns the tiles the next requests are likely to need
+QList<LocationModel::PrefetchTile> LocationModel::predictTiles(const QGeoRectangle &bounds, int step, int zoom)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 elapsed = now - m_lastViewportTime;
+    QGeoCoordinate center = bounds.center();
+
+    if(m_lastViewportTime == 0 || elapsed > PanGestureTimeout || !m_lastViewportCenter.isValid())
+    {
+        m_panVelocity = QPointF();
+        m_zoomDirection = 0;
+    }
+    else if(elapsed > 0)
+    {
+        qreal longitudeDelta = center.longitude() - m_lastViewportCenter.longitude();
+
+        //take the short way around the antimeridian
+        if(longitudeDelta > 180)
+            longitudeDelta -= 360;
+        else if(longitudeDelta < -180)
+            longitudeDelta += 360;
+
+        QPointF velocity(longitudeDelta / elapsed, (center.latitude() - m_lastViewportCenter.latitude()) / elapsed);
+
+        //smooth out the jitter of single move events
+        m_panVelocity = (m_panVelocity + velocity) / 2;
+
+        if(step != m_lastViewportStep)
+            m_zoomDirection = step > m_lastViewportStep ? 1 : -1;
+    }
+
+    int stepDelta = m_lastViewportStep >= 0 ? std::abs(step - m_lastViewportStep) : 0;
+
+    m_lastViewportCenter = center;
+    m_lastViewportTime = now;
+    m_lastViewportStep = step;
+
+    QList<PrefetchTile> tiles;
+    QSet<quint64> seen;
+
+    //the tiles of the viewport itself are computed by the request
+    {
+        QList<PrefetchTile> viewport;
+        appendPrefetchTiles(viewport, seen, bounds, step, zoom);
+    }
+
+    //where the pan is heading first
+    if(!m_panVelocity.isNull())
+    {
+        for(qint64 lookahead : { PrefetchLookahead / 2, PrefetchLookahead })
+        {
+            QGeoRectangle predicted = bounds.translated(m_panVelocity.y() * lookahead, m_panVelocity.x() * lookahead);
+            appendPrefetchTiles(tiles, seen, predicted, step, zoom);
+        }
+    }
+
+    //then the next zoom level in the direction the user is zooming
+    if(m_zoomDirection != 0)
+    {
+        int nextStep = std::clamp(step + (m_zoomDirection * std::max(stepDelta, 1)), 0, ClusterTileCache::DistanceSteps);
+        int nextZoom = std::clamp(zoom + m_zoomDirection, 0, ClusterTileCache::MaximumZoom);
+        qreal scale = m_zoomDirection > 0 ? 0.5 : 2.0;
+
+        QGeoRectangle predicted(center, std::min(bounds.width() * scale, 360.0), std::min(bounds.height() * scale, 180.0));
+        appendPrefetchTiles(tiles, seen, predicted, nextStep, nextZoom);
+    }
+
+    //and the ring around the viewport for whatever comes after
+    QGeoRectangle ring(center, std::min(bounds.width() + (360.0 / (1 << zoom)) * 2, 360.0), std::min(bounds.height() + (180.0 / (1 << zoom)) * 2, 180.0));
+    appendPrefetchTiles(tiles, seen, ring, step, zoom);
+
+    if(tiles.count() > MaximumPrefetchTiles)
+        tiles.resize(MaximumPrefetchTiles);
+
+    return tiles;
+}
+
+void LocationModel::prefetchTiles(const QList<PrefetchTile> &tiles, const LocationFilter &filter, quint64 generation)
+{
+    TraceSpan span("prefetch", "query");
+
+    quint64 totalNodes = 0;
+    int builtTiles = 0;
+
+    for(const PrefetchTile &tile : tiles)
+    {
+        //a real request came in, these guesses are for a viewport that is gone
+        if(generation != m_prefetchGeneration.loadAcquire())
+            break;
+
+        //lock per tile so a reset is never held up by more than one tile
+        QReadLocker locker(&m_sectorLock);
+
+        bool cached = false;
+        clusterTile(tile.step, tile.zoom, tile.column, tile.row, filter, QDateTime::currentMSecsSinceEpoch(), cached, totalNodes);
+
+        if(!cached)
+            ++builtTiles;
+    }
+
+    span.setCount(totalNodes);
+
+    if(m_debug)
+        qDebug() << "Prefetched" << builtTiles << "tiles holding" << totalNodes << "nodes";
+}
+
+QImage LocationModel::heatmapTile(int zoom, int x, int y, bool weighted)
+{
+    HeatmapEngine::Tile tile;
+    tile.zoom = std::clamp(zoom, 0, HeatmapEngine::MaximumZoom);
+    tile.x = x;
+    tile.y = y;
+    tile.weighted = weighted;
+
+    quint64 stamp = heatmapStamp(tile);
+    QImage image;
+
+    if(!m_heatmap.find(tile, stamp, image) && m_heatmap.schedule(tile, stamp))
+        m_heatmapPool.start([this, tile, stamp]() { renderHeatmapTile(tile, stamp); });
+
+    return image;
+}
+
+quint64 LocationModel::heatmapStamp(const HeatmapEngine::Tile &tile)
+{
+    QGeoRectangle bounds = HeatmapEngine::bounds(tile);
+    QReadLocker locker(&m_sectorLock);
+
+    const QList<Sector*> sectors = m_sectors.sectorsInRect(SectorDirectory::column(bounds.topLeft().longitude()), SectorDirectory::column(bounds.bottomRight().longitude()),
+                                                           SectorDirectory::row(bounds.bottomRight().latitude()), SectorDirectory::row(bounds.topLeft().latitude()));
+
+    return sectorStamp(sectors);
+}
+
+//changes whenever one of the sectors is appended to or packed, or the sectors are rebuilt
+//must be called with the sector lock held
+quint64 LocationModel::sectorStamp(const QList<Sector*> &sectors) const
+{
+    size_t stamp = qHash(m_sectorGeneration);
+
+    for(Sector *sector : sectors)
+        stamp = qHashMulti(stamp, sector->id, sector->revision.loadRelaxed());
+
+    return stamp;
+}
+
+void LocationModel::renderHeatmapTile(const HeatmapEngine::Tile &tile, quint64 stamp)
+{
+    TraceSpan span("heatmap tile", "query");
+
+    QGeoRectangle bounds = HeatmapEngine::bounds(tile);
+    QVector<float> density(HeatmapEngine::GridSize * HeatmapEngine::GridSize, 0.0f);
+
+    //a zoomed out tile covers whole countries, its pixels are coarser than the aggregate cells so the
+    //cell counts draw the same picture without touching the POIs
+    if(tile.zoom <= HeatmapEngine::AggregateZoom)
+    {
+        HeatmapEngine::accumulate(tile, m_aggregates.cellsInRect(bounds), density);
+        m_heatmap.insert(tile, stamp, m_heatmap.render(density));
+
+        emit heatmapTileReady();
+        return;
+    }
+
+    m_sectorLock.lockForRead();
+
+    const QList<Sector*> sectors = m_sectors.sectorsInRect(SectorDirectory::column(bounds.topLeft().longitude()), SectorDirectory::column(bounds.bottomRight().longitude()),
+                                                           SectorDirectory::row(bounds.bottomRight().latitude()), SectorDirectory::row(bounds.topLeft().latitude()));
+
+    for(Sector *sector : sectors)
+    {
+        QMutexLocker sectorLocker(&sector->mutex);
+
+        //zoomed out tiles cover a lot of sectors, read packed and evicted ones from a temporary copy instead of thawing them
+        if(!sector->head)
+        {
+            LocationDataNode *coldHead = nullptr;
+            LocationDataNode *coldLast = nullptr;
+            quint64 coldCount = 0;
+
+            SectorCodec::decode(sectorBlock(sector), coldHead, coldLast, coldCount);
+            HeatmapEngine::accumulate(tile, coldHead, density);
+            SectorDirectory::deleteNodes(coldHead);
+        }
+        else
+            HeatmapEngine::accumulate(tile, sector->head, density);
+    }
+
+    m_sectorLock.unlock();
+
+    m_heatmap.insert(tile, stamp, m_heatmap.render(density));
+
+    emit heatmapTileReady();
+}
+
+//must be called with the sector mutex held, reloads evicted sectors from the snapshot
+bool LocationModel::thawSector(Sector *sector)
+{
+    if(sector->packed.isEmpty() && sector->spillOffset < 0)
+        return true;
+
+    LocationDataNode *head = nullptr;
+    LocationDataNode *last = nullptr;
+    quint64 count = 0;
+
+    //the block is the only copy of the rows, it stays until it decodes and the sector stays cold
+    if(!SectorCodec::decode(sectorBlock(sector), head, last, count))
+    {
+        qDebug() << "Could not unpack sector" << sector->id;
+
+        if(!sector->damaged)
+        {
+            sector->damaged = true;
+            errorOccurred("Storage Error", QString("Could not read %1 POIs that were moved out of memory, they are left out until they can be read again.").arg(sector->locations));
+        }
+
+        return false;
+    }
+
+    sector->damaged = false;
+
+    //rows appended while the block couldn't be read go after the ones it held
+    if(sector->head)
+    {
+        last->next = sector->head;
+
+        delete sector->index;
+        sector->index = nullptr;
+        ++sector->revision;
+    }
+    else
+        sector->last = last;
+
+    sector->head = head;
+
+    qint64 bytes = 0;
+
+    for(LocationDataNode *node = sector->head; node; node = node->next)
+        bytes += nodeBytes(node->data);
+
+    if(sector->spillOffset >= 0)
+    {
+        m_snapshot.release(sector->spillOffset, sector->spillSize);
+        sector->spillOffset = -1;
+        sector->spillSize = 0;
+    }
+
+    sector->packed.clear();
+    accountSector(sector, count, bytes);
+
+    return true;
+}
+
+//must be called with the sector mutex held
+void LocationModel::freezeSector(Sector *sector)
+{
+    //a block that couldn't be thawed still holds rows the nodes don't
+    if(!sector->head || !sector->packed.isEmpty() || sector->spillOffset >= 0)
+        return;
+
+    sector->packed = SectorCodec::encode(sector->head);
+
+    //cached clusters point into the nodes that are about to go away
+    ++sector->revision;
+
+    SectorDirectory::deleteNodes(sector->head);
+    sector->head = nullptr;
+    sector->last = nullptr;
+
+    delete sector->index;
+    sector->index = nullptr;
+
+    accountSector(sector, -static_cast<qint64>(sector->locations), sector->packed.size());
+}
+
+//must be called with the sector mutex held, packs the sector first if it is thawed
+bool LocationModel::evictSector(Sector *sector)
+{
+    freezeSector(sector);
+
+    if(sector->head || sector->packed.isEmpty())
+        return false;
+
+    //a sector that can't be spilled stays packed in memory
+    qint64 offset = m_snapshot.write(sector->packed);
+
+    if(offset < 0)
+        return false;
+
+    sector->spillOffset = offset;
+    sector->spillSize = sector->packed.size();
+    sector->packed = QByteArray();
+
+    accountSector(sector, 0, 0);
+
+    return true;
+}
+
+//must be called with the sector mutex held, empty if the sector is thawed
+QByteArray LocationModel::sectorBlock(Sector *sector)
+{
+    if(!sector->packed.isEmpty())
+        return sector->packed;
+
+    if(sector->spillOffset >= 0)
+        return m_snapshot.read(sector->spillOffset, sector->spillSize);
+
+    return QByteArray();
+}
+
+//must be called with the sector mutex held
+void LocationModel::accountSector(Sector *sector, qint64 pois, qint64 bytes)
+{
+    qint64 delta = bytes - sector->bytes;
+    sector->bytes = bytes;
+
+    m_memoryUsage.fetchAndAddRelaxed(delta);
+    m_metrics->addResident(pois, delta);
+}
+
+//heap behind a node and its strings, allocator overhead left out
+qint64 LocationModel::nodeBytes(const LocationData &data)
+{
+    static constexpr qint64 CoordinateBytes = 40; //shared data of the QGeoCoordinate
+    static constexpr qint64 StringHeader = 16; //header of every non empty string or list allocation
+
+    qint64 bytes = sizeof(LocationDataNode) + CoordinateBytes;
+
+    auto stringBytes = [](const QString &string) -> qint64 {
+        return string.isEmpty() ? 0 : StringHeader + (string.capacity() + 1) * sizeof(QChar);
+    };
+
+    for(const QString *string : { &data.description, &data.encryption, &data.id, &data.name, &data.styleTag, &data.type, &data.mfgid })
+        bytes += stringBytes(*string);
+
+    for(const QStringList *list : { &data.capabilities, &data.rois })
+    {
+        if(list->isEmpty())
+            continue;
+
+        bytes += StringHeader + (list->capacity() * sizeof(QString));
+
+        for(const QString &string : *list)
+            bytes += stringBytes(string);
+    }
+
+    return bytes;
+}
+
+bool LocationModel::overBudget() const
+{
+    qint64 budget = m_memoryBudget.loadRelaxed();
+    return budget > 0 && m_memoryUsage.loadRelaxed() > budget;
+}
+
+//evicts the least recently viewed sectors until the usage is back under the budget
+void LocationModel::evictSectors()
+{
+    if(!overBudget() || m_evicting.testAndSetAcquire(false, true) == false)
+        return;
+
+    auto result = QtConcurrent::run([this]() {
+        TraceSpan span("evict", "memory");
+
+        m_pinnedSectorsMutex.lock();
+        QSet<quint32> pinnedSectors = m_pinnedSectors;
+        for(auto pending = m_pendingSectors.constBegin(); pending != m_pendingSectors.constEnd(); ++pending)
+            pinnedSectors.insert(pending.key());
+        m_pinnedSectorsMutex.unlock();
+
+        QReadLocker locker(&m_sectorLock);
+
+        const QList<Sector*> sectors = m_sectors.sectors();
+        qint64 viewedSince = QDateTime::currentMSecsSinceEpoch() - EvictionGrace;
+
+        //sectors that are busy now were just used, they go last anyway
+        QVector<QPair<qint64, Sector*>> candidates;
+        candidates.reserve(sectors.count());
+
+        for(Sector *sector : sectors)
+        {
+            if(pinnedSectors.contains(sector->id) || !sector->mutex.tryLock())
+                continue;
+
+            if(sector->bytes > 0 && sector->lastAccess < viewedSince)
+                candidates.append(qMakePair(sector->lastAccess, sector));
+
+            sector->mutex.unlock();
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const QPair<qint64, Sector*> &a, const QPair<qint64, Sector*> &b) {
+            return a.first < b.first;
+        });
+
+        qint64 target = static_cast<qint64>(m_memoryBudget.loadRelaxed() * EvictionTarget);
+        quint64 evicted = 0;
+
+        for(const QPair<qint64, Sector*> &candidate : std::as_const(candidates))
+        {
+            if(m_memoryUsage.loadRelaxed() <= target)
+                break;
+
+            Sector *sector = candidate.second;
+
+            if(!sector->mutex.tryLock())
+                continue;
+
+            //skip sectors somebody looked at or pinned since they were picked
+            if(sector->lastAccess == candidate.first && !sectorPinned(sector->id) && evictSector(sector))
+                ++evicted;
+
+            sector->mutex.unlock();
+        }
+
+        span.setCount(evicted);
+
+        if(evicted)
+            qDebug() << "Evicted" << evicted << "sectors," << m_memoryUsage.loadRelaxed() / (1024 * 1024) << "MB resident";
+
+        m_metrics->refresh();
+        m_evicting.storeRelease(false);
+    });
+}
+
+bool LocationModel::sectorPinned(quint32 id) const
+{
+    QMutexLocker locker(&m_pinnedSectorsMutex);
+    return m_pinnedSectors.contains(id) || m_pendingSectors.contains(id);
+}
+
+void LocationModel::freezeIdleSectors()
+{
+    if(m_freezing.testAndSetAcquire(false, true) == false)
+        return;
+
+    auto result = QtConcurrent::run([this]() {
+        m_pinnedSectorsMutex.lock();
+        QSet<quint32> pinnedSectors = m_pinnedSectors;
+        for(auto pending = m_pendingSectors.constBegin(); pending != m_pendingSectors.constEnd(); ++pending)
+            pinnedSectors.insert(pending.key());
+        m_pinnedSectorsMutex.unlock();
+
+        QReadLocker locker(&m_sectorLock);
+
+        const QList<Sector*> sectors = m_sectors.sectors();
+        qint64 idleSince = QDateTime::currentMSecsSinceEpoch() - ColdSectorAge;
+        quint64 frozen = 0;
+
+        for(Sector *sector : sectors)
+        {
+            if(pinnedSectors.contains(sector->id))
+                continue;
+
+            //skip sectors that are busy rather than waiting on them
+            if(!sector->mutex.tryLock())
+                continue;
+
+            if(sector->head && sector->lastAccess < idleSince && !sectorPinned(sector->id))
+            {
+                freezeSector(sector);
+                ++frozen;
+            }
+
+            sector->mutex.unlock();
+        }
+
+        if(frozen)
+            qDebug() << "Packed" << frozen << "idle sectors";
 
-        qDebug() << "Sorted nodes" << totalNodes << "in" << endTime - timeStart << "ms";
+        m_freezing.storeRelease(false);
     });
 }
 
@@ -1088,6 +2488,15 @@ void LocationModel::updateProgress()
         emit loadingFinished();
     }
 
+    //operations that know their size report it through the metrics instead of per row
+    qreal completion = m_metrics->completion();
+
+    if(m_loading && completion >= 0)
+        setProgress(completion);
+
+    if(m_importing)
+        updateImportProgress();
+
     emit progressChanged();
 }
 
@@ -1122,6 +2531,187 @@ void LocationModel::setMpsAverage(qreal mpsAverage)
     emit mpsAverageChanged();
 }
 
+qint64 LocationModel::tileCacheBudget() const
+{
+    return m_clusterTiles.budget();
+}
+
+void LocationModel::setTileCacheBudget(qint64 tileCacheBudget)
+{
+    if (m_clusterTiles.budget() == tileCacheBudget)
+        return;
+    m_clusterTiles.setBudget(tileCacheBudget);
+    emit tileCacheBudgetChanged();
+}
+
+qint64 LocationModel::memoryBudget() const
+{
+    return m_memoryBudget.loadRelaxed() / (1024 * 1024);
+}
+
+void LocationModel::setMemoryBudget(qint64 memoryBudget)
+{
+    memoryBudget = std::max<qint64>(memoryBudget, 0) * 1024 * 1024;
+
+    if (m_memoryBudget.loadRelaxed() == memoryBudget)
+        return;
+    m_memoryBudget.storeRelaxed(memoryBudget);
+    emit memoryBudgetChanged();
+
+    evictSectors();
+}
+
+qint64 LocationModel::memoryUsage() const
+{
+    return m_memoryUsage.loadRelaxed();
+}
+
+bool LocationModel::showWifi() const
+{
+    return m_filter.wifi;
+}
+
+void LocationModel::setShowWifi(bool showWifi)
+{
+    if (m_filter.wifi == showWifi)
+        return;
+    m_filter.wifi = showWifi;
+    emit showWifiChanged();
+    emit filterChanged();
+}
+
+bool LocationModel::showBluetooth() const
+{
+    return m_filter.bluetooth;
+}
+
+void LocationModel::setShowBluetooth(bool showBluetooth)
+{
+    if (m_filter.bluetooth == showBluetooth)
+        return;
+    m_filter.bluetooth = showBluetooth;
+    emit showBluetoothChanged();
+    emit filterChanged();
+}
+
+bool LocationModel::showCellular() const
+{
+    return m_filter.cellular;
+}
+
+void LocationModel::setShowCellular(bool showCellular)
+{
+    if (m_filter.cellular == showCellular)
+        return;
+    m_filter.cellular = showCellular;
+    emit showCellularChanged();
+    emit filterChanged();
+}
+
+bool LocationModel::openOnly() const
+{
+    return m_filter.openOnly;
+}
+
+void LocationModel::setOpenOnly(bool openOnly)
+{
+    if (m_filter.openOnly == openOnly)
+        return;
+    m_filter.openOnly = openOnly;
+    emit openOnlyChanged();
+    emit filterChanged();
+}
+
+QStringList LocationModel::encryptionFilter() const
+{
+    QStringList encryptionFilter;
+
+    if(m_filter.encryption == LocationFilter::AllEncryption)
+        return encryptionFilter;
+
+    for(int encryptionClass = 0; encryptionClass < LocationFilter::EncryptionClasses; ++encryptionClass)
+    {
+        if(m_filter.encryption & (1 << encryptionClass))
+            encryptionFilter += LocationFilter::encryptionName(static_cast<LocationFilter::EncryptionClass>(encryptionClass));
+    }
+
+    return encryptionFilter;
+}
+
+//class names as given by LocationFilter::encryptionName, an empty list shows every class
+void LocationModel::setEncryptionFilter(const QStringList &encryptionFilter)
+{
+    quint32 encryption = encryptionFilter.isEmpty() ? LocationFilter::AllEncryption : 0;
+
+    for(int encryptionClass = 0; encryptionClass < LocationFilter::EncryptionClasses; ++encryptionClass)
+    {
+        if(encryptionFilter.contains(LocationFilter::encryptionName(static_cast<LocationFilter::EncryptionClass>(encryptionClass)), Qt::CaseInsensitive))
+            encryption |= 1 << encryptionClass;
+    }
+
+    if (m_filter.encryption == encryption)
+        return;
+    m_filter.encryption = encryption;
+    emit encryptionFilterChanged();
+    emit filterChanged();
+}
+
+qint64 LocationModel::minimumTimestamp() const
+{
+    return m_filter.minimumTimestamp;
+}
+
+void LocationModel::setMinimumTimestamp(qint64 minimumTimestamp)
+{
+    if (m_filter.minimumTimestamp == minimumTimestamp)
+        return;
+    m_filter.minimumTimestamp = minimumTimestamp;
+    emit minimumTimestampChanged();
+    emit filterChanged();
+}
+
+qint64 LocationModel::maximumTimestamp() const
+{
+    return m_filter.maximumTimestamp;
+}
+
+void LocationModel::setMaximumTimestamp(qint64 maximumTimestamp)
+{
+    if (m_filter.maximumTimestamp == maximumTimestamp)
+        return;
+    m_filter.maximumTimestamp = maximumTimestamp;
+    emit maximumTimestampChanged();
+    emit filterChanged();
+}
+
+qreal LocationModel::minimumSignal() const
+{
+    return m_filter.minimumSignal;
+}
+
+void LocationModel::setMinimumSignal(qreal minimumSignal)
+{
+    if (m_filter.minimumSignal == minimumSignal)
+        return;
+    m_filter.minimumSignal = minimumSignal;
+    emit minimumSignalChanged();
+    emit filterChanged();
+}
+
+qreal LocationModel::maximumSignal() const
+{
+    return m_filter.maximumSignal;
+}
+
+void LocationModel::setMaximumSignal(qreal maximumSignal)
+{
+    if (m_filter.maximumSignal == maximumSignal)
+        return;
+    m_filter.maximumSignal = maximumSignal;
+    emit maximumSignalChanged();
+    emit filterChanged();
+}
+
 QDir LocationModel::getDatabaseDirectory(QString name)
 {
     if(name.isEmpty())
@@ -1204,35 +2794,330 @@ void LocationModel::resetDataModel()
     endResetModel();
 }
 
-void LocationModel::resetSectorData()
+qint64 LocationModel::timelineStart() const
 {
-    //clear sectored data
-    for(int longitude = 0; longitude < 360; ++longitude)
-    {
-        for(int latitude = 0; latitude < 180; ++latitude)
+    return m_earliestTimestamp.loadRelaxed();
+}
+
+qint64 LocationModel::timelineEnd() const
+{
+    return m_latestTimestamp.loadRelaxed();
+}
+
+bool LocationModel::replaying() const
+{
+    return m_replaying;
+}
+
+qint64 LocationModel::replayPosition() const
+{
+    return m_replayPosition;
+}
+
+qreal LocationModel::replaySpeed() const
+{
+    return m_replaySpeed;
+}
+
+void LocationModel::setReplaySpeed(qreal replaySpeed)
+{
+    if (qFuzzyCompare(m_replaySpeed, replaySpeed))
+        return;
+    m_replaySpeed = replaySpeed;
+    emit replaySpeedChanged();
+}
+
+void LocationModel::setTimeWindow(qint64 from, qint64 to)
+{
+    bool fromChanged = m_filter.minimumTimestamp != from;
+    bool toChanged = m_filter.maximumTimestamp != to;
+
+    if(!fromChanged && !toChanged)
+        return;
+
+    m_filter.minimumTimestamp = from;
+    m_filter.maximumTimestamp = to;
+
+    if(fromChanged)
+        emit minimumTimestampChanged();
+    if(toChanged)
+        emit maximumTimestampChanged();
+
+    //one query for both ends
+    emit filterChanged();
+}
+
+void LocationModel::startReplay(qint64 from, qint64 to)
+{
+    stopReplay();
+
+    if(from == 0)
+        from = m_earliestTimestamp.loadRelaxed();
+    if(to == 0)
+        to = m_latestTimestamp.loadRelaxed();
+
+    //the rest of the filter still applies
+    LocationFilter filter = m_filter;
+    filter.minimumTimestamp = from;
+    filter.maximumTimestamp = to;
+
+    quint64 generation = ++m_replayGeneration;
+
+    m_replaying = true;
+    m_replayPosition = from;
+    m_replayEnd = to;
+
+    resetDataModel();
+
+    emit replayingChanged();
+    emit replayPositionChanged();
+
+    auto result = QtConcurrent::run([this, filter, generation]() {
+        TraceSpan span("replay", "query");
+        QVector<LocationDataNode> nodes;
+
+        m_sectorLock.lockForRead();
+
+        const QList<Sector*> sectors = m_sectors.sectors();
+
+        for(Sector *sector : sectors)
         {
-            LocationDataNode *node = m_sectors[longitude][latitude].head;
+            QMutexLocker sectorLocker(&sector->mutex);
 
-            while(node)
-            {
-                LocationDataNode *currentNode = node;
-                node = node->next;
+            //a drive only crosses a few sectors, the rest never saw the window
+            if(!sector->locations || sector->latest < filter.minimumTimestamp || (filter.maximumTimestamp && sector->earliest > filter.maximumTimestamp))
+                continue;
+
+            //the replay works on copies, so cold sectors are read from a temporary decode instead of being thawed
+            LocationDataNode *head = sector->head;
+            LocationDataNode *coldHead = nullptr;
+            LocationDataNode *coldLast = nullptr;
+            quint64 coldCount = 0;
 
-                delete currentNode;
+            if(!head && SectorCodec::decode(sectorBlock(sector), coldHead, coldLast, coldCount))
+                head = coldHead;
+
+            for(LocationDataNode *node = head; node; node = node->next)
+            {
+                if(filter.accepts(node->data))
+                    nodes.append(LocationDataNode(node->data));
             }
 
-            m_sectors[longitude][latitude].last = nullptr;
-            m_sectors[longitude][latitude].updated = false;
-            m_sectors[longitude][latitude].locations = 0;
+            SectorDirectory::deleteNodes(coldHead);
+        }
+
+        m_sectorLock.unlock();
+
+        std::stable_sort(nodes.begin(), nodes.end(), [](const LocationDataNode &a, const LocationDataNode &b) {
+            return a.data.timestamp < b.data.timestamp;
+        });
+
+        QMetaObject::invokeMethod(this, [this, nodes = std::move(nodes), generation]() mutable {
+            if(generation != m_replayGeneration)
+                return;
+
+            m_replayNodes = std::move(nodes);
+            m_replayCursor = 0;
+
+            m_replayClock.start();
+            m_replayTimer->start();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void LocationModel::stopReplay()
+{
+    if(!m_replaying)
+        return;
+
+    ++m_replayGeneration;
+    m_replayTimer->stop();
+    m_replaying = false;
+
+    //the rows point into the replay nodes
+    resetDataModel();
+
+    m_replayNodes.clear();
+    m_replayCursor = 0;
+
+    emit replayingChanged();
+}
+
+void LocationModel::advanceReplay()
+{
+    m_replayPosition = std::min(m_replayEnd, m_replayPosition + static_cast<qint64>(m_replayClock.restart() * m_replaySpeed));
+
+    qsizetype first = m_replayCursor;
+    qsizetype last = first;
+
+    while(last < m_replayNodes.count() && m_replayNodes[last].data.timestamp <= m_replayPosition)
+        ++last;
+
+    //only the newly discovered POIs are inserted, the rows already on the map stay put
+    if(last > first)
+    {
+        beginInsertRows(QModelIndex(), m_filteredData.count(), m_filteredData.count() + (last - first) - 1);
+
+        for(qsizetype index = first; index < last; ++index)
+        {
+            LocationDataNode &node = m_replayNodes[index];
+
+            LocationCluster cluster;
+            cluster.coordinates = node.data.coordinates;
+            cluster.setRepresentative(&node);
+            cluster.color = clusterColor(1);
+
+            m_filteredData.append(cluster);
         }
+
+        endInsertRows();
+
+        m_replayCursor = last;
+    }
+
+    emit replayPositionChanged();
+
+    //the last frame stays up until the replay is stopped
+    if(m_replayPosition >= m_replayEnd)
+        m_replayTimer->stop();
+}
+
+bool LocationModel::tracing() const
+{
+    return Tracer::enabled();
+}
+
+void LocationModel::setTracing(bool tracing)
+{
+    if(Tracer::enabled() == tracing)
+        return;
+
+    //a new recording starts with empty buffers
+    if(tracing)
+        Tracer::clear();
+
+    Tracer::setEnabled(tracing);
+    emit tracingChanged();
+}
+
+QString LocationModel::dumpTrace(QString fileName)
+{
+    if(fileName.startsWith("file://", Qt::CaseInsensitive))
+        fileName = QUrl(fileName).toLocalFile();
+
+    //every directory in the data location is listed as a database, so traces go inside one
+    if(fileName.isEmpty())
+        fileName = getDatabaseDirectory().absoluteFilePath(QString("trace-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss")));
+
+    return Tracer::dump(fileName) ? fileName : QString();
+}
+
+PipelineMetrics *LocationModel::metrics() const
+{
+    return m_metrics;
+}
+
+QVariantMap LocationModel::viewportStats() const
+{
+    return m_viewportStats;
+}
+
+void LocationModel::updateViewportStats(QGeoShape area)
+{
+    m_viewportArea = area;
+
+    QVariantMap viewportStats = m_aggregates.statsInShape(area).toVariantMap();
+
+    if (m_viewportStats == viewportStats)
+        return;
+    m_viewportStats = viewportStats;
+    emit viewportStatsChanged();
+}
+
+QVariantMap LocationModel::statsInArea(QGeoShape area) const
+{
+    return m_aggregates.statsInShape(area).toVariantMap();
+}
+
+void LocationModel::search(QString query, int limit)
+{
+    quint64 generation = ++m_searchGeneration;
+
+    if(query.trimmed().length() < MinimumSearchLength)
+    {
+        emit searchFinished(query, QVariantList());
+        return;
     }
 
+    //queries still waiting were typed over
+    m_searchPool.clear();
+    m_searchPool.start([this, query, limit, generation]() {
+        if(generation != m_searchGeneration.loadRelaxed())
+            return;
+
+        TraceSpan span("search", "query");
+        QVariantList results;
+
+        for(const SearchMatch &match : m_searchIndex.search(query, limit))
+        {
+            QVariantMap result;
+            result["id"] = match.id;
+            result["name"] = match.name;
+            result["mfgid"] = match.mfgid;
+            result["type"] = match.type;
+            result["coordinate"] = QVariant::fromValue(match.coordinates);
+            result["rank"] = match.rank;
+
+            results.append(result);
+        }
+
+        QMetaObject::invokeMethod(this, [this, query, results, generation]() {
+            if(generation == m_searchGeneration.loadRelaxed())
+                emit searchFinished(query, results);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void LocationModel::resetSectorData()
+{
+    //drop the rows pointing into the sectors before the nodes go away
+    resetDataModel();
+
+    stopReplay();
+
+    m_earliestTimestamp.storeRelaxed(0);
+    m_latestTimestamp.storeRelaxed(0);
+    emit timelineChanged();
+
+    QWriteLocker locker(&m_sectorLock);
+    ++m_sectorGeneration;
+
+    //clear sectored data
+    m_sectors.clear();
+    m_snapshot.clear();
+    m_memoryUsage.storeRelaxed(0);
+    m_metrics->resetResident();
+    m_clusterTiles.clear();
+    m_searchIndex.clear();
+    m_aggregates.clear();
+    updateViewportStats(m_viewportArea);
+
+    //otherwise the next database would skip every id the last one had
+    m_idsMutex.lock();
+    m_ids.clear();
+    m_idsMutex.unlock();
+
     setTotalPointsOfInterest(0);
     setBluetoothPointsOfInterest(0);
     setCellularPointsOfInterest(0);
     setWifiPointsOfInterest(0);
 }
 
+bool LocationModel::loading() const
+{
+    return m_loading;
+}
+
 void LocationModel::startLoading(QString title)
 {
     m_loading = true;
@@ -1248,18 +3133,23 @@ void LocationModel::endLoading()
     m_progress = -1;
     setLoadingTitle("Loading");
     stopUpdateTimer();
+    updateViewportStats(m_viewportArea);
+    emit timelineChanged();
     emit loadingFinished();
 }
 
 void LocationModel::resetDatabase()
 {
     startLoading("Resetting Database");
+
+    //a load or import streaming in between its chunks must not refill the sectors from the deleted database
+    ++m_loadGeneration;
+
     auto result = QtConcurrent::run([this](){
         m_databaseMutex.lock();
 
-        //clear filtered data
-        resetDataModel();
-        resetSectorData();
+        //clear filtered and sectored data, on the model's thread since it stops the replay and resets the rows
+        QMetaObject::invokeMethod(this, [this]() { resetSectorData(); }, Qt::BlockingQueuedConnection);
 
         QFile::remove(getDatabaseDirectory().absoluteFilePath(m_loadedDatabase + ".db"));
         getDatabaseDirectory().rmdir(getDatabaseDirectory().absolutePath());
@@ -1274,6 +3164,9 @@ void LocationModel::resetDatabase()
     connect(&watcher, &QFutureWatcher<void>::finished, this, [this](){
         endLoading();
 
+        //the cancelled load never gets to end it
+        m_streaming = false;
+
         if(m_loadedDatabase == "default")
             createDatabase("default");
         else
@@ -1303,17 +3196,8 @@ void LocationModel::createDatabase(QString name)
             return;
         }
 
-        QString command = "CREATE TABLE IF NOT EXISTS pois (id TEXT PRIMARY KEY, name TEXT, timestamp TEXT, type TEXT";
-        command += ", mfgid TEXT, description BLOB, longitude TEXT, latitude TEXT, rois TEXT, capabilities TEXT";
-        command += ", style TEXT, encryption TEXT, open TEXT, signal TEXT, frequency TEXT, accuracy TEXT)";
-        QSqlQuery query;
-
-        query.prepare(command);
-        if(!query.exec())
-        {
-            qDebug() << "Could not open database" << database.lastError();
+        if(!createTables(database))
             return;
-        }
 
         database.close();
 
@@ -1330,6 +3214,53 @@ void LocationModel::createDatabase(QString name)
     });
 }
 
+bool LocationModel::createTables(QSqlDatabase &database)
+{
+    QString command = "CREATE TABLE IF NOT EXISTS pois (id TEXT PRIMARY KEY, name TEXT, timestamp TEXT, type TEXT";
+    command += ", mfgid TEXT, description BLOB, longitude TEXT, latitude TEXT, rois TEXT, capabilities TEXT";
+    command += ", style TEXT, encryption TEXT, open TEXT, signal TEXT, frequency TEXT, accuracy TEXT)";
+    QSqlQuery query(database);
+
+    query.prepare(command);
+    if(!query.exec())
+    {
+        qDebug() << "Could not open database" << database.lastError();
+        return false;
+    }
+
+    if(!query.exec(QString("CREATE INDEX IF NOT EXISTS pois_position ON pois(%1)").arg(PoiPositionColumns)))
+        qDebug() << "Could not create position index" << query.lastError();
+
+    return true;
+}
+
+bool LocationModel::prepareInsert(QSqlQuery &query)
+{
+    return query.prepare("INSERT OR REPLACE INTO pois(id, accuracy, longitude, latitude, description, encryption, name, open, signal, style, type, timestamp, mfgid, frequency, capabilities, rois) "
+                         "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+}
+
+//same text encoding save() writes, so decodeRow() reads both
+void LocationModel::bindInsert(QSqlQuery &query, const LocationData &data)
+{
+    query.bindValue(0, data.id);
+    query.bindValue(1, QString::number(data.accuracy));
+    query.bindValue(2, QString::number(data.coordinates.longitude()));
+    query.bindValue(3, QString::number(data.coordinates.latitude()));
+    query.bindValue(4, QString(QUrl::toPercentEncoding(data.description)));
+    query.bindValue(5, data.encryption);
+    query.bindValue(6, QString(QUrl::toPercentEncoding(data.name)));
+    query.bindValue(7, QString::number(data.open));
+    query.bindValue(8, QString::number(data.signal));
+    query.bindValue(9, data.styleTag);
+    query.bindValue(10, data.type);
+    query.bindValue(11, QString::number(data.timestamp));
+    query.bindValue(12, data.mfgid);
+    query.bindValue(13, QString::number(data.frequency));
+    query.bindValue(14, data.capabilities.join(':'));
+    query.bindValue(15, data.rois.join(':'));
+}
+
 void LocationModel::startUpdateTimer()
 {
     if(!m_updateTimer->isActive())
@@ -1347,6 +3278,16 @@ void LocationModel::stopUpdateTimer()
         m_updateTimer->stop();
 }
 
+//rows waiting on the database count as the writer queue
+void LocationModel::storeRow(const LocationData &data)
+{
+    m_metrics->addWrites(1);
+    m_databaseMutex.lock();
+    addToDataBase(data);
+    m_databaseMutex.unlock();
+    m_metrics->addWrites(-1);
+}
+
 void LocationModel::addToDataBase(const LocationData &data)
 {
     bool close = false;
@@ -1365,7 +3306,7 @@ void LocationModel::addToDataBase(const LocationData &data)
     command += QString(" \"%1\", \"%2\", \"%3\"").arg(QString::number(data.accuracy), QString::number(data.coordinates.longitude()), QString::number(data.coordinates.latitude()));
     command += QString(", \"%1\", \"%2\", \"%3\"").arg(sanitizedDescription, data.encryption, QUrl::toPercentEncoding(data.name));
     command += QString(", \"%1\", \"%2\", \"%3\"").arg(QString::number(data.open), QString::number(data.signal), data.styleTag);
-    command += QString(", \"%1\", \"%2\", \"%3\"").arg(data.type, data.timestamp.toString(), data.mfgid);
+    command += QString(", \"%1\", \"%2\", \"%3\"").arg(data.type, QString::number(data.timestamp), data.mfgid);
     command += QString(", \"%1\", \"%2\", \"%3\")").arg(QString::number(data.frequency), data.capabilities.join(':'), data.rois.join(':'));
 
     if(!query.exec(command))
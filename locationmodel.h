@@ -13,6 +13,11 @@
 #include <QXmlStreamWriter>
 #include <QStringView>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QSharedPointer>
+#include <QThreadPool>
 #include <QtPositioning>
 #include <QtLocation>
 #include <QGeoLocation>
@@ -25,6 +30,18 @@
 #include <QSqlQuery>
 #include <QSqlError>
 
+#include "areaaggregates.h"
+#include "clustertilecache.h"
+#include "fieldparser.h"
+#include "heatmapengine.h"
+#include "pipelinemetrics.h"
+#include "sectordirectory.h"
+#include "sectorindex.h"
+#include "sectorsnapshot.h"
+#include "timestampparser.h"
+#include "tracer.h"
+#include "trigramindex.h"
+
 /*
  * Location data memory mapping
  *
@@ -35,20 +52,9 @@
  */
 struct LocationDataNode;
 
-struct Sector
-{
-    LocationDataNode *head = nullptr;
-    LocationDataNode *last = nullptr;
-
-    quint64 locations;
-    bool updated = false;
-    QMutex mutex;
-};
-
 struct LocationData
 {
     qreal accuracy = 0;
-    qint64 clusterCount = 1;
     QGeoCoordinate coordinates;
     QString description;
     QString encryption;
@@ -58,19 +64,12 @@ struct LocationData
     qreal signal = 0;
     QString styleTag;
     QString type;
-    QDateTime timestamp;
+    qint64 timestamp = 0; //ms since epoch
     QString mfgid;
-    qreal frequency;
+    qreal frequency = 0;
     QStringList capabilities;
     QStringList rois;
-
-    QColor color = QColor(0,0,128,200);
-    qreal dotSize = 20;
-
-    LocationDataNode *children = nullptr;
-    LocationDataNode *lastChild = nullptr;
-
-    ~LocationData();
+    quint8 source = 0; //0 for the loaded database, n for the nth attached one
 
     inline bool operator > (const LocationData &other)
     {
@@ -94,6 +93,54 @@ struct LocationDataNode
 
 Q_DECLARE_METATYPE(LocationDataNode)
 
+/*
+ * Viewport cluster record
+ *
+ * The viewport pipeline only produces these compact records. The representative's role values are copied
+ * in when the record is built, the strings share their data with the node, so delegates read the record
+ * alone and never touch the node.
+ */
+struct LocationCluster
+{
+    QGeoCoordinate coordinates; //centroid of all members
+    qint64 timestamp = 0; //representative timestamp in ms since epoch
+    qint64 clusterCount = 1;
+    LocationDataNode *representative = nullptr;
+    QColor color = QColor(0,0,128,200);
+    qreal dotSize = 20;
+
+    //role values of the representative
+    QString name;
+    QString styleTag;
+    QString description;
+    QString type;
+    QString encryption;
+    int open = 0;
+    qreal accuracy = 0;
+    qreal signal = 0;
+
+    inline void setRepresentative(LocationDataNode *node)
+    {
+        const LocationData &data = node->data;
+
+        representative = node;
+        timestamp = data.timestamp;
+        name = data.name;
+        styleTag = data.styleTag;
+        description = data.description;
+        type = data.type;
+        encryption = data.encryption;
+        open = data.open;
+        accuracy = data.accuracy;
+        signal = data.signal;
+    }
+};
+
+Q_DECLARE_METATYPE(LocationCluster)
+
+struct ImportFile;
+class ImportQueue;
+
 class LocationModel : public QAbstractListModel
 {
     QML_ELEMENT
@@ -112,7 +159,8 @@ public:
         AccuracyRole,
         SignalRole,
         ColorRole,
-        SizeRole
+        SizeRole,
+        ClusterCountRole
     };
 
     Q_ENUM(LocationDataRole)
@@ -122,23 +170,47 @@ public:
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index = QModelIndex(), int role = Qt::DisplayRole)const override;
+    void multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const override;
 
     QHash<int, QByteArray> roleNames() const override;
 
     void clear();
     double logScale(double percentage, double min = 10, double max = 500000.0);
 
-    void parseKML(QString fileName);
-    void parseCSV(QString fileName);
+    //imports go through one queue, files opened while an import runs are imported right after it
     Q_INVOKABLE void openFile(QString fileName);
+    Q_INVOKABLE void openFiles(QStringList fileNames); //files or directories
+    Q_INVOKABLE void openDirectory(QString path); //every CSV and KML file below path
+
+    //per file state of the running or last import
+    QVariantList importProgress() const;
+
+    //true while an import runs, the map stays usable and fills in as rows arrive
+    bool importing() const;
+
+    //cached heatmap tile, possibly stale, a current one is drawn in the background if needed
+    QImage heatmapTile(int zoom, int x, int y, bool weighted);
 
     qreal progress() const;
     void setProgress(qreal progress);
 
-    void append(const LocationData &data, bool save = true);
+    //false if the ID is already shown. A row of the loaded database whose ID only an attached one has
+    //is still new to the loaded database, local reports that and save writes it
+    bool append(const LocationData &data, bool save = true, bool *local = nullptr);
     void sort();
     Q_INVOKABLE void save();
-    Q_INVOKABLE void load(QString database);
+    Q_INVOKABLE void load(QString database, QGeoCoordinate focus = QGeoCoordinate());
+
+    //shows other databases together with the loaded one, without copying their rows into it
+    Q_INVOKABLE void attach(QString database);
+    Q_INVOKABLE void detach(QString database);
+    QStringList attachedDatabases() const;
+
+    //streams every loaded POI, or only what the filtered viewport shows, as WiGLE CSV, KML or GeoJSON
+    //picked by the extension. A name ending in .gz is gzip compressed
+    Q_INVOKABLE void exportFile(QString fileName, bool viewport = false);
+
+    bool loading() const;
 
     quint64 totalPointsOfInterest() const;
     void setTotalPointsOfInterest(quint64 totalPointsOfInterest);
@@ -203,13 +275,92 @@ public:
     qreal mpsAverage() const;
     void setMpsAverage(qreal mpsAverage);
 
+    qint64 tileCacheBudget() const;
+    void setTileCacheBudget(qint64 tileCacheBudget);
+
+    //MB, 0 for no limit
+    qint64 memoryBudget() const;
+    void setMemoryBudget(qint64 memoryBudget);
+
+    //bytes held by the sectors
+    qint64 memoryUsage() const;
+
+    bool showWifi() const;
+    void setShowWifi(bool showWifi);
+
+    bool showBluetooth() const;
+    void setShowBluetooth(bool showBluetooth);
+
+    bool showCellular() const;
+    void setShowCellular(bool showCellular);
+
+    bool openOnly() const;
+    void setOpenOnly(bool openOnly);
+
+    QStringList encryptionFilter() const;
+    void setEncryptionFilter(const QStringList &encryptionFilter);
+
+    qint64 minimumTimestamp() const;
+    void setMinimumTimestamp(qint64 minimumTimestamp);
+
+    qint64 maximumTimestamp() const;
+    void setMaximumTimestamp(qint64 maximumTimestamp);
+
+    qreal minimumSignal() const;
+    void setMinimumSignal(qreal minimumSignal);
+
+    qreal maximumSignal() const;
+    void setMaximumSignal(qreal maximumSignal);
+
+    qint64 timelineStart() const;
+    qint64 timelineEnd() const;
+
+    bool replaying() const;
+    qint64 replayPosition() const;
+
+    qreal replaySpeed() const;
+    void setReplaySpeed(qreal replaySpeed);
+
+    QVariantMap viewportStats() const;
+
+    PipelineMetrics *metrics() const;
+
+    bool tracing() const;
+    void setTracing(bool tracing);
+
+    //writes the spans recorded since tracing was switched on as Chrome trace JSON, an empty name
+    //picks a file in the loaded database's directory. Returns the file written or an empty string
+    Q_INVOKABLE QString dumpTrace(QString fileName = "");
+
+    //restricts viewport queries to [from, to], 0 leaves that end open
+    Q_INVOKABLE void setTimeWindow(qint64 from, qint64 to);
+
+    //plays the POIs of [from, to] back in discovery order, 0 uses the start or end of the timeline
+    Q_INVOKABLE void startReplay(qint64 from = 0, qint64 to = 0);
+    Q_INVOKABLE void stopReplay();
+
     QDir getDatabaseDirectory(QString name = "");
 
+    //pois table and its indexes, shared with anything else that writes a wdrvr database
+    static bool createTables(QSqlDatabase &database);
+    static bool prepareInsert(QSqlQuery &query);
+    static void bindInsert(QSqlQuery &query, const LocationData &data);
+
 public slots:
     Q_INVOKABLE void getPointsInRect(QGeoShape area, qreal zoomLevel);
 
+    //name and manufacturer substring search, ranked. Runs in the background and answers with
+    //searchFinished, queries shorter than MinimumSearchLength answer with nothing
+    Q_INVOKABLE void search(QString query, int limit = 20);
+
+    //summaries from the cell aggregates, no POIs are visited
+    Q_INVOKABLE void updateViewportStats(QGeoShape area);
+    Q_INVOKABLE QVariantMap statsInArea(QGeoShape area) const;
+
 private slots:
     void updateProgress();
+    void freezeIdleSectors();
+    void advanceReplay();
     void errorOccurred(QString title, QString message);
 
 signals:
@@ -224,6 +375,9 @@ signals:
 
     void wifiPointsOfInterestChanged();
     void loadingFinished();
+    void sectorsUpdated();
+    void heatmapTileReady();
+    void searchFinished(QString query, QVariantList results);
     void loadingStarted();
 
     void databaseChanged();
@@ -258,32 +412,46 @@ signals:
 
     void mpsAverageChanged();
 
-private:
+    void tileCacheBudgetChanged();
 
-    const QStringList wifiTypeKeys {
-        "WIFI"
-    };
+    void memoryBudgetChanged();
+    void memoryUsageChanged();
 
-    const QStringList bluetoothTypeKeys {
-        "BT",
-        "BLE"
-    };
+    void showWifiChanged();
+    void showBluetoothChanged();
+    void showCellularChanged();
+    void openOnlyChanged();
+    void encryptionFilterChanged();
+    void minimumTimestampChanged();
+    void maximumTimestampChanged();
+    void minimumSignalChanged();
+    void maximumSignalChanged();
 
-    const QStringList cellTypeKeys {
-        "GSM",
-        "CDMA",
-        "WCDMA",
-        "LTE",
-        "NR"
-    };
+    //any of the filters changed
+    void filterChanged();
+
+    void timelineChanged();
+    void replayingChanged();
+    void replayPositionChanged();
+    void replaySpeedChanged();
+
+    void viewportStatsChanged();
+    void tracingChanged();
+    void importProgressChanged();
+    void importingChanged();
+    void attachedDatabasesChanged();
 
-    QHash<QString, int> m_ids;
+private:
+
+    static constexpr int LoadedId = 0x100; //m_ids flag, the loaded database has the ID
+
+    QHash<QString, int> m_ids; //source of the shown copy, or'd with LoadedId
     QSqlDriver *m_sqlDriver = nullptr;
     QSqlDatabase m_sqlDatabase;
 
     void calculateMPS();
+    QVariant roleData(const LocationCluster &cluster, int role) const;
 
-    QRegularExpression m_kmlDescriptionSeparator = QRegularExpression("(?<!:)\\s");
     QString m_database = "default";
     QString m_loadedDatabase = "default";
     QStringList m_availableDatabases { "default" };
@@ -292,7 +460,7 @@ private:
 
     QString m_currentPage = "map";
 
-    Sector m_sectors[360][180];
+    SectorDirectory m_sectors;
     bool m_loading = false;
 
     QFutureWatcher<void> watcher;
@@ -300,18 +468,164 @@ private:
     bool m_debug = false;
     void resetDataModel();
     void resetSectorData();
+    bool thawSector(Sector *sector); //false if the cold block couldn't be read, it is kept for another try
+    void freezeSector(Sector *sector);
+    bool evictSector(Sector *sector);
+    QByteArray sectorBlock(Sector *sector);
+    void accountSector(Sector *sector, qint64 pois, qint64 bytes);
+    static qint64 nodeBytes(const LocationData &data);
+    bool overBudget() const;
+    void evictSectors();
+    void publishLoadedSectors();
+    void publishCounters();
+    void publishImportedSectors();
+    quint64 sectorStamp(const QList<Sector*> &sectors) const;
+    ClusterTile clusterTile(int step, int zoom, int column, int row, const LocationFilter &filter, qint64 now, bool &cached, quint64 &totalNodes, QList<quint32> *pinned = nullptr);
+    quint64 heatmapStamp(const HeatmapEngine::Tile &tile);
+    void renderHeatmapTile(const HeatmapEngine::Tile &tile, quint64 stamp);
     void startLoading(QString title);
     void endLoading();
+    void endStreaming(quint64 generation);
     void startUpdateTimer();
     void stopUpdateTimer();
+    void storeRow(const LocationData &data);
     void addToDataBase(const LocationData &data);
+    void startImport();
+    void importFiles(const QList<QSharedPointer<ImportFile>> &files, const QString &database, quint64 generation);
+    void parseImportFile(ImportQueue &queue, ImportFile *file, int index);
+    void finishImport();
+    void updateImportProgress();
+    bool attachRows(const QString &database, quint8 source, quint64 generation);
     QTimer *createUpdateTimer();
 
     //Mutexes
     QMutex m_threadMutex; //original generic mutex. will be replaced with specific mutexes
     QMutex m_databaseMutex; //database specific mutex
+    QMutex m_idsMutex; //guards m_ids while a background load and an import append together
+
+    QAtomicInteger<quint64> m_loadGeneration = 0; //bumped by load() to cancel a background load
+    static constexpr quint64 LoadChunkRows = 50000; //rows read per hold of the database mutex
+
+    //cold storage
+    static constexpr int ColdStorageInterval = 30000; //ms between sweeps for idle sectors
+    static constexpr qint64 ColdSectorAge = 120000; //ms without a query or append before a sector is packed
+
+    QTimer *m_coldStorageTimer = nullptr;
+    QAtomicInteger<bool> m_freezing = false;
+    QSet<quint32> m_pinnedSectors; //sectors the current rows point into
+    QHash<quint32, int> m_pendingSectors; //sectors viewport results point into until they are swapped in, results overlap
+    mutable QMutex m_pinnedSectorsMutex;
+
+    bool sectorPinned(quint32 id) const;
+
+    //memory budget
+    static constexpr qreal EvictionTarget = 0.9; //share of the budget an eviction frees down to
+    static constexpr qint64 EvictionGrace = 5000; //ms a viewed sector is kept before it may be evicted
+
+    QAtomicInteger<qint64> m_memoryBudget = 0; //bytes, 0 for no limit
+    QAtomicInteger<qint64> m_memoryUsage = 0;
+    QAtomicInteger<bool> m_evicting = false;
+    SectorSnapshot m_snapshot;
+
+    //clustered viewport tiles
+    ClusterTileCache m_clusterTiles;
+    LocationFilter m_filter;
+
+    //name search
+    static constexpr int MinimumSearchLength = 3; //shorter queries have no trigram and would scan every name
+
+    TrigramIndex m_searchIndex;
+    QThreadPool m_searchPool;
+    QAtomicInteger<quint64> m_searchGeneration = 0; //bumped by every query, older ones are dropped
+
+    //per cell counters
+    AreaAggregates m_aggregates;
+    QGeoShape m_viewportArea;
+    QVariantMap m_viewportStats;
+
+    //live counters, the progress bar reads them at ProgressInterval instead of every row setting it
+    static constexpr int ProgressInterval = 100; //ms
+    PipelineMetrics *m_metrics = nullptr;
+
+    //import
+    static constexpr int ImportBatchRows = 4096; //rows a parser hands to the ingest at once
+    static constexpr qint64 ImportPublishInterval = 500; //ms between map updates while importing
+
+    QThreadPool m_importPool; //parsers, the ingest runs on the global pool
+    QStringList m_pendingImports;
+    QList<QSharedPointer<ImportFile>> m_importFiles;
+    QVariantList m_importProgress;
+    bool m_importing = false;
+    bool m_streaming = false; //a load is still streaming rows in, imports wait for it
+    QFutureWatcher<void> m_importWatcher;
+    QSet<quint32> m_importedSectors; //added by the ingest, not on the map yet
+    QMutex m_importedSectorsMutex;
+
+    //export
+    static constexpr quint64 ExportBatchPois = 16384; //POIs a formatter takes at once, whole sectors are rounded up
+    static constexpr int ExportWindow = 4; //formatted batches per export thread waiting for the writer
+
+    QThreadPool m_exportPool; //formatters, the writer runs on the global pool
+
+    //attached databases, streamed in after the loaded one, IDs the sectors already hold are skipped
+    static constexpr int MaximumAttachedDatabases = 255;
+
+    QStringList m_attachedDatabases;
+
+    //tracing
+    static constexpr quint64 TraceChunkRows = 10000; //rows per import and load span
+
+    //timeline
+    static constexpr int ReplayFrameInterval = 16; //ms
+
+    QAtomicInteger<qint64> m_earliestTimestamp = 0;
+    QAtomicInteger<qint64> m_latestTimestamp = 0;
+
+    //copies sorted by timestamp, the replay rows point into these so packing can't pull them away
+    QVector<LocationDataNode> m_replayNodes;
+    qsizetype m_replayCursor = 0;
+    qint64 m_replayPosition = 0;
+    qint64 m_replayEnd = 0;
+    qreal m_replaySpeed = 60; //timeline ms per real ms
+    bool m_replaying = false;
+    quint64 m_replayGeneration = 0; //bumped by start and stop to drop stale builds
+    QTimer *m_replayTimer = nullptr;
+    QElapsedTimer m_replayClock;
+
+    //prefetch
+    static constexpr qint64 PrefetchLookahead = 750; //ms of panning to predict
+    static constexpr qint64 PanGestureTimeout = 1000; //ms between requests before the pan velocity is forgotten
+    static constexpr int MaximumPrefetchTiles = 32;
+
+    struct PrefetchTile
+    {
+        int step = 0;
+        int zoom = 0;
+        int column = 0;
+        int row = 0;
+    };
+
+    static void appendPrefetchTiles(QList<PrefetchTile> &tiles, QSet<quint64> &seen, const QGeoRectangle &bounds, int step, int zoom);
+    QList<PrefetchTile> predictTiles(const QGeoRectangle &bounds, int step, int zoom);
+    void prefetchTiles(const QList<PrefetchTile> &tiles, const LocationFilter &filter, quint64 generation);
+
+    SectorIndex *indexSector(Sector *sector);
+
+    QThreadPool m_prefetchPool;
+    QAtomicInteger<quint64> m_prefetchGeneration = 0; //bumped by every real viewport request
+    QGeoCoordinate m_lastViewportCenter;
+    qint64 m_lastViewportTime = 0;
+    int m_lastViewportStep = -1;
+    QPointF m_panVelocity; //degrees of longitude and latitude per ms
+    int m_zoomDirection = 0;
+
+    //heatmap
+    HeatmapEngine m_heatmap;
+    QThreadPool m_heatmapPool;
 
-    QVector<LocationData> m_filteredData;
+    QVector<LocationCluster> m_filteredData;
+    QReadWriteLock m_sectorLock; //held for reading while gathering, for writing while sectors are destroyed
+    quint64 m_sectorGeneration = 0; //bumped whenever sector nodes are destroyed
     qreal m_progress = 0;
     QString m_loadingTitle = "Loading";
     QTimer *m_updateTimer = nullptr;
@@ -363,6 +677,29 @@ private:
     Q_PROPERTY(quint64 nrStats READ nrStats WRITE setNrStats NOTIFY nrStatsChanged FINAL)
     Q_PROPERTY(quint64 wifiStats READ wifiStats WRITE setWifiStats NOTIFY wifiStatsChanged FINAL)
     Q_PROPERTY(qreal mpsAverage READ mpsAverage WRITE setMpsAverage NOTIFY mpsAverageChanged FINAL)
+    Q_PROPERTY(qint64 tileCacheBudget READ tileCacheBudget WRITE setTileCacheBudget NOTIFY tileCacheBudgetChanged FINAL)
+    Q_PROPERTY(qint64 memoryBudget READ memoryBudget WRITE setMemoryBudget NOTIFY memoryBudgetChanged FINAL)
+    Q_PROPERTY(qint64 memoryUsage READ memoryUsage NOTIFY memoryUsageChanged FINAL)
+    Q_PROPERTY(bool showWifi READ showWifi WRITE setShowWifi NOTIFY showWifiChanged FINAL)
+    Q_PROPERTY(bool showBluetooth READ showBluetooth WRITE setShowBluetooth NOTIFY showBluetoothChanged FINAL)
+    Q_PROPERTY(bool showCellular READ showCellular WRITE setShowCellular NOTIFY showCellularChanged FINAL)
+    Q_PROPERTY(bool openOnly READ openOnly WRITE setOpenOnly NOTIFY openOnlyChanged FINAL)
+    Q_PROPERTY(QStringList encryptionFilter READ encryptionFilter WRITE setEncryptionFilter NOTIFY encryptionFilterChanged FINAL)
+    Q_PROPERTY(qint64 minimumTimestamp READ minimumTimestamp WRITE setMinimumTimestamp NOTIFY minimumTimestampChanged FINAL)
+    Q_PROPERTY(qint64 maximumTimestamp READ maximumTimestamp WRITE setMaximumTimestamp NOTIFY maximumTimestampChanged FINAL)
+    Q_PROPERTY(qreal minimumSignal READ minimumSignal WRITE setMinimumSignal NOTIFY minimumSignalChanged FINAL)
+    Q_PROPERTY(qreal maximumSignal READ maximumSignal WRITE setMaximumSignal NOTIFY maximumSignalChanged FINAL)
+    Q_PROPERTY(qint64 timelineStart READ timelineStart NOTIFY timelineChanged FINAL)
+    Q_PROPERTY(qint64 timelineEnd READ timelineEnd NOTIFY timelineChanged FINAL)
+    Q_PROPERTY(bool replaying READ replaying NOTIFY replayingChanged FINAL)
+    Q_PROPERTY(qint64 replayPosition READ replayPosition NOTIFY replayPositionChanged FINAL)
+    Q_PROPERTY(qreal replaySpeed READ replaySpeed WRITE setReplaySpeed NOTIFY replaySpeedChanged FINAL)
+    Q_PROPERTY(QVariantMap viewportStats READ viewportStats NOTIFY viewportStatsChanged FINAL)
+    Q_PROPERTY(PipelineMetrics *metrics READ metrics CONSTANT FINAL)
+    Q_PROPERTY(bool tracing READ tracing WRITE setTracing NOTIFY tracingChanged FINAL)
+    Q_PROPERTY(QVariantList importProgress READ importProgress NOTIFY importProgressChanged FINAL)
+    Q_PROPERTY(bool importing READ importing NOTIFY importingChanged FINAL)
+    Q_PROPERTY(QStringList attachedDatabases READ attachedDatabases NOTIFY attachedDatabasesChanged FINAL)
 };
 
 Q_DECLARE_METATYPE(LocationModel)
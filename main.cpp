@@ -3,12 +3,16 @@
 
 #include "iconmodel.h"
 #include "locationmodel.h"
+#include "pointlayer.h"
+#include "heatmaplayer.h"
+#include "headlessrunner.h"
 #include <QGuiApplication>
 #include <QQuickView>
 #include <QQmlContext>
 #include <QQmlEngine>
 #include <QQuickStyle>
-QGuiApplication *appRef = nullptr;
+#include <QTimer>
+QCoreApplication *appRef = nullptr;
 LocationModel *model;
 
 #ifdef Q_OS_LINUX
@@ -48,6 +52,25 @@ int main(int argc, char **argv)
     SetConsoleCtrlHandler((PHANDLER_ROUTINE)WinHandler, TRUE);
 #endif
 
+    //batch jobs never touch the GUI, QML or the map plugins
+    if(HeadlessRunner::requested(argc, argv))
+    {
+        QCoreApplication app(argc, argv);
+        app.setOrganizationName("digitalartifex.com");
+        app.setApplicationName("wdrvr");
+        appRef = &app;
+
+        LocationModel model;
+        HeadlessRunner runner(&model);
+
+        if(!runner.parse(app.arguments()))
+            return 1;
+
+        QTimer::singleShot(0, &runner, &HeadlessRunner::start);
+
+        return app.exec();
+    }
+
     QApplication app(argc,argv);
     app.setOrganizationName("DigitalArtifex");
     app.setOrganizationName("digitalartifex.com");
@@ -63,6 +86,9 @@ int main(int argc, char **argv)
     app.setWindowIcon(QIcon::fromTheme("wdrvr"));
     view.setIcon(QIcon::fromTheme("wdrvr"));
 
+    qmlRegisterType<PointLayer>("wdrvr", 1, 0, "PointLayer");
+    qmlRegisterType<HeatmapLayer>("wdrvr", 1, 0, "HeatmapLayer");
+
     view.engine()->rootContext()->setContextProperty("locationModel", &model);
     view.engine()->rootContext()->setContextProperty("Icon", &iconModel);
     view.setSource(QUrl(QStringLiteral("qrc:///Main.qml")));
@@ -0,0 +1,151 @@
+#include "mapprojection.h"
+
+#include <QQuickItem>
+#include <QMetaProperty>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr qreal MaximumMercatorLatitude = 85.05112878;
+
+qreal MapProjection::mercatorX(qreal longitude)
+{
+    return (longitude + 180) / 360;
+}
+
+qreal MapProjection::mercatorY(qreal latitude)
+{
+    latitude = std::clamp(latitude, -MaximumMercatorLatitude, MaximumMercatorLatitude);
+    return 0.5 - std::log(std::tan((M_PI / 4) + qDegreesToRadians(latitude) / 2)) / (2 * M_PI);
+}
+
+QGeoCoordinate MapProjection::toCoordinate(qreal x, qreal y)
+{
+    qreal latitude = qRadiansToDegrees(std::atan(std::sinh(M_PI * (1 - 2 * y))));
+    return QGeoCoordinate(latitude, (x * 360) - 180);
+}
+
+QList<QMetaObject::Connection> MapProjection::connectCamera(QQuickItem *map, QObject *receiver, const char *slot)
+{
+    QList<QMetaObject::Connection> connections;
+
+    //the map type is private, so follow its camera through the notify signals
+    const QMetaObject *mapObject = map->metaObject();
+    QMetaMethod method = receiver->metaObject()->method(receiver->metaObject()->indexOfSlot(slot));
+
+    for(const char *name : { "center", "zoomLevel", "bearing", "tilt", "fieldOfView", "width", "height" })
+    {
+        int index = mapObject->indexOfProperty(name);
+
+        if(index >= 0 && mapObject->property(index).hasNotifySignal())
+            connections += QObject::connect(map, mapObject->property(index).notifySignal(), receiver, method);
+    }
+
+    return connections;
+}
+
+void MapProjection::calibrate(QQuickItem *map, QQuickItem *item)
+{
+    QGeoCoordinate center = map ? map->property("center").value<QGeoCoordinate>() : QGeoCoordinate();
+    qreal zoomLevel = map ? map->property("zoomLevel").toReal() : 0;
+
+    if(!center.isValid())
+    {
+        m_centerX = 0.5;
+        m_centerY = 0.5;
+        m_origin = QPointF(item->width() / 2, item->height() / 2);
+        m_axisX = QPointF(TileSize, 0);
+        m_axisY = QPointF(0, TileSize);
+        return;
+    }
+
+    m_centerX = mercatorX(center.longitude());
+    m_centerY = mercatorY(center.latitude());
+
+    //probe a point roughly 100px east of the center to pick up scale, tile size and bearing
+    qreal probeDistance = 100 / (TileSize * std::pow(2, zoomLevel));
+
+    if(m_centerX + probeDistance > 1)
+        probeDistance = -probeDistance;
+
+    QPointF origin;
+    QPointF probe;
+
+    bool mapped = QMetaObject::invokeMethod(map, "fromCoordinate", Q_RETURN_ARG(QPointF, origin), Q_ARG(QGeoCoordinate, center), Q_ARG(bool, false));
+    mapped = mapped && QMetaObject::invokeMethod(map, "fromCoordinate", Q_RETURN_ARG(QPointF, probe), Q_ARG(QGeoCoordinate, toCoordinate(m_centerX + probeDistance, m_centerY)), Q_ARG(bool, false));
+
+    if(!mapped || qIsNaN(origin.x()) || qIsNaN(probe.x()))
+    {
+        //fall back to plain 256px tiles without rotation
+        qreal scale = TileSize * std::pow(2, zoomLevel);
+
+        m_origin = item->mapFromItem(map, QPointF(map->width() / 2, map->height() / 2));
+        m_axisX = QPointF(scale, 0);
+        m_axisY = QPointF(0, scale);
+        return;
+    }
+
+    origin = item->mapFromItem(map, origin);
+    probe = item->mapFromItem(map, probe);
+
+    m_origin = origin;
+    m_axisX = (probe - origin) / probeDistance;
+
+    //mercator y grows southwards like item y, so the y axis is the x axis turned a quarter clockwise
+    m_axisY = QPointF(-m_axisX.y(), m_axisX.x());
+}
+
+QPointF MapProjection::toItem(qreal x, qreal y) const
+{
+    qreal dx = x - m_centerX;
+
+    if(dx > 0.5)
+        dx -= 1;
+    else if(dx < -0.5)
+        dx += 1;
+
+    return m_origin + (m_axisX * dx) + (m_axisY * (y - m_centerY));
+}
+
+QPointF MapProjection::toMercator(const QPointF &position) const
+{
+    //the axes are orthogonal and the same length, so the inverse is the transpose over the squared scale
+    QPointF offset = position - m_origin;
+    qreal scaleSquared = QPointF::dotProduct(m_axisX, m_axisX);
+
+    if(scaleSquared <= 0)
+        return QPointF(m_centerX, m_centerY);
+
+    return QPointF(m_centerX + QPointF::dotProduct(offset, m_axisX) / scaleSquared, m_centerY + QPointF::dotProduct(offset, m_axisY) / scaleSquared);
+}
+
+qreal MapProjection::scale() const
+{
+    return std::hypot(m_axisX.x(), m_axisX.y());
+}
+
+qreal MapProjection::centerX() const
+{
+    return m_centerX;
+}
+
+qreal MapProjection::centerY() const
+{
+    return m_centerY;
+}
+
+QPointF MapProjection::origin() const
+{
+    return m_origin;
+}
+
+QPointF MapProjection::axisX() const
+{
+    return m_axisX;
+}
+
+QPointF MapProjection::axisY() const
+{
+    return m_axisY;
+}
@@ -0,0 +1,56 @@
+#ifndef MAPPROJECTION_H
+#define MAPPROJECTION_H
+
+#include <QPointF>
+#include <QList>
+#include <QObject>
+#include <QGeoCoordinate>
+
+class QQuickItem;
+
+/*
+ * Web mercator projection of a map item
+ *
+ * Positions are normalized mercator, (0, 0) at the north west corner of the world and (1, 1) at
+ * the south east one. calibrate() reads the camera of a map item and maps it into the coordinates
+ * of an overlay item, so overlays can project everything themselves instead of calling into the
+ * map once per point. Tilted maps are not affine and will drift off.
+ */
+class MapProjection
+{
+public:
+    static constexpr qreal TileSize = 256;
+
+    static qreal mercatorX(qreal longitude);
+    static qreal mercatorY(qreal latitude);
+    static QGeoCoordinate toCoordinate(qreal x, qreal y);
+
+    //calls the receiver's slot whenever the camera or the size of the map changes
+    static QList<QMetaObject::Connection> connectCamera(QQuickItem *map, QObject *receiver, const char *slot);
+
+    //must be called on the gui thread
+    void calibrate(QQuickItem *map, QQuickItem *item);
+
+    //takes the short way around the antimeridian
+    QPointF toItem(qreal x, qreal y) const;
+    QPointF toMercator(const QPointF &position) const;
+
+    //pixels per mercator unit
+    qreal scale() const;
+
+    qreal centerX() const;
+    qreal centerY() const;
+    QPointF origin() const;
+    QPointF axisX() const;
+    QPointF axisY() const;
+
+private:
+    //item position of mercator (x, y) is m_origin + m_axisX * dx + m_axisY * dy
+    qreal m_centerX = 0.5;
+    qreal m_centerY = 0.5;
+    QPointF m_origin;
+    QPointF m_axisX = QPointF(TileSize, 0);
+    QPointF m_axisY = QPointF(0, TileSize);
+};
+
+#endif // MAPPROJECTION_H
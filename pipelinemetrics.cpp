@@ -0,0 +1,231 @@
+#include "pipelinemetrics.h"
+
+#include <algorithm>
+
+PipelineMetrics::PipelineMetrics(QObject *parent)
+    : QObject{parent}
+{
+    m_timer = new QTimer(this);
+    m_timer->setInterval(PublishInterval);
+
+    connect(m_timer, &QTimer::timeout, this, &PipelineMetrics::publish);
+}
+
+void PipelineMetrics::begin(qint64 expectedBytes, quint64 expectedRows)
+{
+    {
+        //counters and rate state restart together, so a publish never sees one without the other
+        QMutexLocker locker(&m_rateMutex);
+
+        m_expectedBytes.storeRelaxed(expectedBytes);
+        m_expectedRows.storeRelaxed(expectedRows);
+        m_position.storeRelaxed(0);
+        m_rowCount.storeRelaxed(0);
+        m_duplicates.storeRelaxed(0);
+
+        m_clock.restart();
+        m_lastTime = 0;
+        m_lastRows = 0;
+        m_lastPosition = 0;
+        m_restarted = true;
+    }
+
+    m_operations.fetchAndAddRelease(1);
+
+    //the timer belongs to the model's thread
+    QMetaObject::invokeMethod(this, [this]() {
+        m_timer->start();
+        publish();
+    }, Qt::QueuedConnection);
+}
+
+void PipelineMetrics::end()
+{
+    m_operations.fetchAndSubRelease(1);
+
+    QMetaObject::invokeMethod(this, [this]() {
+        //another operation may have begun in the meantime
+        if(!m_operations.loadAcquire())
+            m_timer->stop();
+
+        publish();
+    }, Qt::QueuedConnection);
+}
+
+void PipelineMetrics::setPosition(qint64 position)
+{
+    m_position.storeRelaxed(position);
+}
+
+void PipelineMetrics::addPosition(qint64 bytes)
+{
+    m_position.fetchAndAddRelaxed(bytes);
+}
+
+void PipelineMetrics::addRow(bool duplicate)
+{
+    m_rowCount.fetchAndAddRelaxed(1);
+
+    if(duplicate)
+        m_duplicates.fetchAndAddRelaxed(1);
+}
+
+void PipelineMetrics::addRows(quint64 rows)
+{
+    m_rowCount.fetchAndAddRelaxed(rows);
+}
+
+void PipelineMetrics::addWrites(qint64 writes)
+{
+    m_pendingWrites.fetchAndAddRelaxed(writes);
+}
+
+void PipelineMetrics::addResident(qint64 pois, qint64 bytes)
+{
+    m_resident.fetchAndAddRelaxed(pois);
+    m_heapBytes.fetchAndAddRelaxed(bytes);
+}
+
+void PipelineMetrics::resetResident()
+{
+    m_resident.storeRelaxed(0);
+    m_heapBytes.storeRelaxed(0);
+}
+
+void PipelineMetrics::setQueryLatency(qint64 latency)
+{
+    m_latency.storeRelaxed(latency);
+
+    //queries run outside operations, publish them on their own
+    refresh();
+}
+
+void PipelineMetrics::refresh()
+{
+    if(!m_operations.loadAcquire())
+        QMetaObject::invokeMethod(this, &PipelineMetrics::publish, Qt::QueuedConnection);
+}
+
+qreal PipelineMetrics::completion() const
+{
+    if(!m_operations.loadAcquire())
+        return -1;
+
+    qint64 expectedBytes = m_expectedBytes.loadRelaxed();
+    quint64 expectedRows = m_expectedRows.loadRelaxed();
+
+    if(expectedBytes > 0)
+        return std::clamp(static_cast<qreal>(m_position.loadRelaxed()) / expectedBytes, 0.0, 1.0);
+
+    if(expectedRows > 0)
+        return std::clamp(static_cast<qreal>(m_rowCount.loadRelaxed()) / expectedRows, 0.0, 1.0);
+
+    return -1;
+}
+
+void PipelineMetrics::publish()
+{
+    bool running = m_operations.loadAcquire() > 0;
+
+    QMutexLocker locker(&m_rateMutex);
+
+    quint64 rows = m_rowCount.loadRelaxed();
+    qint64 position = m_position.loadRelaxed();
+    qint64 now = m_clock.isValid() ? m_clock.elapsed() : 0;
+
+    if(m_restarted)
+    {
+        m_rowsPerSecond = 0;
+        m_bytesPerSecond = 0;
+        m_restarted = false;
+    }
+
+    //rates only move while something runs, the last ones stay up once it finished
+    if(running && now > m_lastTime)
+    {
+        qreal seconds = (now - m_lastTime) / 1000.0;
+        qreal rowRate = std::max<qint64>(static_cast<qint64>(rows) - static_cast<qint64>(m_lastRows), 0) / seconds;
+        qreal byteRate = std::max<qint64>(position - m_lastPosition, 0) / seconds;
+
+        bool first = m_lastTime == 0;
+
+        m_rowsPerSecond = first ? rowRate : (rowRate * RateSmoothing) + (m_rowsPerSecond * (1 - RateSmoothing));
+        m_bytesPerSecond = first ? byteRate : (byteRate * RateSmoothing) + (m_bytesPerSecond * (1 - RateSmoothing));
+
+        m_lastTime = now;
+        m_lastRows = rows;
+        m_lastPosition = position;
+    }
+
+    locker.unlock();
+
+    qint64 expectedBytes = m_expectedBytes.loadRelaxed();
+    quint64 expectedRows = m_expectedRows.loadRelaxed();
+
+    m_eta = -1;
+
+    if(running && expectedBytes > 0 && m_bytesPerSecond > 0)
+        m_eta = std::max<qint64>(expectedBytes - position, 0) / m_bytesPerSecond;
+    else if(running && expectedRows > 0 && m_rowsPerSecond > 0)
+        m_eta = (expectedRows > rows ? expectedRows - rows : 0) / m_rowsPerSecond;
+
+    m_active = running;
+    m_rows = rows;
+    m_duplicateRate = rows ? static_cast<qreal>(m_duplicates.loadRelaxed()) / rows : 0;
+    m_writerQueue = std::max<qint64>(m_pendingWrites.loadRelaxed(), 0);
+    m_residentPois = std::max<qint64>(m_resident.loadRelaxed(), 0);
+    m_residentBytes = std::max<qint64>(m_heapBytes.loadRelaxed(), 0);
+    m_queryLatency = m_latency.loadRelaxed();
+
+    emit updated();
+}
+
+bool PipelineMetrics::active() const
+{
+    return m_active;
+}
+
+quint64 PipelineMetrics::rows() const
+{
+    return m_rows;
+}
+
+qreal PipelineMetrics::rowsPerSecond() const
+{
+    return m_rowsPerSecond;
+}
+
+qreal PipelineMetrics::bytesPerSecond() const
+{
+    return m_bytesPerSecond;
+}
+
+qreal PipelineMetrics::duplicateRate() const
+{
+    return m_duplicateRate;
+}
+
+qint64 PipelineMetrics::writerQueue() const
+{
+    return m_writerQueue;
+}
+
+qreal PipelineMetrics::eta() const
+{
+    return m_eta;
+}
+
+quint64 PipelineMetrics::residentPois() const
+{
+    return m_residentPois;
+}
+
+qint64 PipelineMetrics::residentBytes() const
+{
+    return m_residentBytes;
+}
+
+qint64 PipelineMetrics::queryLatency() const
+{
+    return m_queryLatency;
+}
@@ -0,0 +1,113 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+
+/*
+ * Live pipeline counters
+ *
+ * Workers bump plain atomics, nothing on the hot path takes a lock or emits a signal. While an
+ * operation runs the counters are turned into rates every PublishInterval on the owning thread and
+ * published through the properties, which all notify with updated().
+ *
+ * An operation is an import, load or save between begin() and end(). Its progress is the position
+ * over the expected bytes when the size is known up front, otherwise the rows over the expected rows.
+ * The resident and query counters span operations. Operations may overlap, they share the counters
+ * and the newest begin() restarts them, the metrics stay active until the last one ended.
+ */
+class PipelineMetrics : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int PublishInterval = 250; //ms
+    static constexpr qreal RateSmoothing = 0.3; //weight of the newest interval in the rates
+
+    explicit PipelineMetrics(QObject *parent = nullptr);
+
+    //thread safe, for the workers
+    void begin(qint64 expectedBytes, quint64 expectedRows = 0);
+    void end();
+    void setPosition(qint64 position);
+    void addPosition(qint64 bytes); //for operations reading several files at once
+    void addRow(bool duplicate = false);
+    void addRows(quint64 rows); //a whole batch at once
+    void addWrites(qint64 writes); //pending database writes, negative once written
+    void addResident(qint64 pois, qint64 bytes); //bytes as accounted by the sectors
+    void resetResident();
+    void setQueryLatency(qint64 latency);
+
+    //publishes right away unless an operation is running and the timer does it anyway
+    void refresh();
+
+    //fraction of the running operation, -1 if there is nothing to measure it against
+    qreal completion() const;
+
+    bool active() const;
+    quint64 rows() const;
+    qreal rowsPerSecond() const;
+    qreal bytesPerSecond() const;
+    qreal duplicateRate() const;
+    qint64 writerQueue() const;
+    qreal eta() const;
+    quint64 residentPois() const;
+    qint64 residentBytes() const;
+    qint64 queryLatency() const;
+
+signals:
+    void updated();
+
+private slots:
+    void publish();
+
+private:
+    QTimer *m_timer = nullptr;
+
+    //written by the workers
+    QAtomicInt m_operations = 0; //running operations
+    QAtomicInteger<qint64> m_expectedBytes = 0;
+    QAtomicInteger<quint64> m_expectedRows = 0;
+    QAtomicInteger<qint64> m_position = 0;
+    QAtomicInteger<quint64> m_rowCount = 0;
+    QAtomicInteger<quint64> m_duplicates = 0;
+    QAtomicInteger<qint64> m_pendingWrites = 0;
+    QAtomicInteger<qint64> m_resident = 0;
+    QAtomicInteger<qint64> m_heapBytes = 0;
+    QAtomicInteger<qint64> m_latency = -1;
+
+    //rate state, begin() restarts it from the workers
+    QMutex m_rateMutex;
+    QElapsedTimer m_clock;
+    qint64 m_lastTime = 0;
+    quint64 m_lastRows = 0;
+    qint64 m_lastPosition = 0;
+    bool m_restarted = false;
+
+    //published
+    bool m_active = false;
+    quint64 m_rows = 0;
+    qreal m_rowsPerSecond = 0;
+    qreal m_bytesPerSecond = 0;
+    qreal m_duplicateRate = 0;
+    qint64 m_writerQueue = 0;
+    qreal m_eta = -1;
+    quint64 m_residentPois = 0;
+    qint64 m_residentBytes = 0;
+    qint64 m_queryLatency = -1;
+
+    Q_PROPERTY(bool active READ active NOTIFY updated FINAL)
+    Q_PROPERTY(quint64 rows READ rows NOTIFY updated FINAL)
+    Q_PROPERTY(qreal rowsPerSecond READ rowsPerSecond NOTIFY updated FINAL)
+    Q_PROPERTY(qreal bytesPerSecond READ bytesPerSecond NOTIFY updated FINAL)
+    Q_PROPERTY(qreal duplicateRate READ duplicateRate NOTIFY updated FINAL)
+    Q_PROPERTY(qint64 writerQueue READ writerQueue NOTIFY updated FINAL)
+    Q_PROPERTY(qreal eta READ eta NOTIFY updated FINAL)
+    Q_PROPERTY(quint64 residentPois READ residentPois NOTIFY updated FINAL)
+    Q_PROPERTY(qint64 residentBytes READ residentBytes NOTIFY updated FINAL)
+    Q_PROPERTY(qint64 queryLatency READ queryLatency NOTIFY updated FINAL)
+};
+
+#endif // PIPELINEMETRICS_H
@@ -0,0 +1,430 @@
+#include "pointlayer.h"
+
+#include <QQuickWindow>
+#include <QSGGeometryNode>
+#include <QSGImageNode>
+#include <QSGRendererInterface>
+#include <QSGVertexColorMaterial>
+#include <QPainter>
+#include <QtMath>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+static quint64 hitCell(qreal x, qreal y, qreal cellSize)
+{
+    qint32 column = static_cast<qint32>(std::floor(x / cellSize));
+    qint32 row = static_cast<qint32>(std::floor(y / cellSize));
+
+    return (static_cast<quint64>(static_cast<quint32>(column)) << 32) | static_cast<quint32>(row);
+}
+
+PointLayer::PointLayer(QQuickItem *parent)
+    : QQuickItem{parent}
+{
+    setFlag(ItemHasContents);
+    setAcceptHoverEvents(true);
+}
+
+QAbstractItemModel *PointLayer::model() const
+{
+    return m_model;
+}
+
+void PointLayer::setModel(QAbstractItemModel *model)
+{
+    if (m_model == model)
+        return;
+
+    for(const QMetaObject::Connection &connection : std::as_const(m_modelConnections))
+        disconnect(connection);
+
+    m_modelConnections.clear();
+    m_model = model;
+
+    m_locationRole = -1;
+    m_colorRole = -1;
+    m_sizeRole = -1;
+
+    if(m_model)
+    {
+        const QHash<int, QByteArray> roles = m_model->roleNames();
+
+        m_locationRole = roles.key("location", -1);
+        m_colorRole = roles.key("dotColor", -1);
+        m_sizeRole = roles.key("dotSize", -1);
+
+        m_modelConnections += connect(m_model, &QAbstractItemModel::modelReset, this, &PointLayer::invalidatePoints);
+        m_modelConnections += connect(m_model, &QAbstractItemModel::layoutChanged, this, &PointLayer::invalidatePoints);
+        m_modelConnections += connect(m_model, &QAbstractItemModel::rowsInserted, this, &PointLayer::insertPoints);
+        m_modelConnections += connect(m_model, &QAbstractItemModel::rowsRemoved, this, &PointLayer::invalidatePoints);
+        m_modelConnections += connect(m_model, &QAbstractItemModel::rowsMoved, this, &PointLayer::invalidatePoints);
+        m_modelConnections += connect(m_model, &QAbstractItemModel::dataChanged, this, &PointLayer::invalidatePoints);
+    }
+
+    invalidatePoints();
+    emit modelChanged();
+}
+
+QQuickItem *PointLayer::map() const
+{
+    return m_map;
+}
+
+void PointLayer::setMap(QQuickItem *map)
+{
+    if (m_map == map)
+        return;
+
+    for(const QMetaObject::Connection &connection : std::as_const(m_mapConnections))
+        disconnect(connection);
+
+    m_mapConnections.clear();
+    m_map = map;
+
+    if(m_map)
+        m_mapConnections = MapProjection::connectCamera(m_map, this, "invalidateProjection()");
+
+    invalidateProjection();
+    emit mapChanged();
+}
+
+int PointLayer::hoveredRow() const
+{
+    return m_hoveredRow;
+}
+
+QString PointLayer::hoveredText() const
+{
+    if(!m_model || m_hoveredRow < 0 || m_hoveredRow >= m_model->rowCount())
+        return QString();
+
+    const QHash<int, QByteArray> roles = m_model->roleNames();
+    QModelIndex index = m_model->index(m_hoveredRow, 0);
+
+    qint64 clusterCount = m_model->data(index, roles.key("clusterCount", -1)).toLongLong();
+    QString description = m_model->data(index, roles.key("description", -1)).toString();
+
+    if(clusterCount > 1)
+        return QString("%1 locations").arg(clusterCount);
+
+    QString name = m_model->data(index, roles.key("name", -1)).toString();
+
+    if(description.isEmpty())
+        return name;
+
+    return QString("%1\n%2").arg(name, description);
+}
+
+QPointF PointLayer::hoveredPosition() const
+{
+    return m_hoveredPosition;
+}
+
+int PointLayer::rowAt(qreal x, qreal y)
+{
+    if(m_hitGridDirty)
+        rebuildHitGrid();
+
+    int cellRadius = qCeil(m_maximumRadius / HitCellSize);
+    quint64 centerCell = hitCell(x, y, HitCellSize);
+    qint32 centerColumn = static_cast<qint32>(centerCell >> 32);
+    qint32 centerRow = static_cast<qint32>(centerCell & 0xffffffff);
+
+    int found = -1;
+
+    for(qint32 column = centerColumn - cellRadius; column <= centerColumn + cellRadius; ++column)
+    {
+        for(qint32 row = centerRow - cellRadius; row <= centerRow + cellRadius; ++row)
+        {
+            quint64 cell = (static_cast<quint64>(static_cast<quint32>(column)) << 32) | static_cast<quint32>(row);
+            auto iterator = m_hitGrid.constFind(cell);
+
+            if(iterator == m_hitGrid.constEnd())
+                continue;
+
+            for(int index : iterator.value())
+            {
+                const ScreenPoint &point = m_screenPoints[index];
+                qreal radius = std::max<qreal>(point.radius, MinimumHitRadius);
+                qreal dx = point.position.x() - x;
+                qreal dy = point.position.y() - y;
+
+                //later points are drawn on top
+                if((dx * dx) + (dy * dy) <= radius * radius && index > found)
+                    found = index;
+            }
+        }
+    }
+
+    return found >= 0 ? m_screenPoints[found].row : -1;
+}
+
+QSGNode *PointLayer::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+
+    if(window()->rendererInterface()->graphicsApi() == QSGRendererInterface::Software)
+        return updateImageNode(static_cast<QSGImageNode*>(oldNode));
+
+    return updateGeometryNode(static_cast<QSGGeometryNode*>(oldNode));
+}
+
+QSGNode *PointLayer::updateGeometryNode(QSGGeometryNode *node)
+{
+    if(!node)
+    {
+        //more than 65k vertices, so the indices have to be 32 bit
+        QSGGeometry *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0, 0, QSGGeometry::UnsignedIntType);
+        geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+        geometry->setVertexDataPattern(QSGGeometry::StreamPattern);
+
+        node = new QSGGeometryNode;
+        node->setGeometry(geometry);
+        node->setFlag(QSGNode::OwnsGeometry);
+        node->setMaterial(new QSGVertexColorMaterial);
+        node->setFlag(QSGNode::OwnsMaterial);
+
+        m_allocatedPoints = -1;
+    }
+
+    QSGGeometry *geometry = node->geometry();
+    int count = m_screenPoints.count();
+
+    //every point is a fan of PointSides - 2 triangles, the indices only change with the count
+    if(count != m_allocatedPoints)
+    {
+        geometry->allocate(count * PointSides, count * (PointSides - 2) * 3);
+
+        quint32 *indices = geometry->indexDataAsUInt();
+
+        for(int point = 0; point < count; ++point)
+        {
+            quint32 base = static_cast<quint32>(point) * PointSides;
+
+            for(int side = 1; side < PointSides - 1; ++side)
+            {
+                *indices++ = base;
+                *indices++ = base + side;
+                *indices++ = base + side + 1;
+            }
+        }
+
+        m_allocatedPoints = count;
+    }
+
+    static const auto corners = []() {
+        std::array<QPointF, PointSides> corners;
+
+        for(int side = 0; side < PointSides; ++side)
+            corners[side] = QPointF(std::cos(2 * M_PI * side / PointSides), std::sin(2 * M_PI * side / PointSides));
+
+        return corners;
+    }();
+
+    QSGGeometry::ColoredPoint2D *vertices = geometry->vertexDataAsColoredPoint2D();
+
+    for(const ScreenPoint &point : std::as_const(m_screenPoints))
+    {
+        uchar red = qRed(point.color);
+        uchar green = qGreen(point.color);
+        uchar blue = qBlue(point.color);
+        uchar alpha = qAlpha(point.color);
+
+        for(const QPointF &corner : corners)
+        {
+            vertices->set(point.position.x() + corner.x() * point.radius, point.position.y() + corner.y() * point.radius, red, green, blue, alpha);
+            ++vertices;
+        }
+    }
+
+    node->markDirty(QSGNode::DirtyGeometry);
+
+    return node;
+}
+
+QSGNode *PointLayer::updateImageNode(QSGImageNode *node)
+{
+    if(!node)
+    {
+        node = window()->createImageNode();
+        node->setOwnsTexture(true);
+    }
+
+    qreal ratio = window()->effectiveDevicePixelRatio();
+    QImage image(std::max(1, qCeil(width() * ratio)), std::max(1, qCeil(height() * ratio)), QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(ratio);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+
+    for(const ScreenPoint &point : std::as_const(m_screenPoints))
+    {
+        painter.setBrush(QColor::fromRgba(qUnpremultiply(point.color)));
+        painter.drawEllipse(point.position, point.radius, point.radius);
+    }
+
+    painter.end();
+
+    node->setTexture(window()->createTextureFromImage(image));
+    node->setRect(boundingRect());
+
+    return node;
+}
+
+void PointLayer::updatePolish()
+{
+    if(m_pointsDirty)
+    {
+        rebuildPoints();
+        m_pointsDirty = false;
+    }
+    else if(m_loadedRows < m_knownRows)
+        appendPoints();
+
+    m_projection.calibrate(m_map, this);
+    project();
+
+    m_hitGridDirty = true;
+    update();
+}
+
+void PointLayer::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    invalidateProjection();
+}
+
+void PointLayer::hoverMoveEvent(QHoverEvent *event)
+{
+    QPointF position = event->position();
+    setHoveredRow(rowAt(position.x(), position.y()), position);
+}
+
+void PointLayer::hoverLeaveEvent(QHoverEvent *event)
+{
+    setHoveredRow(-1, event->position());
+}
+
+void PointLayer::invalidatePoints()
+{
+    m_pointsDirty = true;
+    polish();
+}
+
+void PointLayer::invalidateProjection()
+{
+    polish();
+}
+
+//rows added behind the ones already read don't need a rebuild, replays add a few every frame
+void PointLayer::insertPoints(const QModelIndex &parent, int first, int last)
+{
+    if(parent.isValid() || m_pointsDirty || first != m_knownRows)
+    {
+        invalidatePoints();
+        return;
+    }
+
+    m_knownRows = last + 1;
+    polish();
+}
+
+void PointLayer::rebuildPoints()
+{
+    m_points.clear();
+    m_maximumRadius = 0;
+    m_loadedRows = 0;
+    m_knownRows = 0;
+
+    //the rows the hover pointed at are gone
+    setHoveredRow(-1, m_hoveredPosition);
+
+    if(!m_model || m_locationRole < 0)
+        return;
+
+    m_points.reserve(m_model->rowCount());
+    appendPoints();
+}
+
+//reads the rows behind m_loadedRows
+void PointLayer::appendPoints()
+{
+    if(!m_model || m_locationRole < 0)
+        return;
+
+    int rows = m_model->rowCount();
+
+    QModelRoleData roleData[3] = { QModelRoleData(m_locationRole), QModelRoleData(m_colorRole), QModelRoleData(m_sizeRole) };
+
+    for(int row = m_loadedRows; row < rows; ++row)
+    {
+        m_model->multiData(m_model->index(row, 0), roleData);
+
+        QGeoCoordinate coordinate = roleData[0].data().value<QGeoCoordinate>();
+
+        if(!coordinate.isValid())
+            continue;
+
+        QColor color = roleData[1].data().value<QColor>();
+        qreal size = roleData[2].data().toReal();
+
+        Point point;
+        point.x = MapProjection::mercatorX(coordinate.longitude());
+        point.y = MapProjection::mercatorY(coordinate.latitude());
+        point.color = qPremultiply(color.isValid() ? color.rgba() : qRgba(0, 0, 128, 200));
+        point.radius = static_cast<float>((size > 0 ? size : 20) / 2);
+        point.row = row;
+
+        m_maximumRadius = std::max<qreal>(m_maximumRadius, point.radius);
+        m_points.append(point);
+    }
+
+    m_loadedRows = rows;
+    m_knownRows = rows;
+}
+
+void PointLayer::project()
+{
+    m_screenPoints.clear();
+    m_screenPoints.reserve(m_points.count());
+
+    QRectF bounds = boundingRect();
+
+    for(const Point &point : std::as_const(m_points))
+    {
+        QPointF position = m_projection.toItem(point.x, point.y);
+
+        if(!bounds.adjusted(-point.radius, -point.radius, point.radius, point.radius).contains(position))
+            continue;
+
+        m_screenPoints.append({ position, point.color, point.radius, point.row });
+    }
+}
+
+void PointLayer::rebuildHitGrid()
+{
+    m_hitGrid.clear();
+
+    for(int index = 0; index < m_screenPoints.count(); ++index)
+    {
+        const QPointF &position = m_screenPoints[index].position;
+        m_hitGrid[hitCell(position.x(), position.y(), HitCellSize)].append(index);
+    }
+
+    m_hitGridDirty = false;
+}
+
+void PointLayer::setHoveredRow(int row, const QPointF &position)
+{
+    m_hoveredPosition = position;
+
+    if(m_hoveredRow == row)
+        return;
+
+    m_hoveredRow = row;
+    emit hoveredRowChanged();
+}
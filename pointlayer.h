@@ -0,0 +1,131 @@
+#ifndef POINTLAYER_H
+#define POINTLAYER_H
+
+#include <QObject>
+#include <QQuickItem>
+#include <QAbstractItemModel>
+#include <QPointer>
+#include <QHash>
+#include <QVector>
+#include <QColor>
+#include <QGeoCoordinate>
+
+#include "mapprojection.h"
+
+class QSGGeometryNode;
+class QSGImageNode;
+
+/*
+ * Batched point layer
+ *
+ * Draws every row of a model with location, dotColor and dotSize roles as one geometry node instead
+ * of a delegate per row. The projection is calibrated against the map item the layer sits on, so it
+ * follows panning, zooming and rotation without asking the map for every point.
+ *
+ * The software scene graph can't draw custom geometry, so there the points are rasterized into an
+ * image node instead.
+ */
+class PointLayer : public QQuickItem
+{
+    Q_OBJECT
+public:
+    explicit PointLayer(QQuickItem *parent = nullptr);
+
+    QAbstractItemModel *model() const;
+    void setModel(QAbstractItemModel *model);
+
+    QQuickItem *map() const;
+    void setMap(QQuickItem *map);
+
+    int hoveredRow() const;
+    QString hoveredText() const;
+    QPointF hoveredPosition() const;
+
+    //topmost row drawn under the position, -1 if there is none
+    Q_INVOKABLE int rowAt(qreal x, qreal y);
+
+signals:
+    void modelChanged();
+    void mapChanged();
+    void hoveredRowChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void updatePolish() override;
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+    void hoverMoveEvent(QHoverEvent *event) override;
+    void hoverLeaveEvent(QHoverEvent *event) override;
+
+private slots:
+    void invalidatePoints();
+    void invalidateProjection();
+    void insertPoints(const QModelIndex &parent, int first, int last);
+
+private:
+    static constexpr int PointSides = 8;
+    static constexpr qreal HitCellSize = 32; //px
+    static constexpr qreal MinimumHitRadius = 4; //px
+
+    //position in normalized web mercator
+    struct Point
+    {
+        qreal x = 0;
+        qreal y = 0;
+        QRgb color = 0; //premultiplied
+        float radius = 0;
+        int row = -1;
+    };
+
+    struct ScreenPoint
+    {
+        QPointF position;
+        QRgb color = 0; //premultiplied
+        float radius = 0;
+        int row = -1;
+    };
+
+    void rebuildPoints();
+    void appendPoints();
+    void project();
+    void rebuildHitGrid();
+    void setHoveredRow(int row, const QPointF &position);
+
+    QSGNode *updateGeometryNode(QSGGeometryNode *node);
+    QSGNode *updateImageNode(QSGImageNode *node);
+
+    QPointer<QAbstractItemModel> m_model;
+    QPointer<QQuickItem> m_map;
+    QList<QMetaObject::Connection> m_modelConnections;
+    QList<QMetaObject::Connection> m_mapConnections;
+
+    int m_locationRole = -1;
+    int m_colorRole = -1;
+    int m_sizeRole = -1;
+
+    //model rows, rebuilt on the gui thread when the model changes
+    QVector<Point> m_points;
+    bool m_pointsDirty = true;
+    int m_loadedRows = 0; //rows read into m_points
+    int m_knownRows = 0; //rows the model announced, appended ones are read on the next polish
+
+    MapProjection m_projection;
+
+    //visible points in item coordinates, read by the render thread while the gui thread is blocked
+    QVector<ScreenPoint> m_screenPoints;
+    int m_allocatedPoints = -1;
+
+    QHash<quint64, QVector<int>> m_hitGrid;
+    bool m_hitGridDirty = true;
+    qreal m_maximumRadius = 0;
+
+    int m_hoveredRow = -1;
+    QPointF m_hoveredPosition;
+
+    Q_PROPERTY(QAbstractItemModel *model READ model WRITE setModel NOTIFY modelChanged FINAL)
+    Q_PROPERTY(QQuickItem *map READ map WRITE setMap NOTIFY mapChanged FINAL)
+    Q_PROPERTY(int hoveredRow READ hoveredRow NOTIFY hoveredRowChanged FINAL)
+    Q_PROPERTY(QString hoveredText READ hoveredText NOTIFY hoveredRowChanged FINAL)
+    Q_PROPERTY(QPointF hoveredPosition READ hoveredPosition NOTIFY hoveredRowChanged FINAL)
+};
+
+#endif // POINTLAYER_H
@@ -0,0 +1,262 @@
+#include "roaringbitmap.h"
+
+#include <algorithm>
+
+void RoaringBitmap::Container::add(quint16 value)
+{
+    if(isBitset())
+    {
+        quint64 bit = quint64(1) << (value % 64);
+
+        if(!(bits[value / 64] & bit))
+        {
+            bits[value / 64] |= bit;
+            ++cardinality;
+        }
+
+        return;
+    }
+
+    if(values.isEmpty() || values.last() < value)
+        values.append(value);
+    else
+    {
+        auto position = std::lower_bound(values.begin(), values.end(), value);
+
+        if(*position == value)
+            return;
+
+        values.insert(position, value);
+    }
+
+    ++cardinality;
+
+    if(cardinality > ArrayLimit)
+        toBitset();
+}
+
+bool RoaringBitmap::Container::contains(quint16 value) const
+{
+    if(isBitset())
+        return bits[value / 64] & (quint64(1) << (value % 64));
+
+    return std::binary_search(values.begin(), values.end(), value);
+}
+
+void RoaringBitmap::Container::toBitset()
+{
+    bits = QVector<quint64>(BitsetWords, 0);
+
+    for(quint16 value : std::as_const(values))
+        bits[value / 64] |= quint64(1) << (value % 64);
+
+    values.clear();
+    values.squeeze();
+}
+
+void RoaringBitmap::Container::toArray()
+{
+    values.clear();
+    values.reserve(cardinality);
+
+    for(int word = 0; word < BitsetWords; ++word)
+    {
+        quint64 remaining = bits[word];
+
+        while(remaining)
+        {
+            values.append(static_cast<quint16>((word * 64) + qCountTrailingZeroBits(remaining)));
+            remaining &= remaining - 1;
+        }
+    }
+
+    bits.clear();
+    bits.squeeze();
+}
+
+RoaringBitmap::Container RoaringBitmap::intersect(const Container &a, const Container &b)
+{
+    Container result;
+
+    if(a.isBitset() && b.isBitset())
+    {
+        result.bits = QVector<quint64>(BitsetWords, 0);
+
+        for(int word = 0; word < BitsetWords; ++word)
+        {
+            result.bits[word] = a.bits[word] & b.bits[word];
+            result.cardinality += qPopulationCount(result.bits[word]);
+        }
+
+        if(result.cardinality <= ArrayLimit)
+            result.toArray();
+    }
+    else if(a.isBitset() || b.isBitset())
+    {
+        const Container &array = a.isBitset() ? b : a;
+        const Container &bitset = a.isBitset() ? a : b;
+
+        for(quint16 value : array.values)
+        {
+            if(bitset.contains(value))
+                result.values.append(value);
+        }
+
+        result.cardinality = result.values.count();
+    }
+    else
+    {
+        std::set_intersection(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), std::back_inserter(result.values));
+        result.cardinality = result.values.count();
+    }
+
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::unite(const Container &a, const Container &b)
+{
+    Container result;
+
+    if(a.isBitset() || b.isBitset())
+    {
+        result.bits = QVector<quint64>(BitsetWords, 0);
+
+        for(const Container *container : { &a, &b })
+        {
+            if(container->isBitset())
+            {
+                for(int word = 0; word < BitsetWords; ++word)
+                    result.bits[word] |= container->bits[word];
+            }
+            else
+            {
+                for(quint16 value : container->values)
+                    result.bits[value / 64] |= quint64(1) << (value % 64);
+            }
+        }
+
+        for(int word = 0; word < BitsetWords; ++word)
+            result.cardinality += qPopulationCount(result.bits[word]);
+    }
+    else
+    {
+        result.values.reserve(a.values.count() + b.values.count());
+        std::set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), std::back_inserter(result.values));
+        result.cardinality = result.values.count();
+
+        if(result.cardinality > ArrayLimit)
+            result.toBitset();
+    }
+
+    return result;
+}
+
+void RoaringBitmap::add(quint32 value)
+{
+    quint16 high = static_cast<quint16>(value >> 16);
+    quint16 low = static_cast<quint16>(value & 0xffff);
+
+    //ascending appends always land in the last container
+    if(m_keys.isEmpty() || m_keys.last() < high)
+    {
+        m_keys.append(high);
+        m_containers.append(Container());
+        m_containers.last().add(low);
+        return;
+    }
+
+    auto position = std::lower_bound(m_keys.begin(), m_keys.end(), high);
+    qsizetype index = position - m_keys.begin();
+
+    if(*position != high)
+    {
+        m_keys.insert(index, high);
+        m_containers.insert(index, Container());
+    }
+
+    m_containers[index].add(low);
+}
+
+bool RoaringBitmap::contains(quint32 value) const
+{
+    quint16 high = static_cast<quint16>(value >> 16);
+    auto position = std::lower_bound(m_keys.begin(), m_keys.end(), high);
+
+    if(position == m_keys.end() || *position != high)
+        return false;
+
+    return m_containers[position - m_keys.begin()].contains(static_cast<quint16>(value & 0xffff));
+}
+
+quint64 RoaringBitmap::cardinality() const
+{
+    quint64 cardinality = 0;
+
+    for(const Container &container : m_containers)
+        cardinality += container.cardinality;
+
+    return cardinality;
+}
+
+bool RoaringBitmap::isEmpty() const
+{
+    return m_keys.isEmpty();
+}
+
+RoaringBitmap RoaringBitmap::operator&(const RoaringBitmap &other) const
+{
+    RoaringBitmap result;
+    qsizetype left = 0;
+    qsizetype right = 0;
+
+    while(left < m_keys.count() && right < other.m_keys.count())
+    {
+        if(m_keys[left] < other.m_keys[right])
+            ++left;
+        else if(m_keys[left] > other.m_keys[right])
+            ++right;
+        else
+        {
+            Container container = intersect(m_containers[left], other.m_containers[right]);
+
+            if(container.cardinality > 0)
+            {
+                result.m_keys.append(m_keys[left]);
+                result.m_containers.append(container);
+            }
+
+            ++left;
+            ++right;
+        }
+    }
+
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::operator|(const RoaringBitmap &other) const
+{
+    RoaringBitmap result;
+    qsizetype left = 0;
+    qsizetype right = 0;
+
+    while(left < m_keys.count() || right < other.m_keys.count())
+    {
+        if(right >= other.m_keys.count() || (left < m_keys.count() && m_keys[left] < other.m_keys[right]))
+        {
+            result.m_keys.append(m_keys[left]);
+            result.m_containers.append(m_containers[left++]);
+        }
+        else if(left >= m_keys.count() || other.m_keys[right] < m_keys[left])
+        {
+            result.m_keys.append(other.m_keys[right]);
+            result.m_containers.append(other.m_containers[right++]);
+        }
+        else
+        {
+            result.m_keys.append(m_keys[left]);
+            result.m_containers.append(unite(m_containers[left++], other.m_containers[right++]));
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,82 @@
+#ifndef ROARINGBITMAP_H
+#define ROARINGBITMAP_H
+
+#include <QVector>
+#include <QtAlgorithms>
+#include <QtGlobal>
+
+/*
+ * Compressed bitmap of 32 bit values
+ *
+ * Values are split by their high 16 bits into containers. Sparse containers are sorted arrays of the
+ * low 16 bits, dense ones (more than ArrayLimit values) are 65536 bit bitsets, the same layout roaring
+ * bitmaps use. Appending values in ascending order is the fast path.
+ */
+class RoaringBitmap
+{
+public:
+    static constexpr int ArrayLimit = 4096;
+
+    void add(quint32 value);
+    bool contains(quint32 value) const;
+    quint64 cardinality() const;
+    bool isEmpty() const;
+
+    RoaringBitmap operator&(const RoaringBitmap &other) const;
+    RoaringBitmap operator|(const RoaringBitmap &other) const;
+
+    //calls function with every value in ascending order
+    template<typename Function>
+    void forEach(Function function) const
+    {
+        for(qsizetype index = 0; index < m_keys.count(); ++index)
+        {
+            quint32 high = static_cast<quint32>(m_keys[index]) << 16;
+            const Container &container = m_containers[index];
+
+            if(container.isBitset())
+            {
+                for(int word = 0; word < BitsetWords; ++word)
+                {
+                    quint64 bits = container.bits[word];
+
+                    while(bits)
+                    {
+                        int bit = qCountTrailingZeroBits(bits);
+                        function(high | static_cast<quint32>((word * 64) + bit));
+                        bits &= bits - 1;
+                    }
+                }
+            }
+            else
+            {
+                for(quint16 low : container.values)
+                    function(high | low);
+            }
+        }
+    }
+
+private:
+    static constexpr int BitsetWords = 65536 / 64;
+
+    struct Container
+    {
+        QVector<quint16> values; //sorted, used while the container is sparse
+        QVector<quint64> bits; //BitsetWords words once it is dense
+        quint32 cardinality = 0;
+
+        bool isBitset() const { return !bits.isEmpty(); }
+        void add(quint16 value);
+        bool contains(quint16 value) const;
+        void toBitset();
+        void toArray();
+    };
+
+    static Container intersect(const Container &a, const Container &b);
+    static Container unite(const Container &a, const Container &b);
+
+    QVector<quint16> m_keys; //sorted high halves
+    QVector<Container> m_containers;
+};
+
+#endif // ROARINGBITMAP_H
@@ -0,0 +1,289 @@
+#include "sectorcodec.h"
+#include "locationmodel.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr quint64 BlockVersion = 1;
+static constexpr quint64 HasAltitude = 0x1;
+static constexpr quint64 HasSource = 0x2;
+
+static void writeVarint(QByteArray &block, quint64 value)
+{
+    while(value >= 0x80)
+    {
+        block.append(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+
+    block.append(static_cast<char>(value));
+}
+
+static bool readVarint(const char *&position, const char *end, quint64 &value)
+{
+    value = 0;
+
+    for(int shift = 0; shift < 64 && position != end; shift += 7)
+    {
+        quint8 byte = static_cast<quint8>(*position++);
+        value |= static_cast<quint64>(byte & 0x7f) << shift;
+
+        if(!(byte & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+static quint64 zigzag(qint64 value)
+{
+    return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+}
+
+static qint64 unzigzag(quint64 value)
+{
+    return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+
+static qint64 quantize(qreal value, qint64 scale)
+{
+    return std::llround(value * scale);
+}
+
+class SectorDictionary
+{
+public:
+    quint64 index(const QString &value)
+    {
+        auto iterator = m_indexes.constFind(value);
+
+        if(iterator != m_indexes.constEnd())
+            return iterator.value();
+
+        quint64 index = m_strings.count();
+        m_indexes.insert(value, index);
+        m_strings.append(value);
+
+        return index;
+    }
+
+    void write(QByteArray &block) const
+    {
+        writeVarint(block, m_strings.count());
+
+        for(const QString &value : m_strings)
+        {
+            QByteArray utf8 = value.toUtf8();
+            writeVarint(block, utf8.size());
+            block.append(utf8);
+        }
+    }
+
+private:
+    QHash<QString, quint64> m_indexes;
+    QList<QString> m_strings;
+};
+
+QByteArray SectorCodec::encode(const LocationDataNode *head)
+{
+    //spatial order keeps the coordinate deltas small
+    QVector<const LocationDataNode*> nodes;
+
+    for(const LocationDataNode *node = head; node; node = node->next)
+        nodes.append(node);
+
+    std::stable_sort(nodes.begin(), nodes.end(), [](const LocationDataNode *a, const LocationDataNode *b) {
+        qint64 latitudeA = quantize(a->data.coordinates.latitude(), CoordinateScale);
+        qint64 latitudeB = quantize(b->data.coordinates.latitude(), CoordinateScale);
+
+        if(latitudeA != latitudeB)
+            return latitudeA < latitudeB;
+
+        return quantize(a->data.coordinates.longitude(), CoordinateScale) < quantize(b->data.coordinates.longitude(), CoordinateScale);
+    });
+
+    SectorDictionary dictionary;
+    QByteArray records;
+
+    qint64 previousLatitude = 0;
+    qint64 previousLongitude = 0;
+    qint64 previousTimestamp = 0;
+
+    for(const LocationDataNode *node : std::as_const(nodes))
+    {
+        const LocationData &data = node->data;
+
+        qint64 latitude = quantize(data.coordinates.latitude(), CoordinateScale);
+        qint64 longitude = quantize(data.coordinates.longitude(), CoordinateScale);
+        bool hasAltitude = !std::isnan(data.coordinates.altitude());
+
+        writeVarint(records, (hasAltitude ? HasAltitude : 0) | (data.source ? HasSource : 0));
+        writeVarint(records, zigzag(latitude - previousLatitude));
+        writeVarint(records, zigzag(longitude - previousLongitude));
+
+        if(hasAltitude)
+            writeVarint(records, zigzag(quantize(data.coordinates.altitude(), 100)));
+
+        if(data.source)
+            writeVarint(records, data.source);
+
+        writeVarint(records, zigzag(data.timestamp - previousTimestamp));
+
+        writeVarint(records, dictionary.index(data.id));
+        writeVarint(records, dictionary.index(data.name));
+        writeVarint(records, dictionary.index(data.description));
+        writeVarint(records, dictionary.index(data.encryption));
+        writeVarint(records, dictionary.index(data.styleTag));
+        writeVarint(records, dictionary.index(data.type));
+        writeVarint(records, dictionary.index(data.mfgid));
+
+        writeVarint(records, zigzag(quantize(data.accuracy, 100)));
+        writeVarint(records, zigzag(quantize(data.signal, 100)));
+        writeVarint(records, zigzag(quantize(data.frequency, 100)));
+        writeVarint(records, zigzag(data.open));
+
+        writeVarint(records, data.capabilities.count());
+        for(const QString &capability : data.capabilities)
+            writeVarint(records, dictionary.index(capability));
+
+        writeVarint(records, data.rois.count());
+        for(const QString &roi : data.rois)
+            writeVarint(records, dictionary.index(roi));
+
+        previousLatitude = latitude;
+        previousLongitude = longitude;
+        previousTimestamp = data.timestamp;
+    }
+
+    QByteArray block;
+    writeVarint(block, BlockVersion);
+    writeVarint(block, nodes.count());
+    dictionary.write(block);
+    block.append(records);
+
+    return qCompress(block, 1);
+}
+
+bool SectorCodec::decode(const QByteArray &packed, LocationDataNode *&head, LocationDataNode *&last, quint64 &count)
+{
+    head = nullptr;
+    last = nullptr;
+    count = 0;
+
+    QByteArray block = qUncompress(packed);
+    const char *position = block.constData();
+    const char *end = position + block.size();
+
+    quint64 version = 0;
+    quint64 records = 0;
+    quint64 strings = 0;
+
+    if(!readVarint(position, end, version) || version != BlockVersion || !readVarint(position, end, records) || !readVarint(position, end, strings))
+        return false;
+
+    //every string takes at least its length byte, a corrupt count must not decide the allocation
+    if(strings > static_cast<quint64>(end - position))
+        return false;
+
+    QList<QString> dictionary;
+    dictionary.reserve(static_cast<qsizetype>(strings));
+
+    for(quint64 i = 0; i < strings; ++i)
+    {
+        quint64 length = 0;
+
+        if(!readVarint(position, end, length) || static_cast<quint64>(end - position) < length)
+            return false;
+
+        dictionary.append(QString::fromUtf8(position, static_cast<qsizetype>(length)));
+        position += length;
+    }
+
+    bool valid = true;
+
+    auto readValue = [&position, end, &valid]() {
+        quint64 value = 0;
+
+        if(!readVarint(position, end, value))
+            valid = false;
+
+        return value;
+    };
+
+    auto readString = [&readValue, &dictionary, &valid]() {
+        quint64 index = readValue();
+
+        if(index >= static_cast<quint64>(dictionary.count()))
+        {
+            valid = false;
+            return QString();
+        }
+
+        return dictionary[index];
+    };
+
+    qint64 latitude = 0;
+    qint64 longitude = 0;
+    qint64 timestamp = 0;
+
+    for(quint64 i = 0; i < records && valid; ++i)
+    {
+        LocationDataNode *node = new LocationDataNode;
+        LocationData &data = node->data;
+
+        quint64 flags = readValue();
+        latitude += unzigzag(readValue());
+        longitude += unzigzag(readValue());
+
+        if(flags & HasAltitude)
+            data.coordinates = QGeoCoordinate(static_cast<qreal>(latitude) / CoordinateScale, static_cast<qreal>(longitude) / CoordinateScale, static_cast<qreal>(unzigzag(readValue())) / 100);
+        else
+            data.coordinates = QGeoCoordinate(static_cast<qreal>(latitude) / CoordinateScale, static_cast<qreal>(longitude) / CoordinateScale);
+
+        if(flags & HasSource)
+            data.source = static_cast<quint8>(readValue());
+
+        timestamp += unzigzag(readValue());
+        data.timestamp = timestamp;
+
+        data.id = readString();
+        data.name = readString();
+        data.description = readString();
+        data.encryption = readString();
+        data.styleTag = readString();
+        data.type = readString();
+        data.mfgid = readString();
+
+        data.accuracy = static_cast<qreal>(unzigzag(readValue())) / 100;
+        data.signal = static_cast<qreal>(unzigzag(readValue())) / 100;
+        data.frequency = static_cast<qreal>(unzigzag(readValue())) / 100;
+        data.open = static_cast<int>(unzigzag(readValue()));
+
+        quint64 capabilities = readValue();
+        for(quint64 capability = 0; capability < capabilities && valid; ++capability)
+            data.capabilities.append(readString());
+
+        quint64 rois = readValue();
+        for(quint64 roi = 0; roi < rois && valid; ++roi)
+            data.rois.append(readString());
+
+        if(!head)
+            head = node;
+        else
+            last->next = node;
+
+        last = node;
+        ++count;
+    }
+
+    if(!valid)
+    {
+        SectorDirectory::deleteNodes(head);
+
+        head = nullptr;
+        last = nullptr;
+        count = 0;
+    }
+
+    return valid;
+}
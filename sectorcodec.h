@@ -0,0 +1,28 @@
+#ifndef SECTORCODEC_H
+#define SECTORCODEC_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+struct LocationDataNode;
+
+/*
+ * Cold sector block format
+ *
+ * Packs the POIs of a sector that has not been touched for a while. Records are written in spatial
+ * order with coordinates quantized to fixed point (1e-7 degrees) and delta encoded, timestamps delta
+ * encoded, and every string replaced by an index into a per block dictionary. Integers are written as
+ * zigzag varints and the whole block is deflated.
+ *
+ * Accuracy, signal and frequency are kept to 1/100 of their unit and altitude to the centimeter.
+ */
+class SectorCodec
+{
+public:
+    static constexpr qint64 CoordinateScale = 10000000;
+
+    static QByteArray encode(const LocationDataNode *head);
+    static bool decode(const QByteArray &block, LocationDataNode *&head, LocationDataNode *&last, quint64 &count);
+};
+
+#endif // SECTORCODEC_H
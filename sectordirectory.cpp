@@ -0,0 +1,172 @@
+#include "sectordirectory.h"
+#include "locationmodel.h"
+#include "sectorindex.h"
+
+#include <algorithm>
+#include <cmath>
+
+SectorDirectory::~SectorDirectory()
+{
+    clear();
+}
+
+int SectorDirectory::column(qreal longitude)
+{
+    return std::clamp(static_cast<int>(std::floor((longitude + 180) / SectorSize)), 0, Columns - 1);
+}
+
+int SectorDirectory::row(qreal latitude)
+{
+    return std::clamp(static_cast<int>(std::floor((latitude + 90) / SectorSize)), 0, Rows - 1);
+}
+
+quint32 SectorDirectory::sectorId(int column, int row)
+{
+    return static_cast<quint32>(column) * Rows + static_cast<quint32>(row);
+}
+
+int SectorDirectory::columnOf(quint32 id)
+{
+    return static_cast<int>(id / Rows);
+}
+
+int SectorDirectory::rowOf(quint32 id)
+{
+    return static_cast<int>(id % Rows);
+}
+
+qreal SectorDirectory::longitudeOf(quint32 id)
+{
+    return (columnOf(id) * SectorSize) - 180;
+}
+
+qreal SectorDirectory::latitudeOf(quint32 id)
+{
+    return (rowOf(id) * SectorSize) - 90;
+}
+
+Sector *SectorDirectory::sector(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return m_sectors.value(id, nullptr);
+}
+
+Sector *SectorDirectory::findOrCreate(qreal latitude, qreal longitude)
+{
+    quint32 id = sectorId(column(longitude), row(latitude));
+
+    {
+        QReadLocker locker(&m_lock);
+        Sector *sector = m_sectors.value(id, nullptr);
+
+        if(sector)
+            return sector;
+    }
+
+    QWriteLocker locker(&m_lock);
+
+    //another writer may have created it in between
+    Sector *&sector = m_sectors[id];
+
+    if(!sector)
+    {
+        sector = new Sector;
+        sector->id = id;
+    }
+
+    return sector;
+}
+
+QList<Sector*> SectorDirectory::sectors() const
+{
+    QList<Sector*> sectors;
+
+    {
+        QReadLocker locker(&m_lock);
+        sectors = m_sectors.values();
+    }
+
+    std::sort(sectors.begin(), sectors.end(), [](const Sector *a, const Sector *b) { return a->id < b->id; });
+
+    return sectors;
+}
+
+QList<Sector*> SectorDirectory::sectorsInRect(int columnStart, int columnEnd, int rowStart, int rowEnd) const
+{
+    columnStart = std::max(columnStart, 0);
+    columnEnd = std::min(columnEnd, Columns - 1);
+    rowStart = std::max(rowStart, 0);
+    rowEnd = std::min(rowEnd, Rows - 1);
+
+    QList<Sector*> sectors;
+
+    if(columnStart > columnEnd || rowStart > rowEnd)
+        return sectors;
+
+    QReadLocker locker(&m_lock);
+
+    qint64 cells = static_cast<qint64>(columnEnd - columnStart + 1) * (rowEnd - rowStart + 1);
+
+    //probe the cells of a small rect, walk the directory for a large one
+    if(cells <= m_sectors.count())
+    {
+        for(int column = columnStart; column <= columnEnd; ++column)
+        {
+            for(int row = rowStart; row <= rowEnd; ++row)
+            {
+                Sector *sector = m_sectors.value(sectorId(column, row), nullptr);
+
+                if(sector)
+                    sectors.append(sector);
+            }
+        }
+    }
+    else
+    {
+        for(Sector *sector : std::as_const(m_sectors))
+        {
+            int column = columnOf(sector->id);
+            int row = rowOf(sector->id);
+
+            if(column >= columnStart && column <= columnEnd && row >= rowStart && row <= rowEnd)
+                sectors.append(sector);
+        }
+
+        std::sort(sectors.begin(), sectors.end(), [](const Sector *a, const Sector *b) { return a->id < b->id; });
+    }
+
+    return sectors;
+}
+
+qsizetype SectorDirectory::count() const
+{
+    QReadLocker locker(&m_lock);
+    return m_sectors.count();
+}
+
+void SectorDirectory::clear()
+{
+    QWriteLocker locker(&m_lock);
+
+    for(Sector *sector : std::as_const(m_sectors))
+    {
+        deleteNodes(sector->head);
+        delete sector->index;
+        delete sector;
+    }
+
+    m_sectors.clear();
+}
+
+void SectorDirectory::deleteNodes(LocationDataNode *head)
+{
+    LocationDataNode *node = head;
+
+    while(node)
+    {
+        LocationDataNode *currentNode = node;
+        node = node->next;
+
+        delete currentNode;
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef SECTORDIRECTORY_H
+#define SECTORDIRECTORY_H
+
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QReadWriteLock>
+
+struct LocationDataNode;
+class SectorIndex;
+
+struct Sector
+{
+    LocationDataNode *head = nullptr;
+    LocationDataNode *last = nullptr;
+
+    QByteArray packed; //cold block, head is null while the sector is packed
+    qint64 spillOffset = -1; //block in the snapshot file while the sector is evicted, packed is empty then
+    qint64 spillSize = 0;
+    qint64 bytes = 0; //heap held by the nodes or the packed block, 0 while evicted
+    qint64 lastAccess = 0; //ms since epoch of the last query or append
+    SectorIndex *index = nullptr; //built by the first filtered query, dropped when the nodes are reordered or packed
+
+    quint32 id = 0;
+    quint64 locations = 0;
+    qint64 earliest = 0; //timestamps of the POIs, kept while the sector is packed or evicted
+    qint64 latest = 0;
+    QAtomicInteger<quint64> revision = 0; //bumped by every append, read without the mutex
+    bool updated = false;
+    bool damaged = false; //the cold block failed to decode, reported once
+    QMutex mutex;
+};
+
+/*
+ * Sparse sector directory
+ *
+ * Only cells that actually hold POIs get a Sector. Cells are addressed by an ID derived from their
+ * column (longitude) and row (latitude) so every sweep is proportional to the occupied cells instead
+ * of the whole globe, and SectorSize can be made finer without allocating the empty ocean cells.
+ *
+ * Sectors are only destroyed by clear(), which the owner must serialize against readers.
+ */
+class SectorDirectory
+{
+public:
+    static constexpr qreal SectorSize = 1.0; //degrees
+    static constexpr int Columns = static_cast<int>(360 / SectorSize);
+    static constexpr int Rows = static_cast<int>(180 / SectorSize);
+
+    SectorDirectory() = default;
+    ~SectorDirectory();
+
+    SectorDirectory(const SectorDirectory &) = delete;
+    SectorDirectory &operator=(const SectorDirectory &) = delete;
+
+    static int column(qreal longitude);
+    static int row(qreal latitude);
+    static quint32 sectorId(int column, int row);
+    static int columnOf(quint32 id);
+    static int rowOf(quint32 id);
+
+    //south west corner of a sector
+    static qreal longitudeOf(quint32 id);
+    static qreal latitudeOf(quint32 id);
+
+    Sector *sector(quint32 id) const;
+    Sector *findOrCreate(qreal latitude, qreal longitude);
+
+    //snapshot of the occupied sectors ordered by ID
+    QList<Sector*> sectors() const;
+    QList<Sector*> sectorsInRect(int columnStart, int columnEnd, int rowStart, int rowEnd) const;
+
+    qsizetype count() const;
+
+    //destroys every sector and the nodes they hold
+    void clear();
+
+    static void deleteNodes(LocationDataNode *head);
+
+private:
+    mutable QReadWriteLock m_lock;
+    QHash<quint32, Sector*> m_sectors;
+};
+
+#endif // SECTORDIRECTORY_H
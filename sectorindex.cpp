@@ -0,0 +1,226 @@
+#include "sectorindex.h"
+#include "locationmodel.h"
+
+#include <algorithm>
+#include <limits>
+
+bool LocationFilter::isEmpty() const
+{
+    return wifi && bluetooth && cellular && !openOnly && encryption == AllEncryption && minimumTimestamp == 0 && maximumTimestamp == 0 && qIsInf(minimumSignal) && qIsInf(maximumSignal);
+}
+
+bool LocationFilter::accepts(const LocationData &data) const
+{
+    //POIs of other types only pass when no type is filtered out
+    if(!wifi || !bluetooth || !cellular)
+    {
+        TypeClass type = typeClass(data.type);
+
+        if(type == OtherType || (type == Wifi && !wifi) || (type == Bluetooth && !bluetooth) || (type == Cellular && !cellular))
+            return false;
+    }
+
+    quint32 classes = encryption;
+
+    if(openOnly)
+        classes &= 1 << Open;
+
+    if(classes != AllEncryption && !(classes & (1 << encryptionClass(data.encryption))))
+        return false;
+
+    if((minimumTimestamp != 0 && data.timestamp < minimumTimestamp) || (maximumTimestamp != 0 && data.timestamp > maximumTimestamp))
+        return false;
+
+    if((!qIsInf(minimumSignal) || !qIsInf(maximumSignal)) && (data.signal < minimumSignal || data.signal > maximumSignal))
+        return false;
+
+    return true;
+}
+
+size_t LocationFilter::hash() const
+{
+    return qHashMulti(0, wifi, bluetooth, cellular, openOnly, encryption, minimumTimestamp, maximumTimestamp, minimumSignal, maximumSignal);
+}
+
+LocationFilter::TypeClass LocationFilter::typeClass(const QString &type)
+{
+    if(type.isEmpty() || type.compare("WIFI", Qt::CaseInsensitive) == 0)
+        return Wifi;
+
+    if(type.compare("BT", Qt::CaseInsensitive) == 0 || type.compare("BLE", Qt::CaseInsensitive) == 0)
+        return Bluetooth;
+
+    for(const char *key : { "GSM", "CDMA", "WCDMA", "LTE", "NR" })
+    {
+        if(type.compare(QLatin1String(key), Qt::CaseInsensitive) == 0)
+            return Cellular;
+    }
+
+    return OtherType;
+}
+
+//WiGLE writes capability strings like [WPA2-PSK-CCMP][ESS], KML exports plain names
+LocationFilter::EncryptionClass LocationFilter::encryptionClass(const QString &encryption)
+{
+    if(encryption.isEmpty())
+        return UnknownEncryption;
+
+    if(encryption.contains("WPA3", Qt::CaseInsensitive) || encryption.contains("SAE", Qt::CaseInsensitive) || encryption.contains("OWE", Qt::CaseInsensitive))
+        return Wpa3;
+
+    if(encryption.contains("WPA2", Qt::CaseInsensitive) || encryption.contains("RSN", Qt::CaseInsensitive))
+        return Wpa2;
+
+    if(encryption.contains("WPA", Qt::CaseInsensitive))
+        return Wpa;
+
+    if(encryption.contains("WEP", Qt::CaseInsensitive))
+        return Wep;
+
+    if(encryption.contains("ESS", Qt::CaseInsensitive) || encryption.contains("OPEN", Qt::CaseInsensitive) || encryption.contains("NONE", Qt::CaseInsensitive))
+        return Open;
+
+    return UnknownEncryption;
+}
+
+QString LocationFilter::encryptionName(EncryptionClass encryption)
+{
+    switch(encryption)
+    {
+    case Open:
+        return "open";
+    case Wep:
+        return "wep";
+    case Wpa:
+        return "wpa";
+    case Wpa2:
+        return "wpa2";
+    case Wpa3:
+        return "wpa3";
+    case UnknownEncryption:
+    case EncryptionClasses:
+        break;
+    }
+
+    return "unknown";
+}
+
+void SectorIndex::append(LocationDataNode *node)
+{
+    quint32 position = static_cast<quint32>(m_nodes.count());
+    const LocationData &data = node->data;
+
+    m_nodes.append(node);
+    m_types[LocationFilter::typeClass(data.type)].add(position);
+    m_encryption[LocationFilter::encryptionClass(data.encryption)].add(position);
+
+    if(m_timestampsSorted && !m_timestamps.isEmpty() && m_timestamps.last().first > data.timestamp)
+        m_timestampsSorted = false;
+
+    if(m_signalsSorted && !m_signals.isEmpty() && m_signals.last().first > data.signal)
+        m_signalsSorted = false;
+
+    m_timestamps.append(qMakePair(data.timestamp, position));
+    m_signals.append(qMakePair(data.signal, position));
+}
+
+qsizetype SectorIndex::count() const
+{
+    return m_nodes.count();
+}
+
+template<typename Value>
+RoaringBitmap SectorIndex::range(QVector<QPair<Value, quint32>> &column, bool &sorted, Value minimum, Value maximum)
+{
+    if(!sorted)
+    {
+        std::sort(column.begin(), column.end());
+        sorted = true;
+    }
+
+    auto begin = std::lower_bound(column.begin(), column.end(), qMakePair(minimum, std::numeric_limits<quint32>::min()));
+    auto end = std::upper_bound(column.begin(), column.end(), qMakePair(maximum, std::numeric_limits<quint32>::max()));
+
+    //the bitmap wants positions in ascending order
+    QVector<quint32> positions;
+    positions.reserve(std::max<qsizetype>(end - begin, 0));
+
+    for(auto entry = begin; entry < end; ++entry)
+        positions.append(entry->second);
+
+    std::sort(positions.begin(), positions.end());
+
+    RoaringBitmap bitmap;
+
+    for(quint32 position : std::as_const(positions))
+        bitmap.add(position);
+
+    return bitmap;
+}
+
+QVector<LocationDataNode*> SectorIndex::select(const LocationFilter &filter)
+{
+    if(filter.isEmpty())
+        return m_nodes;
+
+    RoaringBitmap result;
+    bool restricted = false;
+
+    auto restrict = [&result, &restricted](const RoaringBitmap &bitmap) {
+        result = restricted ? (result & bitmap) : bitmap;
+        restricted = true;
+    };
+
+    //only pass POIs of other types when no type is filtered out
+    if(!filter.wifi || !filter.bluetooth || !filter.cellular)
+    {
+        RoaringBitmap types;
+
+        if(filter.wifi)
+            types = types | m_types[LocationFilter::Wifi];
+        if(filter.bluetooth)
+            types = types | m_types[LocationFilter::Bluetooth];
+        if(filter.cellular)
+            types = types | m_types[LocationFilter::Cellular];
+
+        restrict(types);
+    }
+
+    quint32 encryption = filter.encryption;
+
+    if(filter.openOnly)
+        encryption &= 1 << LocationFilter::Open;
+
+    if(encryption != LocationFilter::AllEncryption)
+    {
+        RoaringBitmap classes;
+
+        for(int encryptionClass = 0; encryptionClass < LocationFilter::EncryptionClasses; ++encryptionClass)
+        {
+            if(encryption & (1 << encryptionClass))
+                classes = classes | m_encryption[encryptionClass];
+        }
+
+        restrict(classes);
+    }
+
+    if(filter.minimumTimestamp != 0 || filter.maximumTimestamp != 0)
+    {
+        qint64 minimum = filter.minimumTimestamp != 0 ? filter.minimumTimestamp : std::numeric_limits<qint64>::min();
+        qint64 maximum = filter.maximumTimestamp != 0 ? filter.maximumTimestamp : std::numeric_limits<qint64>::max();
+
+        restrict(range(m_timestamps, m_timestampsSorted, minimum, maximum));
+    }
+
+    if(!qIsInf(filter.minimumSignal) || !qIsInf(filter.maximumSignal))
+        restrict(range(m_signals, m_signalsSorted, filter.minimumSignal, filter.maximumSignal));
+
+    QVector<LocationDataNode*> nodes;
+    nodes.reserve(result.cardinality());
+
+    result.forEach([this, &nodes](quint32 position) {
+        nodes.append(m_nodes[position]);
+    });
+
+    return nodes;
+}
@@ -0,0 +1,98 @@
+#ifndef SECTORINDEX_H
+#define SECTORINDEX_H
+
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtNumeric>
+
+#include "roaringbitmap.h"
+
+struct LocationData;
+struct LocationDataNode;
+
+struct LocationFilter
+{
+    enum TypeClass
+    {
+        Wifi = 0,
+        Bluetooth,
+        Cellular,
+        OtherType,
+        TypeClasses
+    };
+
+    enum EncryptionClass
+    {
+        Open = 0,
+        Wep,
+        Wpa,
+        Wpa2,
+        Wpa3,
+        UnknownEncryption,
+        EncryptionClasses
+    };
+
+    static constexpr quint32 AllEncryption = (1 << EncryptionClasses) - 1;
+
+    bool wifi = true;
+    bool bluetooth = true;
+    bool cellular = true;
+    bool openOnly = false;
+    quint32 encryption = AllEncryption; //mask of EncryptionClass bits
+    qint64 minimumTimestamp = 0; //ms since epoch, 0 is unbounded
+    qint64 maximumTimestamp = 0;
+    qreal minimumSignal = -qInf();
+    qreal maximumSignal = qInf();
+
+    //true if every POI passes
+    bool isEmpty() const;
+
+    //the per POI form of SectorIndex::select(), for nodes that aren't indexed
+    bool accepts(const LocationData &data) const;
+    size_t hash() const;
+
+    static TypeClass typeClass(const QString &type);
+    static EncryptionClass encryptionClass(const QString &encryption);
+    static QString encryptionName(EncryptionClass encryption);
+};
+
+/*
+ * Per sector attribute index
+ *
+ * Indexes the nodes of a sector by their position in the sector's list. Type and encryption classes
+ * are kept as compressed bitmaps, timestamp and signal as columns sorted by value so a range is a
+ * binary search. A filter becomes a few bitmap ANDs and ORs before any node is touched.
+ *
+ * Open networks are the Open encryption class, WiGLE's CSV keeps the channel where KML keeps the
+ * open flag so the flag itself can't be trusted.
+ *
+ * Appends keep the index current. Anything that reorders or destroys the nodes must drop it.
+ */
+class SectorIndex
+{
+public:
+    void append(LocationDataNode *node);
+    qsizetype count() const;
+
+    //nodes passing the filter in list order
+    QVector<LocationDataNode*> select(const LocationFilter &filter);
+
+private:
+    template<typename Value>
+    static RoaringBitmap range(QVector<QPair<Value, quint32>> &column, bool &sorted, Value minimum, Value maximum);
+
+    QVector<LocationDataNode*> m_nodes;
+
+    RoaringBitmap m_types[LocationFilter::TypeClasses];
+    RoaringBitmap m_encryption[LocationFilter::EncryptionClasses];
+
+    //value, position pairs sorted lazily after appends
+    QVector<QPair<qint64, quint32>> m_timestamps;
+    QVector<QPair<qreal, quint32>> m_signals;
+    bool m_timestampsSorted = true;
+    bool m_signalsSorted = true;
+};
+
+#endif // SECTORINDEX_H
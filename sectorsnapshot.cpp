@@ -0,0 +1,167 @@
+#include "sectorsnapshot.h"
+
+#include <QDebug>
+#include <QDir>
+
+#include <iterator>
+
+//must be called with the mutex held
+bool SectorSnapshot::open()
+{
+    if(m_file.isOpen())
+        return true;
+
+    m_file.setFileTemplate(QDir::tempPath() + QDir::separator() + "wdrvr-sectors-XXXXXX.bin");
+
+    if(!m_file.open())
+    {
+        qDebug() << "Could not open sector snapshot" << m_file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+qint64 SectorSnapshot::write(const QByteArray &block)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(!open())
+        return -1;
+
+    qint64 offset = m_file.size();
+    auto range = m_free.begin();
+
+    //first released range the block fits in
+    for(; range != m_free.end(); ++range)
+    {
+        if(range.value() >= block.size())
+        {
+            offset = range.key();
+            break;
+        }
+    }
+
+    if(!m_file.seek(offset) || m_file.write(block) != block.size())
+    {
+        qDebug() << "Could not write sector snapshot" << m_file.errorString();
+
+        //drop the partial block, a reused range stays free as it was
+        if(range == m_free.end())
+            m_file.resize(offset);
+
+        return -1;
+    }
+
+    if(range != m_free.end())
+    {
+        qint64 rest = range.value() - block.size();
+        m_free.erase(range);
+
+        if(rest > 0)
+            m_free.insert(offset + block.size(), rest);
+    }
+
+    m_liveBytes += block.size();
+
+    return offset;
+}
+
+QByteArray SectorSnapshot::read(qint64 offset, qint64 size)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(!m_file.isOpen() || !m_file.seek(offset))
+        return QByteArray();
+
+    QByteArray block = m_file.read(size);
+
+    if(block.size() != size)
+    {
+        qDebug() << "Could not read sector snapshot" << m_file.errorString();
+        return QByteArray();
+    }
+
+    return block;
+}
+
+void SectorSnapshot::release(qint64 offset, qint64 size)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_liveBytes -= size;
+
+    //everything left in the file is dead
+    if(m_liveBytes <= 0)
+    {
+        m_liveBytes = 0;
+        m_free.clear();
+
+        if(m_file.isOpen())
+            m_file.resize(0);
+
+        return;
+    }
+
+    //merge with the free neighbours on both sides
+    auto next = m_free.lowerBound(offset);
+
+    if(next != m_free.end() && next.key() == offset + size)
+    {
+        size += next.value();
+        next = m_free.erase(next);
+    }
+
+    if(next != m_free.begin())
+    {
+        auto previous = std::prev(next);
+
+        if(previous.key() + previous.value() == offset)
+        {
+            offset = previous.key();
+            size += previous.value();
+            m_free.erase(previous);
+        }
+    }
+
+    m_free.insert(offset, size);
+    truncateFree();
+}
+
+//must be called with the mutex held, cuts a free range off the end of the file
+void SectorSnapshot::truncateFree()
+{
+    if(m_free.isEmpty() || !m_file.isOpen())
+        return;
+
+    auto last = std::prev(m_free.end());
+
+    if(last.key() + last.value() >= m_file.size())
+    {
+        m_file.resize(last.key());
+        m_free.erase(last);
+    }
+}
+
+void SectorSnapshot::clear()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_liveBytes = 0;
+    m_free.clear();
+
+    if(m_file.isOpen())
+        m_file.resize(0);
+}
+
+qint64 SectorSnapshot::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_liveBytes;
+}
+
+qint64 SectorSnapshot::fileSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_file.isOpen() ? m_file.size() : 0;
+}
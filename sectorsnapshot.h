@@ -0,0 +1,52 @@
+#ifndef SECTORSNAPSHOT_H
+#define SECTORSNAPSHOT_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QTemporaryFile>
+
+/*
+ * Spill file for evicted sectors
+ *
+ * Packed blocks of sectors pushed out by the memory budget are written to a temporary file and read
+ * back when a viewport, save or export needs them again. Blocks are never rewritten in place, a thawed
+ * sector just releases its block. Released ranges are merged with their neighbours and reused first
+ * fit by later blocks, a free range at the end of the file is cut off, so a sector going back and
+ * forth doesn't grow the file while other blocks stay live.
+ *
+ * The file is removed with the snapshot.
+ */
+class SectorSnapshot
+{
+public:
+    SectorSnapshot() = default;
+
+    SectorSnapshot(const SectorSnapshot &) = delete;
+    SectorSnapshot &operator=(const SectorSnapshot &) = delete;
+
+    //offset of the written block, -1 if it couldn't be written
+    qint64 write(const QByteArray &block);
+    QByteArray read(qint64 offset, qint64 size);
+
+    //forgets a block that was read back for good
+    void release(qint64 offset, qint64 size);
+    void clear();
+
+    //bytes of blocks that are still live
+    qint64 size() const;
+
+    //bytes the file takes, live and free
+    qint64 fileSize() const;
+
+private:
+    bool open();
+    void truncateFree();
+
+    mutable QMutex m_mutex;
+    QTemporaryFile m_file;
+    qint64 m_liveBytes = 0;
+    QMap<qint64, qint64> m_free; //offset and size of released ranges, never adjacent
+};
+
+#endif // SECTORSNAPSHOT_H
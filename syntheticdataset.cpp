@@ -0,0 +1,496 @@
+#include "syntheticdataset.h"
+#include "locationmodel.h"
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+
+namespace
+{
+//cluster centers are drawn from these, mostly grouped by region so neighbours make sense as roads
+const QGeoCoordinate Cities[] {
+    QGeoCoordinate(40.7128, -74.0060), QGeoCoordinate(39.9526, -75.1652), QGeoCoordinate(42.3601, -71.0589),
+    QGeoCoordinate(38.9072, -77.0369), QGeoCoordinate(41.8781, -87.6298), QGeoCoordinate(47.6062, -122.3321),
+    QGeoCoordinate(45.5152, -122.6784), QGeoCoordinate(37.7749, -122.4194), QGeoCoordinate(34.0522, -118.2437),
+    QGeoCoordinate(32.7157, -117.1611), QGeoCoordinate(51.5072, -0.1276), QGeoCoordinate(48.8566, 2.3522),
+    QGeoCoordinate(50.8503, 4.3517), QGeoCoordinate(52.3676, 4.9041), QGeoCoordinate(52.5200, 13.4050),
+    QGeoCoordinate(59.9139, 10.7522), QGeoCoordinate(59.3293, 18.0686), QGeoCoordinate(55.6761, 12.5683),
+    QGeoCoordinate(35.6762, 139.6503), QGeoCoordinate(34.6937, 135.5023), QGeoCoordinate(37.5665, 126.9780),
+    QGeoCoordinate(-33.8688, 151.2093), QGeoCoordinate(-37.8136, 144.9631), QGeoCoordinate(-27.4698, 153.0251)
+};
+
+const char *const WifiNames[] { "xfinitywifi", "attwifi", "Starbucks WiFi", "Free Public WiFi", "Home", "DIRECT-roku", "Guest" };
+const char *const WifiVendors[] { "NETGEAR", "TP-Link_", "Linksys", "ASUS_", "FRITZ!Box ", "Telenor_", "MySpectrumWiFi" };
+const char *const BluetoothNames[] { "JBL Flip 5", "Galaxy Buds", "AirPods", "Pixel 7", "Car Multimedia", "Fitbit", "[TV] Samsung" };
+const char *const BluetoothManufacturers[] { "76", "6", "117", "224", "89" }; //Apple, Microsoft, Samsung, Google, Nordic
+const int WifiChannels5G[] { 36, 40, 44, 48, 149, 153, 157, 161 };
+
+//AuthMode strings in the form WiGLE writes them, weighted by how often they show up on a drive
+const QPair<const char*, int> WifiEncryption[] {
+    { "[WPA2-PSK-CCMP][ESS]", 52 }, { "[WPA-PSK-CCMP+TKIP][WPA2-PSK-CCMP+TKIP][ESS]", 12 }, { "[WPA3-SAE-CCMP][ESS]", 8 },
+    { "[WPA2-EAP-CCMP][ESS]", 5 }, { "[WPA-PSK-TKIP][ESS]", 4 }, { "[WEP][ESS]", 2 }, { "[ESS]", 17 }
+};
+
+struct Operator
+{
+    const char *name;
+    const char *code; //MCC and MNC
+};
+
+const Operator Operators[] {
+    { "T-Mobile", "310260" }, { "AT&T", "310410" }, { "Verizon", "311480" },
+    { "Vodafone", "23415" }, { "Telenor", "24201" }, { "Orange", "20801" }
+};
+
+//channel and frequency in MHz of a few common bands per technology
+struct Band
+{
+    int channel;
+    int frequency;
+};
+
+const Band GsmBands[] { { 128, 850 }, { 512, 1900 }, { 62, 900 }, { 600, 1800 } };
+const Band LteBands[] { { 5230, 700 }, { 850, 1900 }, { 2175, 2100 }, { 66786, 2100 }, { 9820, 600 } };
+const Band NrBands[] { { 126400, 600 }, { 627264, 3500 }, { 520110, 2500 }, { 2079165, 28000 } };
+
+QString macAddress(quint64 address)
+{
+    QString mac = QString("%1").arg(address, 12, 16, QChar('0'));
+
+    for(int position = 10; position > 0; position -= 2)
+        mac.insert(position, ':');
+
+    return mac;
+}
+
+template<typename Type, qsizetype Size>
+const Type &pick(QRandomGenerator &random, const Type (&values)[Size])
+{
+    return values[random.bounded(static_cast<int>(Size))];
+}
+}
+
+SyntheticDataset::SyntheticDataset(const Options &options)
+{
+    m_options = options;
+
+    //clusters only depend on the seed, so changing the size keeps the same map
+    QRandomGenerator random(m_options.seed ^ 0x636c7573);
+    QVector<int> order(std::size(Cities));
+    std::iota(order.begin(), order.end(), 0);
+
+    for(qsizetype index = order.count() - 1; index > 0; --index)
+        std::swap(order[index], order[random.bounded(static_cast<int>(index + 1))]);
+
+    qreal weight = 0;
+    int clusters = std::max(m_options.clusters, 1);
+
+    for(int index = 0; index < clusters; ++index)
+    {
+        Cluster cluster;
+        cluster.center = Cities[order[index % order.count()]];
+
+        //more clusters than cities become suburbs of the cities already taken
+        if(index >= order.count())
+            cluster.center = offset(cluster.center, gaussian(random) * 40, gaussian(random) * 40);
+
+        //city sizes roughly follow Zipf's law
+        weight += 1.0 / (index + 1);
+        cluster.weight = weight;
+
+        m_clusters.append(cluster);
+    }
+
+    for(int index = 0; index < m_clusters.count(); ++index)
+    {
+        qreal closest = qInf();
+
+        for(int other = 0; other < m_clusters.count(); ++other)
+        {
+            qreal distance = m_clusters[index].center.distanceTo(m_clusters[other].center);
+
+            if(other != index && distance < closest)
+            {
+                closest = distance;
+                m_clusters[index].neighbour = other;
+            }
+        }
+    }
+
+    for(const QPair<QString, qreal> &type : std::as_const(m_options.typeMix))
+    {
+        if(type.second <= 0)
+            continue;
+
+        m_typeWeight += type.second;
+        m_types.append(qMakePair(type.first.toUpper(), m_typeWeight));
+    }
+
+    if(m_types.isEmpty())
+    {
+        m_types.append(qMakePair(QString("WIFI"), 1.0));
+        m_typeWeight = 1;
+    }
+
+    reset();
+}
+
+const SyntheticDataset::Options &SyntheticDataset::options() const
+{
+    return m_options;
+}
+
+QList<QGeoCoordinate> SyntheticDataset::clusterCenters() const
+{
+    QList<QGeoCoordinate> centers;
+
+    for(const Cluster &cluster : m_clusters)
+        centers.append(cluster.center);
+
+    return centers;
+}
+
+bool SyntheticDataset::atEnd() const
+{
+    return m_position >= m_options.size;
+}
+
+quint64 SyntheticDataset::position() const
+{
+    return m_position;
+}
+
+void SyntheticDataset::reset()
+{
+    m_random.seed(m_options.seed);
+    m_position = 0;
+    m_devices = 0;
+}
+
+LocationData SyntheticDataset::next()
+{
+    bool duplicate = m_devices > 0 && m_random.generateDouble() < m_options.duplicateRate;
+    quint64 serial = duplicate ? m_random.bounded(m_devices) : m_devices++;
+
+    LocationData data = device(serial);
+    data.coordinates = offset(data.coordinates, gaussian(m_random) * SightingRadius, gaussian(m_random) * SightingRadius);
+    data.accuracy = 3 + m_random.bounded(23);
+
+    switch(LocationFilter::typeClass(data.type))
+    {
+    case LocationFilter::Bluetooth:
+        data.signal = -100 + m_random.bounded(50);
+        break;
+    case LocationFilter::Cellular:
+        data.signal = -120 + m_random.bounded(60);
+        break;
+    default:
+        data.signal = -95 + m_random.bounded(60);
+        break;
+    }
+
+    data.timestamp = m_options.startTime;
+
+    if(m_options.size > 1)
+        data.timestamp += static_cast<qint64>(static_cast<double>(m_options.timeSpread) * m_position / (m_options.size - 1));
+
+    ++m_position;
+
+    return data;
+}
+
+//everything that stays the same between sightings of a device
+LocationData SyntheticDataset::device(quint64 serial) const
+{
+    const quint32 seeds[] { m_options.seed, static_cast<quint32>(serial), static_cast<quint32>(serial >> 32), 0x64657669 };
+    QRandomGenerator random(seeds, std::size(seeds));
+
+    LocationData data;
+    auto type = std::lower_bound(m_types.begin(), m_types.end(), random.generateDouble() * m_typeWeight, [](const QPair<QString, qreal> &entry, qreal value) {
+        return entry.second < value;
+    });
+
+    data.type = (type == m_types.end() ? m_types.last() : *type).first;
+
+    data.coordinates = home(random);
+
+    quint64 address = deviceAddress(serial, m_options.seed);
+
+    switch(LocationFilter::typeClass(data.type))
+    {
+    case LocationFilter::Cellular:
+    {
+        const Operator &carrier = pick(random, Operators);
+        const Band &band = data.type == "GSM" ? pick(random, GsmBands) : data.type == "NR" ? pick(random, NrBands) : pick(random, LteBands);
+
+        //WiGLE ids cells as MCCMNC_TAC_CID, the address keeps them unique
+        data.id = QString("%1_%2_%3").arg(carrier.code).arg(address >> 28).arg(address & 0xfffffff);
+        data.name = carrier.name;
+        data.encryption = QString("%1;%2").arg(data.type, carrier.code);
+        data.open = band.channel;
+        data.frequency = band.frequency;
+        break;
+    }
+    case LocationFilter::Bluetooth:
+        data.id = macAddress(address);
+        data.name = random.bounded(3) == 0 ? QString() : QString(pick(random, BluetoothNames));
+        data.encryption = "Misc";
+
+        if(data.type == "BLE")
+            data.mfgid = pick(random, BluetoothManufacturers);
+        break;
+    default:
+    {
+        data.id = macAddress(address);
+
+        int style = random.bounded(10);
+
+        if(style == 0)
+            data.name = QString(); //hidden
+        else if(style < 4)
+            data.name = pick(random, WifiNames);
+        else
+            data.name = pick(random, WifiVendors) + QString::number(random.bounded(0x10000), 16).rightJustified(4, '0').toUpper();
+
+        int encryption = random.bounded(100);
+
+        for(const QPair<const char*, int> &entry : WifiEncryption)
+        {
+            if((encryption -= entry.second) < 0)
+            {
+                data.encryption = entry.first;
+                break;
+            }
+        }
+
+        if(random.bounded(10) < 7)
+        {
+            data.open = 1 + random.bounded(11);
+            data.frequency = 2407 + (data.open * 5);
+        }
+        else
+        {
+            data.open = pick(random, WifiChannels5G);
+            data.frequency = 5000 + (data.open * 5);
+        }
+        break;
+    }
+    }
+
+    return data;
+}
+
+QGeoCoordinate SyntheticDataset::home(QRandomGenerator &random) const
+{
+    int index = pickCluster(random);
+    const Cluster &cluster = m_clusters[index];
+
+    if(m_clusters.count() > 1 && random.generateDouble() < m_options.ruralRate)
+    {
+        //somewhere along the road to the closest cluster, a few hundred meters off it
+        const QGeoCoordinate &to = m_clusters[cluster.neighbour].center;
+        qreal position = random.generateDouble();
+
+        QGeoCoordinate road(cluster.center.latitude() + ((to.latitude() - cluster.center.latitude()) * position),
+                            cluster.center.longitude() + ((to.longitude() - cluster.center.longitude()) * position));
+
+        return offset(road, gaussian(random) * 0.3, gaussian(random) * 0.3);
+    }
+
+    return offset(cluster.center, gaussian(random) * m_options.clusterRadius, gaussian(random) * m_options.clusterRadius);
+}
+
+int SyntheticDataset::pickCluster(QRandomGenerator &random) const
+{
+    qreal weight = random.generateDouble() * m_clusters.last().weight;
+
+    auto cluster = std::lower_bound(m_clusters.begin(), m_clusters.end(), weight, [](const Cluster &entry, qreal value) {
+        return entry.weight < value;
+    });
+
+    return std::min<qsizetype>(cluster - m_clusters.begin(), m_clusters.count() - 1);
+}
+
+//a bijection of the low 48 bits of the serial, so ids look random but never collide
+quint64 SyntheticDataset::deviceAddress(quint64 serial, quint32 seed)
+{
+    constexpr quint64 Mask = (quint64(1) << 48) - 1;
+
+    quint64 address = (serial ^ (seed * 0x9e3779b97f4a7c15ULL)) & Mask;
+    address = (address * 0x5deece66dULL) & Mask;
+    address ^= address >> 24;
+    address = (address * 0xbf58476d1ce4e5b9ULL) & Mask;
+    address ^= address >> 23;
+
+    return address;
+}
+
+QGeoCoordinate SyntheticDataset::offset(const QGeoCoordinate &center, qreal north, qreal east)
+{
+    constexpr qreal KilometersPerDegree = 111.32;
+
+    qreal latitude = std::clamp(center.latitude() + (north / KilometersPerDegree), -89.9, 89.9);
+    qreal longitude = center.longitude() + (east / (KilometersPerDegree * std::cos(qDegreesToRadians(latitude))));
+
+    if(longitude > 180)
+        longitude -= 360;
+    else if(longitude < -180)
+        longitude += 360;
+
+    return QGeoCoordinate(latitude, longitude);
+}
+
+//standard normal sample, Box-Muller
+qreal SyntheticDataset::gaussian(QRandomGenerator &random)
+{
+    qreal radius = std::sqrt(-2 * std::log(1 - random.generateDouble()));
+    return radius * std::cos(2 * M_PI * random.generateDouble());
+}
+
+bool SyntheticDataset::writeCsv(QIODevice *device, const Progress &progress)
+{
+    return writeFile(device, LocationExporter::Csv, progress);
+}
+
+bool SyntheticDataset::writeKml(QIODevice *device, const Progress &progress)
+{
+    return writeFile(device, LocationExporter::Kml, progress);
+}
+
+//rows are formatted by the exporter, so generated files read back exactly like exported ones
+bool SyntheticDataset::writeFile(QIODevice *device, LocationExporter::Format format, const Progress &progress)
+{
+    LocationExporter exporter(format);
+
+    if(device->write(exporter.header()) < 0)
+        return false;
+
+    QByteArray buffer;
+    buffer.reserve(1 << 20);
+    bool written = false;
+
+    auto flush = [&]() {
+        if(buffer.isEmpty())
+            return true;
+
+        if((written && device->write(exporter.separator()) < 0) || device->write(buffer) < 0)
+            return false;
+
+        written = true;
+        buffer.clear();
+
+        return true;
+    };
+
+    while(!atEnd())
+    {
+        exporter.append(buffer, next());
+
+        if(buffer.size() > (1 << 20) && !flush())
+            return false;
+
+        if(progress && m_position % ProgressInterval == 0)
+            progress(m_position);
+    }
+
+    if(!flush() || device->write(exporter.footer()) < 0)
+        return false;
+
+    if(progress)
+        progress(m_position);
+
+    return true;
+}
+
+//a database the app loads as is, rows go in with the same encoding save() uses
+bool SyntheticDataset::writeDatabase(const QString &fileName, const Progress &progress)
+{
+    QString connection = QString("wdrvr_gen_%1").arg(reinterpret_cast<quintptr>(this));
+    bool success = false;
+
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connection);
+        database.setDatabaseName(fileName);
+
+        if(!database.open())
+            qDebug() << "Could not open database" << fileName << database.lastError();
+
+        else if(LocationModel::createTables(database))
+        {
+            QSqlQuery query(database);
+
+            //a generated database can be generated again, durability isn't worth the time
+            query.exec("PRAGMA synchronous = OFF");
+            query.exec("PRAGMA journal_mode = MEMORY");
+
+            success = LocationModel::prepareInsert(query);
+
+            while(success && !atEnd())
+            {
+                database.transaction();
+
+                for(int row = 0; success && row < DatabaseBatch && !atEnd(); ++row)
+                {
+                    LocationModel::bindInsert(query, next());
+
+                    if(!query.exec())
+                    {
+                        qDebug() << "Failed to write database" << fileName << query.lastError();
+                        success = false;
+                    }
+
+                    if(progress && m_position % ProgressInterval == 0)
+                        progress(m_position);
+                }
+
+                if(!database.commit())
+                {
+                    qDebug() << "Failed to commit database" << fileName << database.lastError();
+                    success = false;
+                }
+            }
+
+            if(progress)
+                progress(m_position);
+        }
+
+        database.close();
+    }
+
+    QSqlDatabase::removeDatabase(connection);
+
+    return success;
+}
+
+bool SyntheticDataset::parseTypeMix(const QString &mix, QList<QPair<QString, qreal>> &typeMix)
+{
+    static const QStringList types { "WIFI", "BT", "BLE", "GSM", "LTE", "NR" };
+
+    QList<QPair<QString, qreal>> parsed;
+
+    for(const QString &entry : mix.split(',', Qt::SkipEmptyParts))
+    {
+        QStringList parts = entry.split('=');
+        bool valid = false;
+        qreal weight = parts.count() == 2 ? parts[1].trimmed().toDouble(&valid) : 0;
+        QString type = parts[0].trimmed().toUpper();
+
+        if(!valid || weight < 0 || !types.contains(type))
+            return false;
+
+        parsed.append(qMakePair(type, weight));
+    }
+
+    if(parsed.isEmpty())
+        return false;
+
+    typeMix = parsed;
+
+    return true;
+}
@@ -0,0 +1,107 @@
+#ifndef SYNTHETICDATASET_H
+#define SYNTHETICDATASET_H
+
+#include <QGeoCoordinate>
+#include <QIODevice>
+#include <QList>
+#include <QPair>
+#include <QRandomGenerator>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+#include "locationexporter.h"
+
+struct LocationData;
+
+/*
+ * Deterministic synthetic WiGLE dataset
+ *
+ * Produces POIs one at a time from a seed, so the same options give the same rows on every machine
+ * and a 100M row file never has to fit in memory. POIs gather around urban clusters whose sizes
+ * fall off like real cities do, the rural share is strung along the roads between them.
+ *
+ * Every device is derived from its serial number alone, ids are a bijection of the serial so they
+ * never collide by accident. A duplicate row picks an earlier serial and reports that device again
+ * near where it was first seen, the way a second drive past the same access point looks to the
+ * importer. Timestamps advance evenly over the spread in row order.
+ */
+class SyntheticDataset
+{
+public:
+    struct Options
+    {
+        quint64 size = 100000;
+        quint32 seed = 1;
+        int clusters = 12;
+        qreal clusterRadius = 4; //km, one standard deviation around a cluster center
+        qreal ruralRate = 0.15; //share of devices between clusters
+        qreal duplicateRate = 0.05; //share of rows that repeat an earlier device
+        qint64 startTime = 1748505600000; //ms since epoch of the first row, 2025-05-29 08:00 UTC
+        qint64 timeSpread = 86400000; //ms between the first and the last row
+
+        //relative weights, WIFI, BT, BLE, GSM, LTE and NR are understood
+        QList<QPair<QString, qreal>> typeMix {
+            { "WIFI", 70 }, { "BT", 8 }, { "BLE", 10 }, { "GSM", 3 }, { "LTE", 7 }, { "NR", 2 }
+        };
+    };
+
+    //called with the number of rows written so far
+    using Progress = std::function<void(quint64)>;
+
+    static constexpr quint64 ProgressInterval = 100000; //rows between progress calls
+
+    explicit SyntheticDataset(const Options &options = Options());
+
+    const Options &options() const;
+
+    //largest cluster first
+    QList<QGeoCoordinate> clusterCenters() const;
+
+    bool atEnd() const;
+    quint64 position() const;
+    void reset();
+
+    LocationData next();
+
+    //stream the remaining rows, false if the output failed
+    bool writeCsv(QIODevice *device, const Progress &progress = Progress());
+    bool writeKml(QIODevice *device, const Progress &progress = Progress());
+    bool writeDatabase(const QString &fileName, const Progress &progress = Progress());
+
+    //"WIFI=70,BT=8,LTE=5", false on unknown types or bad weights
+    static bool parseTypeMix(const QString &mix, QList<QPair<QString, qreal>> &typeMix);
+
+private:
+    static constexpr int DatabaseBatch = 50000; //rows per transaction
+    static constexpr qreal SightingRadius = 0.08; //km, spread of repeated sightings of a device
+
+    struct Cluster
+    {
+        QGeoCoordinate center;
+        qreal weight = 0; //cumulative
+        int neighbour = 0; //closest other cluster, rural devices sit on the road to it
+    };
+
+    bool writeFile(QIODevice *device, LocationExporter::Format format, const Progress &progress);
+
+    LocationData device(quint64 serial) const;
+    QGeoCoordinate home(QRandomGenerator &random) const;
+    int pickCluster(QRandomGenerator &random) const;
+
+    static quint64 deviceAddress(quint64 serial, quint32 seed);
+    static QGeoCoordinate offset(const QGeoCoordinate &center, qreal north, qreal east);
+    static qreal gaussian(QRandomGenerator &random);
+
+    Options m_options;
+    QVector<Cluster> m_clusters;
+    QVector<QPair<QString, qreal>> m_types; //cumulative weights
+    qreal m_typeWeight = 0;
+
+    QRandomGenerator m_random;
+    quint64 m_position = 0;
+    quint64 m_devices = 0;
+};
+
+#endif // SYNTHETICDATASET_H
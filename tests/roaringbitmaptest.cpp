@@ -0,0 +1,162 @@
+#include "roaringbitmap.h"
+
+#include <QTest>
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+
+/*
+ * RoaringBitmap against a std::set reference
+ *
+ * Each row builds two bitmaps from arithmetic runs of values. The sizes sit around ArrayLimit so the
+ * containers switch between arrays and bitsets, and strides past 65536 spread a run over several keys.
+ */
+class RoaringBitmapTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void operations_data();
+    void operations();
+
+private:
+    static std::set<quint32> values(quint32 start, quint32 stride, int count);
+    static RoaringBitmap bitmap(const std::set<quint32> &values, bool descending);
+    static void verify(const RoaringBitmap &bitmap, const std::set<quint32> &expected);
+};
+
+std::set<quint32> RoaringBitmapTest::values(quint32 start, quint32 stride, int count)
+{
+    std::set<quint32> values;
+
+    for(int index = 0; index < count; ++index)
+        values.insert(start + (static_cast<quint32>(index) * stride));
+
+    return values;
+}
+
+RoaringBitmap RoaringBitmapTest::bitmap(const std::set<quint32> &values, bool descending)
+{
+    RoaringBitmap bitmap;
+
+    //descending adds miss the append fast path and insert into existing containers
+    if(descending)
+    {
+        for(auto value = values.rbegin(); value != values.rend(); ++value)
+            bitmap.add(*value);
+    }
+    else
+    {
+        for(quint32 value : values)
+            bitmap.add(value);
+    }
+
+    return bitmap;
+}
+
+void RoaringBitmapTest::verify(const RoaringBitmap &bitmap, const std::set<quint32> &expected)
+{
+    QCOMPARE(bitmap.cardinality(), quint64(expected.size()));
+    QCOMPARE(bitmap.isEmpty(), expected.empty());
+
+    std::vector<quint32> visited;
+    bitmap.forEach([&visited](quint32 value) {
+        visited.push_back(value);
+    });
+
+    QVERIFY(std::equal(visited.begin(), visited.end(), expected.begin(), expected.end()));
+
+    for(quint32 value : expected)
+    {
+        QVERIFY(bitmap.contains(value));
+
+        if(!expected.count(value + 1))
+            QVERIFY(!bitmap.contains(value + 1));
+    }
+}
+
+void RoaringBitmapTest::operations_data()
+{
+    QTest::addColumn<quint32>("leftStart");
+    QTest::addColumn<quint32>("leftStride");
+    QTest::addColumn<int>("leftCount");
+    QTest::addColumn<quint32>("rightStart");
+    QTest::addColumn<quint32>("rightStride");
+    QTest::addColumn<int>("rightCount");
+    QTest::addColumn<bool>("descending");
+
+    const int limit = RoaringBitmap::ArrayLimit;
+
+    //array containers
+    QTest::newRow("empty") << 0u << 1u << 0 << 0u << 1u << 0 << false;
+    QTest::newRow("empty and array") << 0u << 1u << 0 << 5u << 3u << 100 << false;
+    QTest::newRow("arrays, overlapping") << 0u << 3u << 100 << 0u << 2u << 100 << false;
+    QTest::newRow("arrays, disjoint") << 0u << 2u << 100 << 1u << 2u << 100 << false;
+    QTest::newRow("arrays, descending") << 0u << 3u << 100 << 0u << 2u << 100 << true;
+
+    //conversion at ArrayLimit
+    QTest::newRow("limit - 1") << 0u << 1u << limit - 1 << 0u << 1u << 1 << false;
+    QTest::newRow("limit") << 0u << 1u << limit << 0u << 1u << 1 << false;
+    QTest::newRow("limit + 1") << 0u << 1u << limit + 1 << 0u << 1u << 1 << false;
+    QTest::newRow("limit + 1, descending") << 0u << 1u << limit + 1 << 0u << 1u << 1 << true;
+    QTest::newRow("arrays unite past limit") << 0u << 2u << limit << 1u << 2u << limit << false;
+    QTest::newRow("arrays unite to limit") << 0u << 1u << limit / 2 << quint32(limit / 2) << 1u << limit / 2 << false;
+    QTest::newRow("bitset and array") << 0u << 1u << limit + 1 << 100u << 7u << 1000 << false;
+    QTest::newRow("bitsets") << 0u << 2u << limit * 2 << 0u << 3u << limit * 2 << false;
+    QTest::newRow("bitsets intersect to array") << 0u << 1u << limit + 10 << quint32(limit) << 1u << limit + 10 << false;
+    QTest::newRow("bitsets intersect to nothing") << 0u << 2u << limit * 2 << 1u << 2u << limit * 2 << false;
+
+    //several keys
+    QTest::newRow("keys, shared") << 0u << 65537u << 50 << 0u << 65536u << 50 << false;
+    QTest::newRow("keys, interleaved") << 0u << 131072u << 20 << 65536u << 131072u << 20 << false;
+    QTest::newRow("keys, descending") << 0u << 65537u << 50 << 0u << 65536u << 50 << true;
+    QTest::newRow("keys, dense across boundary") << 65536u - 5000u << 1u << 10000 << 65536u - 100u << 1u << 200 << false;
+    QTest::newRow("keys, top of range") << 0xffff0000u << 1u << limit + 1 << 0xfffffff0u << 1u << 16 << false;
+}
+
+void RoaringBitmapTest::operations()
+{
+    QFETCH(quint32, leftStart);
+    QFETCH(quint32, leftStride);
+    QFETCH(int, leftCount);
+    QFETCH(quint32, rightStart);
+    QFETCH(quint32, rightStride);
+    QFETCH(int, rightCount);
+    QFETCH(bool, descending);
+
+    std::set<quint32> leftValues = values(leftStart, leftStride, leftCount);
+    std::set<quint32> rightValues = values(rightStart, rightStride, rightCount);
+
+    RoaringBitmap left = bitmap(leftValues, descending);
+    RoaringBitmap right = bitmap(rightValues, descending);
+
+    verify(left, leftValues);
+    verify(right, rightValues);
+
+    std::set<quint32> intersection;
+    std::set_intersection(leftValues.begin(), leftValues.end(), rightValues.begin(), rightValues.end(), std::inserter(intersection, intersection.end()));
+
+    std::set<quint32> united;
+    std::set_union(leftValues.begin(), leftValues.end(), rightValues.begin(), rightValues.end(), std::inserter(united, united.end()));
+
+    verify(left & right, intersection);
+    verify(right & left, intersection);
+    verify(left | right, united);
+    verify(right | left, united);
+
+    //adding to a result keeps working whichever container it ended up as
+    RoaringBitmap grown = left | right;
+    std::set<quint32> grownValues = united;
+
+    for(quint32 value : values(leftStart + 1, 5, 2 * RoaringBitmap::ArrayLimit))
+    {
+        grown.add(value);
+        grownValues.insert(value);
+    }
+
+    verify(grown, grownValues);
+}
+
+QTEST_GUILESS_MAIN(RoaringBitmapTest)
+#include "roaringbitmaptest.moc"
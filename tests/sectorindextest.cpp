@@ -0,0 +1,183 @@
+#include "locationmodel.h"
+#include "sectorindex.h"
+
+#include <QTest>
+
+Q_DECLARE_METATYPE(LocationFilter)
+
+/*
+ * SectorIndex::select() against LocationFilter::accepts()
+ *
+ * The sector holds more nodes than ArrayLimit so the class bitmaps turn into bitsets, and the
+ * timestamps and signals are appended out of order so the range columns have to sort first. Every row
+ * has to select exactly the nodes accepts() passes, in list order.
+ */
+class SectorIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void select_data();
+    void select();
+    void appendAfterSelect();
+
+private:
+    static LocationData data(int index);
+
+    QVector<LocationDataNode> m_nodes;
+};
+
+LocationData SectorIndexTest::data(int index)
+{
+    static const char *types[] = { "WIFI", "", "BT", "BLE", "LTE", "GSM", "NR", "LORA" };
+    static const char *encryption[] = { "[WPA2-PSK-CCMP][ESS]", "[ESS]", "WEP", "[WPA-PSK-TKIP]", "[SAE]", "", "Open", "RSN" };
+
+    LocationData data;
+    data.type = types[index % 8];
+    data.encryption = encryption[(index / 3) % 8];
+    data.timestamp = 1700000000000 + ((index * 7919) % 10007) * 1000;
+    data.signal = -100 + ((index * 31) % 71);
+
+    return data;
+}
+
+void SectorIndexTest::initTestCase()
+{
+    //the nodes must not move once the index points at them
+    m_nodes.reserve(RoaringBitmap::ArrayLimit * 3);
+
+    for(int index = 0; index < RoaringBitmap::ArrayLimit * 3; ++index)
+        m_nodes.append(LocationDataNode(data(index)));
+}
+
+void SectorIndexTest::select_data()
+{
+    QTest::addColumn<LocationFilter>("filter");
+
+    LocationFilter filter;
+    QTest::newRow("empty") << filter;
+
+    filter = LocationFilter();
+    filter.wifi = false;
+    QTest::newRow("no wifi") << filter;
+
+    filter = LocationFilter();
+    filter.bluetooth = false;
+    filter.cellular = false;
+    QTest::newRow("wifi only") << filter;
+
+    filter = LocationFilter();
+    filter.wifi = false;
+    filter.bluetooth = false;
+    filter.cellular = false;
+    QTest::newRow("no types") << filter;
+
+    filter = LocationFilter();
+    filter.openOnly = true;
+    QTest::newRow("open only") << filter;
+
+    filter = LocationFilter();
+    filter.encryption = (1 << LocationFilter::Wpa2) | (1 << LocationFilter::Wpa3);
+    QTest::newRow("wpa2 and wpa3") << filter;
+
+    filter = LocationFilter();
+    filter.encryption = 1 << LocationFilter::UnknownEncryption;
+    QTest::newRow("unknown encryption") << filter;
+
+    filter = LocationFilter();
+    filter.encryption = 0;
+    QTest::newRow("no encryption") << filter;
+
+    filter = LocationFilter();
+    filter.minimumTimestamp = 1700000000000 + 2500 * 1000;
+    QTest::newRow("newer than") << filter;
+
+    filter = LocationFilter();
+    filter.maximumTimestamp = 1700000000000 + 2500 * 1000;
+    QTest::newRow("older than") << filter;
+
+    filter = LocationFilter();
+    filter.minimumTimestamp = 1700000000000 + 4000 * 1000;
+    filter.maximumTimestamp = 1700000000000 + 4000 * 1000;
+    QTest::newRow("single timestamp") << filter;
+
+    filter = LocationFilter();
+    filter.minimumSignal = -60;
+    QTest::newRow("stronger than") << filter;
+
+    filter = LocationFilter();
+    filter.minimumSignal = -80;
+    filter.maximumSignal = -70;
+    QTest::newRow("signal band") << filter;
+
+    filter = LocationFilter();
+    filter.minimumSignal = 0;
+    QTest::newRow("signal out of range") << filter;
+
+    filter = LocationFilter();
+    filter.cellular = false;
+    filter.encryption = (1 << LocationFilter::Open) | (1 << LocationFilter::Wep);
+    filter.minimumTimestamp = 1700000000000 + 1000 * 1000;
+    filter.maximumTimestamp = 1700000000000 + 9000 * 1000;
+    filter.minimumSignal = -90;
+    filter.maximumSignal = -50;
+    QTest::newRow("combined") << filter;
+}
+
+void SectorIndexTest::select()
+{
+    QFETCH(LocationFilter, filter);
+
+    SectorIndex index;
+
+    for(LocationDataNode &node : m_nodes)
+        index.append(&node);
+
+    QCOMPARE(index.count(), m_nodes.count());
+
+    QVector<LocationDataNode*> expected;
+
+    for(LocationDataNode &node : m_nodes)
+    {
+        if(filter.accepts(node.data))
+            expected.append(&node);
+    }
+
+    QCOMPARE(index.select(filter), expected);
+
+    //a second select runs on the sorted columns
+    QCOMPARE(index.select(filter), expected);
+}
+
+void SectorIndexTest::appendAfterSelect()
+{
+    SectorIndex index;
+    LocationFilter filter;
+    filter.minimumSignal = -60;
+    filter.bluetooth = false;
+
+    qsizetype half = m_nodes.count() / 2;
+
+    for(qsizetype position = 0; position < half; ++position)
+        index.append(&m_nodes[position]);
+
+    index.select(filter);
+
+    //appends after a select leave the columns unsorted again
+    for(qsizetype position = half; position < m_nodes.count(); ++position)
+        index.append(&m_nodes[position]);
+
+    QVector<LocationDataNode*> expected;
+
+    for(LocationDataNode &node : m_nodes)
+    {
+        if(filter.accepts(node.data))
+            expected.append(&node);
+    }
+
+    QCOMPARE(index.select(filter), expected);
+}
+
+QTEST_GUILESS_MAIN(SectorIndexTest)
+#include "sectorindextest.moc"
@@ -0,0 +1,101 @@
+#include "sectorsnapshot.h"
+
+#include <QTest>
+
+/*
+ * SectorSnapshot, released ranges are reused and the file only grows when nothing fits
+ */
+class SectorSnapshotTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip();
+    void reuseReleased();
+    void mergeNeighbours();
+    void truncateTail();
+};
+
+void SectorSnapshotTest::roundTrip()
+{
+    SectorSnapshot snapshot;
+
+    QByteArray first(100, 'a');
+    QByteArray second(50, 'b');
+
+    qint64 firstOffset = snapshot.write(first);
+    qint64 secondOffset = snapshot.write(second);
+
+    QCOMPARE(firstOffset, 0);
+    QCOMPARE(secondOffset, 100);
+    QCOMPARE(snapshot.read(firstOffset, first.size()), first);
+    QCOMPARE(snapshot.read(secondOffset, second.size()), second);
+    QCOMPARE(snapshot.size(), 150);
+}
+
+void SectorSnapshotTest::reuseReleased()
+{
+    SectorSnapshot snapshot;
+
+    snapshot.write(QByteArray(100, 'a'));
+    snapshot.write(QByteArray(100, 'b'));
+    snapshot.write(QByteArray(100, 'c'));
+
+    //a thawed sector in the middle, then evicted again while the others stay live
+    for(int round = 0; round < 10; ++round)
+    {
+        snapshot.release(100, 100);
+
+        QByteArray block(80, 'd');
+        qint64 offset = snapshot.write(block);
+
+        QCOMPARE(offset, 100);
+        QCOMPARE(snapshot.read(offset, block.size()), block);
+
+        snapshot.release(100, 80);
+        QCOMPARE(snapshot.write(QByteArray(100, 'b')), 100);
+    }
+
+    QCOMPARE(snapshot.fileSize(), 300);
+    QCOMPARE(snapshot.size(), 300);
+}
+
+void SectorSnapshotTest::mergeNeighbours()
+{
+    SectorSnapshot snapshot;
+
+    snapshot.write(QByteArray(100, 'a'));
+    snapshot.write(QByteArray(100, 'b'));
+    snapshot.write(QByteArray(100, 'c'));
+    snapshot.write(QByteArray(100, 'd'));
+
+    //neither range alone fits the new block, together they do
+    snapshot.release(100, 100);
+    snapshot.release(200, 100);
+
+    QCOMPARE(snapshot.write(QByteArray(150, 'e')), 100);
+    QCOMPARE(snapshot.fileSize(), 400);
+}
+
+void SectorSnapshotTest::truncateTail()
+{
+    SectorSnapshot snapshot;
+
+    snapshot.write(QByteArray(100, 'a'));
+    snapshot.write(QByteArray(100, 'b'));
+    snapshot.write(QByteArray(100, 'c'));
+
+    snapshot.release(200, 100);
+    QCOMPARE(snapshot.fileSize(), 200);
+
+    //the range before the end joins the tail once it is released too
+    snapshot.release(100, 100);
+    QCOMPARE(snapshot.fileSize(), 100);
+
+    snapshot.release(0, 100);
+    QCOMPARE(snapshot.fileSize(), 0);
+    QCOMPARE(snapshot.size(), 0);
+}
+
+QTEST_GUILESS_MAIN(SectorSnapshotTest)
+#include "sectorsnapshottest.moc"
@@ -0,0 +1,97 @@
+#include "timestampparser.h"
+
+#include <QTest>
+
+/*
+ * TimestampParser, every accepted form and the inputs it has to turn down
+ *
+ * Each row runs through both overloads, the CSV importer hands over bytes and the KML importer and
+ * the database strings.
+ */
+class TimestampParserTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse_data();
+    void parse();
+};
+
+void TimestampParserTest::parse_data()
+{
+    QTest::addColumn<QString>("value");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<qint64>("msecs");
+
+    //epoch
+    QTest::newRow("ms") << "1748508333123" << true << qint64(1748508333123);
+    QTest::newRow("ms, negative") << "-1748508333123" << true << qint64(-1748508333123);
+    QTest::newRow("seconds") << "1748508333" << true << qint64(1748508333000);
+    QTest::newRow("seconds, fraction") << "1748508333.25" << true << qint64(1748508333250);
+    QTest::newRow("seconds, long fraction") << "1748508333.123456" << true << qint64(1748508333123);
+    QTest::newRow("seconds, negative") << "-1" << true << qint64(-1000);
+    QTest::newRow("zero") << "0" << true << qint64(0);
+    QTest::newRow("surrounding whitespace") << " 1748508333123\r\n" << true << qint64(1748508333123);
+
+    //ISO-8601
+    QTest::newRow("iso") << "2025-05-29T08:45:33" << true << qint64(1748508333000);
+    QTest::newRow("iso, no seconds") << "2025-05-29T08:45" << true << qint64(1748508300000);
+    QTest::newRow("iso, fraction") << "2025-05-29T08:45:33.123" << true << qint64(1748508333123);
+    QTest::newRow("iso, short fraction") << "2025-05-29T08:45:33.1" << true << qint64(1748508333100);
+    QTest::newRow("iso, comma fraction") << "2025-05-29T08:45:33,5" << true << qint64(1748508333500);
+    QTest::newRow("iso, Z") << "2025-05-29T08:45:33Z" << true << qint64(1748508333000);
+    QTest::newRow("iso, offset") << "2025-05-29T08:45:33-07:00" << true << qint64(1748533533000);
+    QTest::newRow("iso, fraction and offset") << "2025-05-29T08:45:33.000-07:00" << true << qint64(1748533533000);
+    QTest::newRow("iso, offset hhmm") << "2025-05-29T08:45:33+0530" << true << qint64(1748488533000);
+    QTest::newRow("iso, offset hh") << "2025-05-29T08:45:33+05" << true << qint64(1748490333000);
+    QTest::newRow("iso, leap day") << "2024-02-29T23:59:59Z" << true << qint64(1709251199000);
+    QTest::newRow("iso, leap second") << "2016-12-31T23:59:60Z" << true << qint64(1483228799000);
+    QTest::newRow("iso, before epoch") << "1969-12-31T23:59:59Z" << true << qint64(-1000);
+
+    //WiGLE CSV
+    QTest::newRow("wigle") << "2025-05-29 08:45:33" << true << qint64(1748508333000);
+
+    //rejected
+    QTest::newRow("empty") << "" << false << qint64(0);
+    QTest::newRow("whitespace") << "  " << false << qint64(0);
+    QTest::newRow("text") << "yesterday" << false << qint64(0);
+    QTest::newRow("text date") << "Thu May 29 08:45:33 2025" << false << qint64(0);
+    QTest::newRow("trailing text") << "1748508333123abc" << false << qint64(0);
+    QTest::newRow("ms with fraction") << "1748508333123.5" << false << qint64(0);
+    QTest::newRow("empty fraction") << "1748508333." << false << qint64(0);
+    QTest::newRow("too many digits") << "1234567890123456789" << false << qint64(0);
+    QTest::newRow("sign only") << "-" << false << qint64(0);
+    QTest::newRow("month 13") << "2025-13-01T00:00:00" << false << qint64(0);
+    QTest::newRow("february 29, no leap year") << "2025-02-29 00:00:00" << false << qint64(0);
+    QTest::newRow("hour 24") << "2025-05-29T24:00:00" << false << qint64(0);
+    QTest::newRow("minute 60") << "2025-05-29T08:60:00" << false << qint64(0);
+    QTest::newRow("no time") << "2025-05-29" << false << qint64(0);
+    QTest::newRow("bad separator") << "2025-05-29X08:45:33" << false << qint64(0);
+    QTest::newRow("empty iso fraction") << "2025-05-29T08:45:33.Z" << false << qint64(0);
+    QTest::newRow("offset hours") << "2025-05-29T08:45:33+24:00" << false << qint64(0);
+    QTest::newRow("offset minutes") << "2025-05-29T08:45:33+05:60" << false << qint64(0);
+    QTest::newRow("trailing iso text") << "2025-05-29T08:45:33 PDT" << false << qint64(0);
+}
+
+void TimestampParserTest::parse()
+{
+    QFETCH(QString, value);
+    QFETCH(bool, valid);
+    QFETCH(qint64, msecs);
+
+    qint64 fromString = 0;
+    QCOMPARE(TimestampParser::parse(QStringView(value), fromString), valid);
+
+    QByteArray bytes = value.toUtf8();
+    qint64 fromBytes = 0;
+    QCOMPARE(TimestampParser::parse(QByteArrayView(bytes), fromBytes), valid);
+
+    if(valid)
+    {
+        QCOMPARE(fromString, msecs);
+        QCOMPARE(fromBytes, msecs);
+    }
+}
+
+QTEST_GUILESS_MAIN(TimestampParserTest)
+#include "timestampparsertest.moc"
@@ -0,0 +1,251 @@
+#include "timestampparser.h"
+
+template<typename Char>
+static inline int digitValue(Char character)
+{
+    return (character >= Char('0') && character <= Char('9')) ? int(character - Char('0')) : -1;
+}
+
+//reads exactly `digits` decimal digits
+template<typename Char>
+static bool readDigits(const Char *&position, const Char *end, int digits, int &value)
+{
+    if(end - position < digits)
+        return false;
+
+    value = 0;
+
+    for(int i = 0; i < digits; ++i)
+    {
+        int digit = digitValue(position[i]);
+
+        if(digit < 0)
+            return false;
+
+        value = (value * 10) + digit;
+    }
+
+    position += digits;
+    return true;
+}
+
+template<typename Char>
+static bool expect(const Char *&position, const Char *end, char character)
+{
+    if(position == end || *position != Char(character))
+        return false;
+
+    ++position;
+    return true;
+}
+
+static bool isLeapYear(int year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static int daysInMonth(int year, int month)
+{
+    static const int days[12] { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+    if(month == 2 && isLeapYear(year))
+        return 29;
+
+    return days[month - 1];
+}
+
+//days since 1970-01-01 for a proleptic gregorian date
+static qint64 daysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+
+    const qint64 era = (year >= 0 ? year : year - 399) / 400;
+    const qint64 yearOfEra = year - (era * 400);
+    const qint64 dayOfYear = ((153 * (month + (month > 2 ? -3 : 9))) + 2) / 5 + day - 1;
+    const qint64 dayOfEra = (yearOfEra * 365) + (yearOfEra / 4) - (yearOfEra / 100) + dayOfYear;
+
+    return (era * 146097) + dayOfEra - 719468;
+}
+
+//reads a fraction of any length after the separator, only ms precision is kept
+template<typename Char>
+static bool readFraction(const Char *&position, const Char *end, int &millisecond)
+{
+    int digits = 0;
+    millisecond = 0;
+
+    for(; position != end && digitValue(*position) >= 0; ++position, ++digits)
+    {
+        if(digits < 3)
+            millisecond = (millisecond * 10) + digitValue(*position);
+    }
+
+    for(int scaled = digits; scaled < 3; ++scaled)
+        millisecond *= 10;
+
+    return digits > 0;
+}
+
+//seconds until the year 5138 have at most 11 digits, ms after 1973 at least 12
+static constexpr int EpochSecondsDigits = 11;
+
+template<typename Char>
+static bool parseEpoch(const Char *position, const Char *end, qint64 &msecs)
+{
+    bool negative = false;
+
+    if(*position == Char('-'))
+    {
+        negative = true;
+        ++position;
+    }
+
+    qint64 value = 0;
+    int digits = 0;
+
+    for(; position != end && digitValue(*position) >= 0; ++position)
+    {
+        //more than 18 digits would overflow and is no timestamp anyway
+        if(++digits > 18)
+            return false;
+
+        value = (value * 10) + digitValue(*position);
+    }
+
+    if(digits == 0)
+        return false;
+
+    if(digits <= EpochSecondsDigits)
+    {
+        int millisecond = 0;
+
+        if(position != end && *position == Char('.'))
+        {
+            ++position;
+
+            if(!readFraction(position, end, millisecond))
+                return false;
+        }
+
+        value = (value * 1000) + millisecond;
+    }
+
+    if(position != end)
+        return false;
+
+    msecs = negative ? -value : value;
+    return true;
+}
+
+template<typename Char>
+static bool parseDateTime(const Char *position, const Char *end, qint64 &msecs)
+{
+    int year, month, day, hour, minute, second = 0, millisecond = 0, offsetMinutes = 0;
+
+    if(!readDigits(position, end, 4, year) || !expect(position, end, '-') ||
+       !readDigits(position, end, 2, month) || !expect(position, end, '-') ||
+       !readDigits(position, end, 2, day))
+        return false;
+
+    //ISO uses T, WiGLE CSVs use a space
+    if(position == end || (*position != Char('T') && *position != Char('t') && *position != Char(' ')))
+        return false;
+
+    ++position;
+
+    if(!readDigits(position, end, 2, hour) || !expect(position, end, ':') || !readDigits(position, end, 2, minute))
+        return false;
+
+    if(position != end && *position == Char(':'))
+    {
+        ++position;
+
+        if(!readDigits(position, end, 2, second))
+            return false;
+
+        if(position != end && (*position == Char('.') || *position == Char(',')))
+        {
+            ++position;
+
+            if(!readFraction(position, end, millisecond))
+                return false;
+        }
+    }
+
+    if(position != end)
+    {
+        if(*position == Char('Z') || *position == Char('z'))
+            ++position;
+
+        else if(*position == Char('+') || *position == Char('-'))
+        {
+            int sign = (*position == Char('-')) ? -1 : 1;
+            int offsetHours, offsetMinute = 0;
+
+            ++position;
+
+            if(!readDigits(position, end, 2, offsetHours))
+                return false;
+
+            if(position != end && *position == Char(':'))
+                ++position;
+
+            if(position != end && !readDigits(position, end, 2, offsetMinute))
+                return false;
+
+            if(offsetHours > 23 || offsetMinute > 59)
+                return false;
+
+            offsetMinutes = sign * ((offsetHours * 60) + offsetMinute);
+        }
+    }
+
+    if(position != end)
+        return false;
+
+    if(month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month))
+        return false;
+
+    //leap seconds are folded into the preceding second
+    if(hour > 23 || minute > 59 || second > 60)
+        return false;
+
+    if(second == 60)
+        second = 59;
+
+    qint64 seconds = (daysFromCivil(year, month, day) * 86400) + (hour * 3600) + (minute * 60) + second;
+    seconds -= offsetMinutes * 60;
+
+    msecs = (seconds * 1000) + millisecond;
+    return true;
+}
+
+template<typename Char>
+static bool parseTimestamp(const Char *begin, const Char *end, qint64 &msecs)
+{
+    //trim surrounding whitespace, including the line ending of the last CSV column
+    while(begin != end && (*begin == Char(' ') || *begin == Char('\t')))
+        ++begin;
+
+    while(end != begin && (end[-1] == Char(' ') || end[-1] == Char('\t') || end[-1] == Char('\r') || end[-1] == Char('\n')))
+        --end;
+
+    if(begin == end)
+        return false;
+
+    //a date always has its first separator at index 4
+    if(end - begin > 4 && begin[4] == Char('-'))
+        return parseDateTime(begin, end, msecs);
+
+    return parseEpoch(begin, end, msecs);
+}
+
+bool TimestampParser::parse(QByteArrayView value, qint64 &msecs)
+{
+    return parseTimestamp(value.data(), value.data() + value.size(), msecs);
+}
+
+bool TimestampParser::parse(QStringView value, qint64 &msecs)
+{
+    return parseTimestamp(value.utf16(), value.utf16() + value.size(), msecs);
+}
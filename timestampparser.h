@@ -0,0 +1,29 @@
+#ifndef TIMESTAMPPARSER_H
+#define TIMESTAMPPARSER_H
+
+#include <QByteArrayView>
+#include <QStringView>
+#include <QtGlobal>
+
+/*
+ * Timestamp parsing for imports
+ *
+ * Converts the timestamp formats found in WiGLE exports straight into ms since epoch without building
+ * a QDateTime. Accepted forms are
+ *
+ *   1748533533000                      ms since epoch, 12 digits or more
+ *   1748533533 or 1748533533.25        seconds since epoch, up to 11 digits
+ *   2025-05-29T08:45:33                ISO-8601
+ *   2025-05-29T08:45:33.000-07:00      ISO-8601 with fraction and offset (Z, +hh, +hhmm or +hh:mm)
+ *   2025-05-29 08:45:33                WiGLE CSV
+ *
+ * Timestamps without an offset are taken as UTC, which is what WiGLE writes.
+ */
+class TimestampParser
+{
+public:
+    static bool parse(QByteArrayView value, qint64 &msecs);
+    static bool parse(QStringView value, qint64 &msecs);
+};
+
+#endif // TIMESTAMPPARSER_H
@@ -0,0 +1,153 @@
+#include "syntheticdataset.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QTimeZone>
+
+/*
+ * wdrvr_gen, synthetic WiGLE datasets for scale testing
+ *
+ *   wdrvr_gen --size 100000000 --csv drive.csv
+ *   wdrvr_gen --seed 7 --mix WIFI=50,LTE=50 --kml drive.kml --db synthetic
+ *
+ * Every output gets the same rows, a name without a path for --db creates the database where wdrvr
+ * looks for it. Rows are generated while they are written, memory use doesn't grow with the size.
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName("digitalartifex.com");
+    app.setApplicationName("wdrvr");
+
+    SyntheticDataset::Options defaults;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Deterministic synthetic WiGLE dataset generator");
+    parser.addHelpOption();
+
+    QCommandLineOption sizeOption({ "n", "size" }, "Number of rows.", "rows", QString::number(defaults.size));
+    QCommandLineOption seedOption({ "s", "seed" }, "Random seed, the same seed gives the same rows.", "seed", QString::number(defaults.seed));
+    QCommandLineOption clustersOption("clusters", "Number of urban clusters.", "count", QString::number(defaults.clusters));
+    QCommandLineOption radiusOption("cluster-radius", "Spread of a cluster in km.", "km", QString::number(defaults.clusterRadius));
+    QCommandLineOption ruralOption("rural", "Share of devices between clusters, 0 to 1.", "rate", QString::number(defaults.ruralRate));
+    QCommandLineOption mixOption("mix", "Type weights.", "types", "WIFI=70,BT=8,BLE=10,GSM=3,LTE=7,NR=2");
+    QCommandLineOption duplicatesOption("duplicates", "Share of rows repeating an earlier device, 0 to 1.", "rate", QString::number(defaults.duplicateRate));
+    QCommandLineOption startOption("start", "ISO-8601 time of the first row.", "time", QDateTime::fromMSecsSinceEpoch(defaults.startTime, QTimeZone::UTC).toString(Qt::ISODate));
+    QCommandLineOption spreadOption("spread", "Hours between the first and the last row.", "hours", QString::number(defaults.timeSpread / 3600000));
+    QCommandLineOption csvOption("csv", "Write a WiGLE CSV file.", "file");
+    QCommandLineOption kmlOption("kml", "Write a WiGLE KML file.", "file");
+    QCommandLineOption databaseOption("db", "Write a database, a name or a .db file.", "name");
+
+    parser.addOptions({ sizeOption, seedOption, clustersOption, radiusOption, ruralOption, mixOption, duplicatesOption, startOption, spreadOption, csvOption, kmlOption, databaseOption });
+    parser.process(app);
+
+    QTextStream err(stderr);
+    SyntheticDataset::Options options;
+    bool valid = true;
+
+    auto number = [&parser, &err, &valid](const QCommandLineOption &option, double minimum, double maximum) {
+        bool ok = false;
+        double value = parser.value(option).toDouble(&ok);
+
+        if(!ok || value < minimum || value > maximum)
+        {
+            err << "Invalid value for --" << option.names().last() << Qt::endl;
+            valid = false;
+        }
+
+        return value;
+    };
+
+    options.size = static_cast<quint64>(number(sizeOption, 0, 1e15));
+    options.seed = static_cast<quint32>(number(seedOption, 0, 4294967295.0));
+    options.clusters = static_cast<int>(number(clustersOption, 1, 10000));
+    options.clusterRadius = number(radiusOption, 0, 1000);
+    options.ruralRate = number(ruralOption, 0, 1);
+    options.duplicateRate = number(duplicatesOption, 0, 1);
+    options.timeSpread = static_cast<qint64>(number(spreadOption, 0, 1e6) * 3600000);
+
+    QDateTime start = QDateTime::fromString(parser.value(startOption), Qt::ISODate);
+
+    if(start.isValid())
+        options.startTime = start.toMSecsSinceEpoch();
+    else
+    {
+        err << "Invalid value for --start" << Qt::endl;
+        valid = false;
+    }
+
+    if(!SyntheticDataset::parseTypeMix(parser.value(mixOption), options.typeMix))
+    {
+        err << "Invalid value for --mix, expected TYPE=weight pairs of WIFI, BT, BLE, GSM, LTE and NR" << Qt::endl;
+        valid = false;
+    }
+
+    if(!parser.isSet(csvOption) && !parser.isSet(kmlOption) && !parser.isSet(databaseOption))
+    {
+        err << "Nothing to write, use --csv, --kml or --db" << Qt::endl;
+        valid = false;
+    }
+
+    if(!valid)
+        return 1;
+
+    auto progress = [&err, &options](quint64 rows) {
+        err << "\r" << rows << " / " << options.size << " rows" << Qt::flush;
+    };
+
+    auto writeFile = [&](const QString &fileName, bool kml) {
+        SyntheticDataset dataset(options);
+        QFile file(fileName);
+
+        if(!file.open(QFile::WriteOnly | QFile::Truncate))
+        {
+            err << "Could not open " << fileName << ": " << file.errorString() << Qt::endl;
+            return false;
+        }
+
+        err << "Writing " << fileName << Qt::endl;
+        bool written = kml ? dataset.writeKml(&file, progress) : dataset.writeCsv(&file, progress);
+        err << Qt::endl;
+
+        if(!written)
+            err << "Could not write " << fileName << ": " << file.errorString() << Qt::endl;
+
+        return written;
+    };
+
+    if(parser.isSet(csvOption) && !writeFile(parser.value(csvOption), false))
+        return 1;
+
+    if(parser.isSet(kmlOption) && !writeFile(parser.value(kmlOption), true))
+        return 1;
+
+    if(parser.isSet(databaseOption))
+    {
+        QString fileName = parser.value(databaseOption);
+
+        //a bare name goes where wdrvr keeps its databases
+        if(!fileName.endsWith(".db", Qt::CaseInsensitive))
+        {
+            QDir directory(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QDir::separator() + fileName);
+            directory.mkpath(directory.absolutePath());
+            fileName = directory.absoluteFilePath(fileName + ".db");
+        }
+
+        QFile::remove(fileName);
+
+        err << "Writing " << fileName << Qt::endl;
+        SyntheticDataset dataset(options);
+        bool written = dataset.writeDatabase(fileName, progress);
+        err << Qt::endl;
+
+        if(!written)
+            return 1;
+    }
+
+    return 0;
+}
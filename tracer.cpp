@@ -0,0 +1,193 @@
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+QAtomicInt Tracer::s_enabled = 0;
+QAtomicInteger<qint64> Tracer::s_clearedAt = 0;
+QMutex Tracer::s_buffersMutex;
+QList<Tracer::Buffer*> Tracer::s_buffers;
+QList<Tracer::Buffer*> Tracer::s_freeBuffers;
+
+void Tracer::setEnabled(bool enabled)
+{
+    s_enabled.storeRelaxed(enabled ? 1 : 0);
+}
+
+qint64 Tracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Tracer::BufferOwner::~BufferOwner()
+{
+    if(!buffer)
+        return;
+
+    QMutexLocker locker(&s_buffersMutex);
+    s_freeBuffers.append(buffer);
+}
+
+Tracer::Buffer *Tracer::buffer()
+{
+    thread_local BufferOwner owner;
+
+    if(owner.buffer)
+        return owner.buffer;
+
+    QMutexLocker locker(&s_buffersMutex);
+
+    if(!s_freeBuffers.isEmpty())
+    {
+        owner.buffer = s_freeBuffers.takeLast();
+        return owner.buffer;
+    }
+
+    Buffer *threadBuffer = new Buffer;
+    QThread *thread = QThread::currentThread();
+
+    threadBuffer->thread = s_buffers.count() + 1;
+
+    if(QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+        threadBuffer->threadName = "Main";
+    else if(!thread->objectName().isEmpty())
+        threadBuffer->threadName = QString("%1 %2").arg(thread->objectName()).arg(threadBuffer->thread);
+    else
+        threadBuffer->threadName = QString("Worker %1").arg(threadBuffer->thread);
+
+    s_buffers.append(threadBuffer);
+    owner.buffer = threadBuffer;
+
+    return threadBuffer;
+}
+
+void Tracer::record(const char *name, const char *category, qint64 start, qint64 end, qint64 count)
+{
+    Buffer *target = buffer();
+    quint64 head = target->head.loadRelaxed();
+
+    Event &event = target->events[head % BufferSize];
+    event.name = name;
+    event.category = category;
+    event.start = start;
+    event.end = end;
+    event.count = count;
+
+    //publishes the event to dump()
+    target->head.storeRelease(head + 1);
+}
+
+//buffers are written without a lock, so clearing moves the start of the trace instead of the heads
+void Tracer::clear()
+{
+    s_clearedAt.storeRelaxed(now());
+}
+
+bool Tracer::dump(const QString &fileName)
+{
+    QFile file(fileName);
+
+    if(!file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        qDebug() << "Could not write trace" << fileName << file.errorString();
+        return false;
+    }
+
+    QList<Buffer*> buffers;
+
+    {
+        QMutexLocker locker(&s_buffersMutex);
+        buffers = s_buffers;
+    }
+
+    qint64 clearedAt = s_clearedAt.loadRelaxed();
+    qint64 origin = std::numeric_limits<qint64>::max();
+
+    //copy first so timestamps can be made relative to the earliest span
+    QVector<QPair<const Buffer*, QVector<Event>>> copies;
+
+    for(const Buffer *source : std::as_const(buffers))
+    {
+        quint64 head = source->head.loadAcquire();
+        quint64 first = head > BufferSize ? head - BufferSize : 0;
+
+        QVector<Event> events;
+        events.reserve(head - first);
+
+        for(quint64 index = first; index < head; ++index)
+            events.append(source->events[index % BufferSize]);
+
+        //anything the thread wrapped over while copying is torn
+        quint64 overwritten = source->head.loadAcquire();
+        quint64 valid = overwritten > BufferSize ? overwritten - BufferSize : 0;
+
+        if(valid > first)
+            events.remove(0, std::min<qsizetype>(valid - first, events.count()));
+
+        events.removeIf([clearedAt](const Event &event) {
+            return event.start < clearedAt;
+        });
+
+        for(const Event &event : std::as_const(events))
+            origin = std::min(origin, event.start);
+
+        copies.append(qMakePair(source, events));
+    }
+
+    QByteArray buffer = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool separator = false;
+    quint64 written = 0;
+
+    auto append = [&buffer, &separator](const QByteArray &event) {
+        if(separator)
+            buffer += ",\n";
+
+        buffer += event;
+        separator = true;
+    };
+
+    for(const QPair<const Buffer*, QVector<Event>> &copy : std::as_const(copies))
+    {
+        QString threadName = copy.first->threadName;
+        threadName.replace('\\', "\\\\");
+        threadName.replace('"', "\\\"");
+
+        append(QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"%2\"}}").arg(copy.first->thread).arg(threadName).toUtf8());
+
+        for(const Event &event : copy.second)
+        {
+            //chrome wants microseconds
+            QByteArray line = "{\"name\":\"" + QByteArray(event.name) + "\",\"cat\":\"" + QByteArray(event.category) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+            line += QByteArray::number(copy.first->thread) + ",\"ts\":" + QByteArray::number((event.start - origin) / 1000.0, 'f', 3);
+            line += ",\"dur\":" + QByteArray::number((event.end - event.start) / 1000.0, 'f', 3);
+
+            if(event.count >= 0)
+                line += ",\"args\":{\"count\":" + QByteArray::number(event.count) + '}';
+
+            append(line + '}');
+            ++written;
+
+            if(buffer.size() > (1 << 20))
+            {
+                file.write(buffer);
+                buffer.clear();
+            }
+        }
+    }
+
+    buffer += "\n]}\n";
+
+    bool success = file.write(buffer) >= 0;
+    file.close();
+
+    qDebug() << "Wrote" << written << "trace spans to" << fileName;
+
+    return success;
+}
@@ -0,0 +1,127 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QAtomicInteger>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+/*
+ * Span tracing
+ *
+ * Spans go into a ring buffer per thread. Only the owning thread writes its buffer, so recording
+ * takes no lock, and each buffer keeps the latest BufferSize spans of its thread. A dump copies the
+ * buffers and writes the Chrome trace event format, which chrome://tracing and ui.perfetto.dev open
+ * as is.
+ *
+ * While tracing is off a span costs one relaxed load. Names and categories must be string literals,
+ * only the pointers are kept.
+ */
+class Tracer
+{
+public:
+    static constexpr int BufferSize = 1 << 16; //spans per thread
+
+    static bool enabled() { return s_enabled.loadRelaxed(); }
+    static void setEnabled(bool enabled);
+
+    //ns on a monotonic clock
+    static qint64 now();
+
+    //count is shown as an argument of the span, negative leaves it out
+    static void record(const char *name, const char *category, qint64 start, qint64 end, qint64 count = -1);
+
+    //forgets everything recorded so far
+    static void clear();
+
+    //writes the buffers as Chrome trace JSON, false if the file couldn't be written
+    static bool dump(const QString &fileName);
+
+private:
+    struct Event
+    {
+        const char *name = nullptr;
+        const char *category = nullptr;
+        qint64 start = 0;
+        qint64 end = 0;
+        qint64 count = -1;
+    };
+
+    struct Buffer
+    {
+        int thread = 0;
+        QString threadName;
+        QAtomicInteger<quint64> head = 0; //events ever written, the next slot is head % BufferSize
+        Event events[BufferSize];
+    };
+
+    //hands the thread's buffer back when the thread finishes
+    struct BufferOwner
+    {
+        Buffer *buffer = nullptr;
+
+        ~BufferOwner();
+    };
+
+    static Buffer *buffer();
+
+    static QAtomicInt s_enabled;
+    static QAtomicInteger<qint64> s_clearedAt;
+
+    //buffers outlive their threads so a dump still sees finished workers. Pool threads expire and get
+    //recreated all the time, so a new thread takes over the buffer of a finished one and its track
+    static QMutex s_buffersMutex;
+    static QList<Buffer*> s_buffers;
+    static QList<Buffer*> s_freeBuffers;
+};
+
+/*
+ * Scoped span, recorded when it goes out of scope
+ *
+ * restart() records what has been measured so far and starts the next span under the same name, for
+ * loops that want a span per chunk without a new scope. end() records it early.
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(const char *name, const char *category)
+        : m_name(name), m_category(category), m_start(Tracer::enabled() ? Tracer::now() : -1)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        end();
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    void setCount(qint64 count)
+    {
+        m_count = count;
+    }
+
+    void restart()
+    {
+        end();
+        m_start = Tracer::enabled() ? Tracer::now() : -1;
+        m_count = -1;
+    }
+
+    void end()
+    {
+        if(m_start >= 0)
+            Tracer::record(m_name, m_category, m_start, Tracer::now(), m_count);
+
+        m_start = -1;
+    }
+
+private:
+    const char *m_name;
+    const char *m_category;
+    qint64 m_start;
+    qint64 m_count = -1;
+};
+
+#endif // TRACER_H
@@ -0,0 +1,143 @@
+#include "trigramindex.h"
+#include "locationmodel.h"
+
+#include <QSet>
+
+#include <algorithm>
+
+quint64 TrigramIndex::trigram(const QString &folded, qsizetype position)
+{
+    return (static_cast<quint64>(folded[position].unicode()) << 32) | (static_cast<quint64>(folded[position + 1].unicode()) << 16) | folded[position + 2].unicode();
+}
+
+int TrigramIndex::rank(const Document &document, const QString &query)
+{
+    qsizetype position = document.name.indexOf(query, 0, Qt::CaseInsensitive);
+
+    if(position < 0)
+        return document.mfgid.contains(query, Qt::CaseInsensitive) ? ManufacturerMatch : -1;
+
+    if(position == 0)
+        return document.name.size() == query.size() ? ExactMatch : PrefixMatch;
+
+    //any later occurrence may still start a word
+    for(; position > 0; position = document.name.indexOf(query, position + 1, Qt::CaseInsensitive))
+    {
+        if(!document.name[position - 1].isLetterOrNumber())
+            return WordMatch;
+    }
+
+    return NameMatch;
+}
+
+void TrigramIndex::append(const LocationData &data)
+{
+    QSet<quint64> trigrams;
+
+    for(const QString &field : { data.name, data.mfgid })
+    {
+        QString folded = field.toCaseFolded();
+
+        for(qsizetype position = 0; position + 2 < folded.size(); ++position)
+            trigrams.insert(trigram(folded, position));
+    }
+
+    QWriteLocker locker(&m_lock);
+
+    quint32 id = static_cast<quint32>(m_documents.count());
+    m_documents.append({ data.id, data.name, data.mfgid, data.type, data.coordinates });
+
+    for(quint64 key : std::as_const(trigrams))
+        m_postings[key].add(id);
+}
+
+void TrigramIndex::clear()
+{
+    QWriteLocker locker(&m_lock);
+
+    m_documents.clear();
+    m_postings.clear();
+}
+
+qsizetype TrigramIndex::count() const
+{
+    QReadLocker locker(&m_lock);
+    return m_documents.count();
+}
+
+QList<SearchMatch> TrigramIndex::search(const QString &query, int limit) const
+{
+    QList<SearchMatch> matches;
+    QString needle = query.trimmed();
+
+    if(needle.isEmpty() || limit <= 0)
+        return matches;
+
+    QString folded = needle.toCaseFolded();
+
+    QReadLocker locker(&m_lock);
+
+    auto verify = [this, &needle, &matches](quint32 id) {
+        if(matches.count() >= MaximumCandidates)
+            return;
+
+        const Document &document = m_documents[id];
+        int documentRank = rank(document, needle);
+
+        if(documentRank >= 0)
+            matches.append({ document.id, document.name, document.mfgid, document.type, document.coordinates, documentRank });
+    };
+
+    if(folded.size() < 3)
+    {
+        for(quint32 id = 0; id < static_cast<quint32>(m_documents.count()) && matches.count() < MaximumCandidates; ++id)
+            verify(id);
+    }
+    else
+    {
+        //cardinality, posting
+        QVector<QPair<quint64, const RoaringBitmap*>> postings;
+
+        for(qsizetype position = 0; position + 2 < folded.size(); ++position)
+        {
+            auto posting = m_postings.constFind(trigram(folded, position));
+
+            //a trigram nobody has rules out every document
+            if(posting == m_postings.constEnd())
+                return matches;
+
+            postings.append(qMakePair(posting->cardinality(), &posting.value()));
+        }
+
+        //intersect the rarest first so the running result stays small
+        std::sort(postings.begin(), postings.end());
+        postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+
+        RoaringBitmap candidates = *postings.first().second;
+
+        for(qsizetype index = 1; index < postings.count() && !candidates.isEmpty(); ++index)
+            candidates = candidates & *postings[index].second;
+
+        candidates.forEach(verify);
+    }
+
+    locker.unlock();
+
+    auto better = [](const SearchMatch &a, const SearchMatch &b) {
+        if(a.rank != b.rank)
+            return a.rank < b.rank;
+        if(a.name.size() != b.name.size())
+            return a.name.size() < b.name.size();
+        return a.name < b.name;
+    };
+
+    if(matches.count() > limit)
+    {
+        std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), better);
+        matches.resize(limit);
+    }
+    else
+        std::sort(matches.begin(), matches.end(), better);
+
+    return matches;
+}
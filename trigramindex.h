@@ -0,0 +1,75 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QGeoCoordinate>
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+#include "roaringbitmap.h"
+
+struct LocationData;
+
+struct SearchMatch
+{
+    QString id;
+    QString name;
+    QString mfgid;
+    QString type;
+    QGeoCoordinate coordinates;
+    int rank = 0; //lower is better
+};
+
+/*
+ * Trigram index over POI names
+ *
+ * Every POI becomes a document holding its name and manufacturer id, and every case folded three
+ * character window of either points back to the document through a compressed posting bitmap.
+ * Document ids only grow, so postings take the ascending append fast path.
+ *
+ * A substring query ANDs the postings of its own trigrams, smallest first, then verifies the
+ * survivors against the real strings. Queries shorter than a trigram fall back to a scan.
+ */
+class TrigramIndex
+{
+public:
+    enum Rank
+    {
+        ExactMatch = 0,
+        PrefixMatch,
+        WordMatch,
+        NameMatch,
+        ManufacturerMatch
+    };
+
+    //verified matches considered for ranking, bounds queries like "the"
+    static constexpr int MaximumCandidates = 100000;
+
+    void append(const LocationData &data);
+    void clear();
+    qsizetype count() const;
+
+    //best matches first
+    QList<SearchMatch> search(const QString &query, int limit) const;
+
+private:
+    struct Document
+    {
+        QString id;
+        QString name;
+        QString mfgid;
+        QString type;
+        QGeoCoordinate coordinates;
+    };
+
+    static quint64 trigram(const QString &folded, qsizetype position);
+    static int rank(const Document &document, const QString &query);
+
+    mutable QReadWriteLock m_lock;
+    QVector<Document> m_documents;
+    QHash<quint64, RoaringBitmap> m_postings;
+};
+
+#endif // TRIGRAMINDEX_H
@@ -0,0 +1,380 @@
+#include "wigleparser.h"
+#include "fieldparser.h"
+#include "locationmodel.h"
+#include "timestampparser.h"
+#include "tracer.h"
+
+#include <QDebug>
+#include <QRegularExpression>
+#include <QXmlStreamReader>
+
+static void widen(WigleParser::Result &result, qint64 timestamp)
+{
+    if(result.first == 0 || timestamp < result.first)
+        result.first = timestamp;
+    if(result.last == 0 || timestamp > result.last)
+        result.last = timestamp;
+}
+
+WigleParser::Format WigleParser::format(const QString &fileName)
+{
+    if(fileName.endsWith(".kml", Qt::CaseInsensitive))
+        return Kml;
+    else if(fileName.endsWith(".csv", Qt::CaseInsensitive))
+        return Csv;
+
+    return Unknown;
+}
+
+WigleParser::Result WigleParser::parse(QIODevice *device, Format format, const Sink &sink)
+{
+    switch(format)
+    {
+    case Csv:
+        return parseCsv(device, sink);
+    case Kml:
+        return parseKml(device, sink);
+    case Unknown:
+        break;
+    }
+
+    Result result;
+    result.error = "Unsupported file type";
+
+    return result;
+}
+
+WigleParser::Result WigleParser::parseCsv(QIODevice *device, const Sink &sink)
+{
+    TraceSpan span("parseCSV", "import");
+    Result result;
+
+    //per column parse failures, reported once the file is done
+    static const char *columnNames[14] {
+        "MAC", "SSID", "AuthMode", "FirstSeen", "Channel", "Frequency", "RSSI",
+        "CurrentLatitude", "CurrentLongitude", "AltitudeMeters", "AccuracyMeters", "RCOIs", "MfgrId", "Type"
+    };
+    quint64 fieldErrors[14] {};
+
+    //optional numeric fields fall back to 0, but the failure is still counted
+    auto parseDouble = [&fieldErrors](QByteArrayView field, int column) {
+        double value = 0;
+        FieldParser::Error error = FieldParser::toDouble(field, value);
+
+        if(error != FieldParser::NoError)
+        {
+            if(error != FieldParser::EmptyField)
+                ++fieldErrors[column];
+
+            value = 0;
+        }
+
+        return value;
+    };
+
+    TraceSpan chunk("csv chunk", "import");
+    quint64 chunkRows = 0;
+
+    while(!device->atEnd())
+    {
+        QByteArray line = device->readLine();
+
+        //pre-header and header information not currently being used
+        if(qstrnicmp(line.constData(), "wigle", 5) == 0 || qstrnicmp(line.constData(), "mac,ssid", 8) == 0)
+            continue;
+
+        QByteArrayView lineView(line);
+
+        while(!lineView.isEmpty() && (lineView.back() == '\n' || lineView.back() == '\r'))
+            lineView.chop(1);
+
+        //split in place, one extra slot to detect rows with too many columns
+        QByteArrayView segments[15];
+        qsizetype segmentCount = 0;
+        qsizetype segmentStart = 0;
+
+        for(qsizetype i = 0; i <= lineView.size() && segmentCount < 15; ++i)
+        {
+            if(i == lineView.size() || lineView[i] == ',')
+            {
+                segments[segmentCount++] = lineView.sliced(segmentStart, i - segmentStart);
+                segmentStart = i + 1;
+            }
+        }
+
+        if(segmentCount != 14)
+            continue;
+
+        double latitude = 0;
+        double longitude = 0;
+
+        FieldParser::Error latitudeError = FieldParser::toDouble(segments[7], latitude);
+        FieldParser::Error longitudeError = FieldParser::toDouble(segments[8], longitude);
+
+        //a POI without a position is useless
+        if(latitudeError != FieldParser::NoError || longitudeError != FieldParser::NoError)
+        {
+            if(latitudeError != FieldParser::NoError)
+                ++fieldErrors[7];
+            if(longitudeError != FieldParser::NoError)
+                ++fieldErrors[8];
+
+            ++result.skipped;
+            continue;
+        }
+
+        int channel = 0;
+        FieldParser::Error channelError = FieldParser::toInt(segments[4], channel);
+
+        if(channelError != FieldParser::NoError && channelError != FieldParser::EmptyField)
+            ++fieldErrors[4];
+
+        QString capabilitiesString = QString::fromUtf8(segments[2]);
+        capabilitiesString.replace("][", " ");
+        capabilitiesString.remove("[");
+        capabilitiesString.remove("]");
+
+        QStringList capabilities = capabilitiesString.split(' ', Qt::SkipEmptyParts);
+        qint64 timestamp = 0;
+
+        if(!TimestampParser::parse(segments[3], timestamp)) //well crap
+        {
+            result.error = "Document uses an invalid timestamp format. Aborting.";
+            break;
+        }
+
+        LocationData data {
+            parseDouble(segments[10], 10),
+            QGeoCoordinate(latitude, longitude, parseDouble(segments[9], 9)),
+            "",
+            QString::fromUtf8(segments[2]),
+            QString::fromUtf8(segments[0]),
+            QString::fromUtf8(segments[1]),
+            channel,
+            parseDouble(segments[6], 6),
+            "", //don't know how wigle calculates style tags
+            QString::fromUtf8(segments[13]),
+            timestamp,
+            QString::fromUtf8(segments[12]),
+            parseDouble(segments[5], 5),
+            capabilities,
+            QString::fromUtf8(segments[11]).split(' ', Qt::SkipEmptyParts)
+        };
+
+        widen(result, data.timestamp);
+        ++result.rows;
+
+        if(!sink(data, device->pos()))
+            break;
+
+        if(++chunkRows == TraceChunkRows)
+        {
+            chunk.setCount(chunkRows);
+            chunk.restart();
+            chunkRows = 0;
+        }
+    }
+
+    chunk.setCount(chunkRows);
+    chunk.end();
+    span.setCount(result.rows);
+
+    for(int column = 0; column < 14; ++column)
+    {
+        if(fieldErrors[column])
+            qDebug() << "Column" << columnNames[column] << "failed to parse in" << fieldErrors[column] << "rows";
+    }
+
+    if(result.skipped)
+        qDebug() << "Skipped" << result.skipped << "rows without a valid position";
+
+    return result;
+}
+
+WigleParser::Result WigleParser::parseKml(QIODevice *device, const Sink &sink)
+{
+    TraceSpan span("parseKML", "import");
+    Result result;
+
+    static const QRegularExpression descriptionSeparator("(?<!:)\\s");
+
+    QXmlStreamReader xml(device);
+    quint64 fieldErrors = 0;
+    bool stopped = false;
+
+    TraceSpan chunk("kml chunk", "import");
+    quint64 chunkRows = 0;
+
+    while(!xml.atEnd() && !stopped && result.error.isEmpty())
+    {
+        xml.readNextStartElement();
+        QString elementName = xml.name().toString().toLower();
+        if(elementName == "placemark")
+        {
+            LocationData data;
+
+            bool placemark = true;
+            while(placemark && !xml.atEnd())
+            {
+                //read by element type to catch the end of the placemark
+                xml.readNext();
+                elementName = xml.name().toString().toLower();
+
+                if(xml.isEndElement() && elementName == "placemark")
+                {
+                    placemark = false;
+                    continue;
+                }
+                else if(!xml.isStartElement())
+                    continue;
+
+                QString markerAttribute = xml.name().toString().toLower();
+
+                if(markerAttribute == "name")
+                    data.name = xml.readElementText();
+
+                else if(markerAttribute == "description")
+                {
+                    QString description = xml.readElementText();
+                    QString descriptionValue = description;
+
+                    //remove newlines, they are not a reliable separator for this block
+                    description.replace('\n', ' ');
+                    QStringList lines = description.split(descriptionSeparator);
+
+                    for(const QString &line : std::as_const(lines))
+                    {
+                        QStringList descriptorParts = line.split(QString(": "), Qt::SkipEmptyParts);
+
+                        if(descriptorParts.count() > 1)
+                        {
+                            QString key = descriptorParts.takeAt(0).toLower();
+                            QString value = descriptorParts.join(':');
+
+                            if(key == "type")
+                                data.type = value;
+                            else if(key == "encryption")
+                                data.encryption = value;
+                            else if(key == "capabilities")
+                            {
+                                QString capabilitiesString = value;
+                                capabilitiesString.remove("[");
+                                capabilitiesString.remove("]");
+
+                                data.capabilities = capabilitiesString.split("][", Qt::SkipEmptyParts);
+                            }
+                            else if(key == "frequency")
+                            {
+                                if(FieldParser::toDouble(QStringView(value), data.frequency) != FieldParser::NoError)
+                                    ++fieldErrors;
+                            }
+                            else if(key == "time")//"2025-05-29T08:45:33.000-07:00" OR MS Since Epoch
+                            {
+                                if(!TimestampParser::parse(QStringView(value), data.timestamp)) //well crap
+                                    result.error = "Document uses an invalid timestamp format. Aborting.";
+                            }
+                            else if(key == "signal")
+                            {
+                                if(FieldParser::toDouble(QStringView(value), data.signal) != FieldParser::NoError)
+                                    ++fieldErrors;
+                            }
+                            else if(key == "network id" || key == "id")
+                                data.id = value;
+                        }
+                    }
+
+                    data.description = descriptionValue;
+                }
+
+                else if(markerAttribute == "styleurl")
+                    data.styleTag = xml.readElementText();
+
+                else if(markerAttribute == "point")
+                {
+                    bool position = true;
+                    while(position && !xml.atEnd())
+                    {
+                        xml.readNext();
+                        elementName = xml.name().toString().toLower();
+
+                        if(xml.isEndElement() && elementName == "point")
+                        {
+                            position = false;
+                            continue;
+                        }
+                        else if(!xml.isStartElement())
+                            continue;
+
+                        QString positionAttribute = xml.name().toString().toLower();
+
+                        if(positionAttribute == "coordinates")
+                        {
+                            QString coordinateString = xml.readElementText();
+                            QList<QStringView> coordinateList = QStringView(coordinateString).split(',');
+
+                            if(coordinateList.count() == 2)
+                            {
+                                //wiggle has them backwards
+                                double x = 0;
+                                double y = 0;
+
+                                if(FieldParser::toDouble(coordinateList[1], x) == FieldParser::NoError &&
+                                   FieldParser::toDouble(coordinateList[0], y) == FieldParser::NoError)
+                                    data.coordinates = QGeoCoordinate(x, y);
+                                else
+                                    ++fieldErrors;
+                            }
+                        }
+                    }
+                }
+
+                else if(markerAttribute == "open")
+                {
+                    QString open = xml.readElementText();
+
+                    if(FieldParser::toInt(QStringView(open), data.open) != FieldParser::NoError)
+                        ++fieldErrors;
+                }
+            }
+
+            if(!result.error.isEmpty())
+                break;
+
+            widen(result, data.timestamp);
+
+            //placemarks without a usable point can't be placed on the map
+            if(!data.coordinates.isValid())
+            {
+                ++result.skipped;
+                continue;
+            }
+
+            ++result.rows;
+            stopped = !sink(data, device->pos());
+
+            if(++chunkRows == TraceChunkRows)
+            {
+                chunk.setCount(chunkRows);
+                chunk.restart();
+                chunkRows = 0;
+            }
+        }
+    }
+
+    chunk.setCount(chunkRows);
+    chunk.end();
+    span.setCount(result.rows);
+
+    if(xml.hasError())
+        qDebug() << xml.errorString();
+
+    qDebug() << "Parsed" << result.rows << "POIs";
+
+    if(fieldErrors)
+        qDebug() << fieldErrors << "numeric fields failed to parse";
+
+    if(result.skipped)
+        qDebug() << "Skipped" << result.skipped << "placemarks without a valid position";
+
+    return result;
+}
@@ -0,0 +1,52 @@
+#ifndef WIGLEPARSER_H
+#define WIGLEPARSER_H
+
+#include <QIODevice>
+#include <QString>
+
+#include <functional>
+
+struct LocationData;
+
+/*
+ * WiGLE CSV and KML readers
+ *
+ * The readers only turn a device into rows, they don't touch the model. Every row goes to the sink
+ * together with the device position after it, so any number of files can be read on their own threads
+ * and merged by whoever owns the sink.
+ *
+ * Field parse failures are counted and reported once the file is done. A timestamp that can't be read
+ * abandons the file, its rows up to there have already gone to the sink.
+ */
+class WigleParser
+{
+public:
+    enum Format
+    {
+        Unknown,
+        Csv,
+        Kml
+    };
+
+    struct Result
+    {
+        quint64 rows = 0;
+        quint64 skipped = 0; //rows without a valid position
+        qint64 first = 0; //earliest timestamp in ms since epoch
+        qint64 last = 0;
+        QString error; //empty unless the file was abandoned
+    };
+
+    static constexpr quint64 TraceChunkRows = 10000; //rows per parse span
+
+    //the row may be moved from, returning false stops the reader
+    using Sink = std::function<bool(LocationData &data, qint64 position)>;
+
+    static Format format(const QString &fileName);
+
+    static Result parse(QIODevice *device, Format format, const Sink &sink);
+    static Result parseCsv(QIODevice *device, const Sink &sink);
+    static Result parseKml(QIODevice *device, const Sink &sink);
+};
+
+#endif // WIGLEPARSER_H